@@ -5,7 +5,7 @@ set -e
 git submodule update --init --recursive
 mkdir -p build
 cd build
-cmake ..
+cmake .. "$@"
 make -j$(nproc)
 
 set +e
@@ -0,0 +1,1199 @@
+#include "benchmark.h"
+
+#include <SDL3/SDL.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/app_state.h"
+#include "entities/circle.h"
+#include "entities/isometric_cube/isometric_cube.h"
+#include "entities/line.h"
+#include "entities/waypoint.h"
+#include "event_loop.h"
+#include "systems/animation_system.h"
+#include "systems/audio_binding_system.h"
+#include "systems/audio_input.h"
+#include "systems/audio_system.h"
+#include "systems/filterbank.h"
+#include "systems/job_system.h"
+#include "systems/spectral_analyzer.h"
+#include "systems/tempo_tracker.h"
+#include "systems/tween_system.h"
+#include "utils/allocation_counter.h"
+
+namespace {
+
+// Per-call timings of one micro-benchmarked kernel, in microseconds
+struct KernelSamples {
+  std::string name;
+  std::vector<float> samples;
+
+  // Heap allocations made across the timed calls. The run fails if this is
+  // non-zero for a kernel that must not allocate. Always 0 unless
+  // ALLOCATION_COUNTING.
+  uint64_t allocations;
+  bool mustNotAllocate;
+};
+
+struct Scenario {
+  const char* name;
+  const char* description;
+  std::function<void(AppState&, const BenchmarkOptions&)> spawn;
+
+  // Set for micro-benchmarks that time kernels directly instead of frames.
+  // Returns false if a kernel's output failed verification.
+  std::function<bool(const BenchmarkOptions&, std::vector<KernelSamples>&)>
+      kernels;
+};
+
+SDL_FPoint getWindowCenter(AppState& appState) {
+  int windowWidth, windowHeight;
+  SDL_GetWindowSize(appState.context->window, &windowWidth, &windowHeight);
+  return {windowWidth / 2.0f, windowHeight / 2.0f};
+}
+
+void spawnWaypoints(AppState& appState, const BenchmarkOptions& options) {
+  EntityManager& entityManager = appState.entityManager;
+  SDL_FPoint center = getWindowCenter(appState);
+
+  for (int i = 0; i < options.waypoints; i++) {
+    auto* waypoint = entityManager.get(
+        entityManager.createEntity<WaypointEntity>(&appState));
+    waypoint->setInitialPosition(center.x, center.y);
+  }
+}
+
+// The same waypoints as spawnWaypoints, in archetype storage
+void spawnArchetypeWaypoints(AppState& appState,
+                             const BenchmarkOptions& options) {
+  WaypointArchetype& waypoints = appState.entityManager.getWaypoints();
+  SDL_FPoint center = getWindowCenter(appState);
+
+  waypoints.reserve(waypoints.size() + options.waypoints);
+  for (int i = 0; i < options.waypoints; i++) {
+    waypoints.spawn(center.x, center.y);
+  }
+}
+
+void spawnGrid(AppState& appState, const BenchmarkOptions& options) {
+  appState.entityManager.getCubes().spawnGrid(getWindowCenter(appState),
+                                              options.gridSide);
+}
+
+// The same grid as spawnGrid, one IsometricCubeEntity per cube
+void spawnEntityGrid(AppState& appState, const BenchmarkOptions& options) {
+  EntityManager& entityManager = appState.entityManager;
+  SDL_FPoint rowStart = getWindowCenter(appState);
+
+  for (int r = 0; r < options.gridSide; r++) {
+    auto* first = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(&appState));
+    first->setTime(r * 75.0f);
+    first->setPosition(rowStart);
+
+    SDL_FPoint colPos = first->getBehindLeft();
+    for (int c = 1; c < options.gridSide; c++) {
+      auto* cube = entityManager.get(
+          entityManager.createEntity<IsometricCubeEntity>(&appState));
+      cube->setTime((r + c) * 75.0f);
+      cube->setPosition(colPos);
+      colPos = cube->getBehindLeft();
+    }
+
+    rowStart = first->getBehindRight();
+  }
+}
+
+void spawnGradientLines(AppState& appState, const BenchmarkOptions& options) {
+  EntityManager& entityManager = appState.entityManager;
+
+  int windowWidth, windowHeight;
+  SDL_GetWindowSize(appState.context->window, &windowWidth, &windowHeight);
+
+  const std::vector<SDL_Color> gradientColors = {
+      {255, 0, 0, 255},   {255, 165, 0, 255}, {255, 255, 0, 255},
+      {0, 255, 0, 255},   {0, 0, 255, 255},   {128, 0, 128, 255},
+      {255, 0, 255, 255}};
+
+  for (int i = 0; i < options.lines; i++) {
+    auto lineHandle = entityManager.createEntity<LineEntity>(
+        SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight},
+        SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight});
+
+    auto gradientAnim = std::make_shared<GradientAnimation>(
+        10.0f, lineHandle, gradientColors);
+    gradientAnim->setLooping(true);
+    gradientAnim->setColorTransitionDuration(1.5f);
+    appState.animationSystem->addAnimation(
+        gradientAnim, bindProperty<&LineEntity::setAnimatedColor>(lineHandle));
+  }
+}
+
+// Nearest-rank percentile of an unsorted sample
+float percentile(std::vector<float> samples, float p) {
+  if (samples.empty()) return 0.0f;
+
+  std::sort(samples.begin(), samples.end());
+  size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+  return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+// Time `iterations` calls of fn after `warmup` untimed ones
+template <typename Fn>
+void timeKernel(const BenchmarkOptions& options, KernelSamples& kernel,
+                Fn&& fn) {
+  for (int i = 0; i < options.warmupFrames; i++) {
+    fn();
+  }
+
+  const double usPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+  kernel.samples.reserve(options.frames);
+
+  uint64_t allocationsBefore = getThreadAllocationCount();
+  for (int i = 0; i < options.frames; i++) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    fn();
+    kernel.samples.push_back(static_cast<float>(
+        (SDL_GetPerformanceCounter() - start) * usPerTick));
+  }
+  kernel.allocations = getThreadAllocationCount() - allocationsBefore;
+}
+
+// Picking has to keep up with the mouse at any entity count
+const float PICK_BUDGET_US = 50.0f;
+
+// Spatial index queries over 100k circles spread across a 1080p window: a
+// point query per click, and a cursor-sized rect query
+bool benchPick(const BenchmarkOptions& options,
+               std::vector<KernelSamples>& kernels) {
+  const int entityCount = 100000;
+  const float width = 1920.0f;
+  const float height = 1080.0f;
+
+  EntityManager entityManager(nullptr);
+  for (int i = 0; i < entityCount; i++) {
+    entityManager.createEntity<CircleEntity>(
+        SDL_FPoint{SDL_randf() * width, SDL_randf() * height},
+        2.0f + SDL_randf() * 8.0f);
+  }
+
+  std::vector<Entity*> found;
+  found.reserve(1024);
+
+  kernels.push_back({"pick_point_100k", {}, 0, false});
+  timeKernel(options, kernels.back(), [&] {
+    found.clear();
+    entityManager.queryPoint({SDL_randf() * width, SDL_randf() * height},
+                             found);
+  });
+
+  kernels.push_back({"pick_rect_100k", {}, 0, false});
+  timeKernel(options, kernels.back(), [&] {
+    float x = SDL_randf() * width;
+    float y = SDL_randf() * height;
+    found.clear();
+    entityManager.queryRect(BoundingBox(x, y, x + 32.0f, y + 32.0f), found);
+  });
+
+  bool verified = true;
+  for (const KernelSamples& kernel : kernels) {
+    float p99 = percentile(kernel.samples, 0.99f);
+    if (p99 >= PICK_BUDGET_US) {
+      SPDLOG_ERROR("{} p99 is {} us, over the {} us budget", kernel.name, p99,
+                   PICK_BUDGET_US);
+      verified = false;
+    }
+  }
+  return verified;
+}
+
+// --threads, or every hardware thread
+size_t getThreadCount(const BenchmarkOptions& options) {
+  return options.threads > 0
+             ? static_cast<size_t>(options.threads)
+             : JobSystem::defaultWorkerCount() + 1;
+}
+
+// One EntityManager::update of a million archetype cubes, on a pool of 1,
+// 2, 4 ... up to --threads threads, to show how the update scales
+bool benchScaling(const BenchmarkOptions& options,
+                  std::vector<KernelSamples>& kernels) {
+  const int side = 1000;
+  const size_t maxThreads = getThreadCount(options);
+
+  EntityManager entityManager(nullptr);
+  entityManager.getCubes().spawnGrid({960.0f, 540.0f}, side);
+
+  std::vector<size_t> threadCounts;
+  for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+    threadCounts.push_back(threads);
+  }
+  threadCounts.push_back(maxThreads);
+
+  float serialP50 = 0.0f;
+  for (size_t threads : threadCounts) {
+    JobSystem jobSystem(threads - 1);
+    entityManager.setJobSystem(&jobSystem);
+
+    kernels.push_back(
+        {"update_1m_cubes_" + std::to_string(threads) + "_threads", {}, 0,
+         false});
+    timeKernel(options, kernels.back(),
+               [&] { entityManager.update(options.deltaTime); });
+    entityManager.setJobSystem(nullptr);
+
+    float p50 = percentile(kernels.back().samples, 0.50f);
+    if (threads == 1) serialP50 = p50;
+    SPDLOG_INFO("{} threads: {:.0f} us, {:.2f}x one thread", threads, p50,
+                p50 > 0.0f ? serialP50 / p50 : 0.0f);
+  }
+  return true;
+}
+
+const int FFT_SIZES[] = {512, 1024, 2048, 4096, 8192};
+
+bool benchFFTSizes(const BenchmarkOptions& options,
+                   std::vector<KernelSamples>& kernels) {
+  AudioSystem audioSystem;
+
+  for (int size : FFT_SIZES) {
+    audioSystem.setFFTSize(size);
+
+    std::vector<float> buffer(size);
+    for (float& sample : buffer) {
+      sample = SDL_randf() * 2.0f - 1.0f;
+    }
+
+    kernels.push_back({"fft_" + std::to_string(size), {}, 0, true});
+    timeKernel(options, kernels.back(),
+               [&] { audioSystem.performFFT(buffer); });
+  }
+  return true;
+}
+
+// The whole steady-state analysis step: FFT, bands, flux, beat detection,
+// for a mono and a stereo source
+bool benchAnalysis(const BenchmarkOptions& options,
+                   std::vector<KernelSamples>& kernels) {
+  AudioSystem audioSystem;
+
+  // A few seconds of noise, analyzed one hop at a time
+  const size_t hopSize = 512;
+  std::vector<float> signal(44100 * 4);
+  for (float& sample : signal) {
+    sample = SDL_randf() * 2.0f - 1.0f;
+  }
+
+  for (int size : FFT_SIZES) {
+    audioSystem.setFFTSize(size);
+
+    size_t offset = 0;
+    kernels.push_back({"analysis_" + std::to_string(size), {}, 0, true});
+    timeKernel(options, kernels.back(), [&] {
+      audioSystem.analyzeSamples(signal.data() + offset, size);
+      offset = (offset + hopSize) % (signal.size() - size);
+    });
+  }
+
+  // The same signal on the left, half shared and half independent noise on
+  // the right, through both channel transforms at once
+  std::vector<float> right(signal.size());
+  for (size_t i = 0; i < right.size(); ++i) {
+    right[i] = 0.5f * signal[i] + 0.5f * (SDL_randf() * 2.0f - 1.0f);
+  }
+
+  for (int size : FFT_SIZES) {
+    audioSystem.setFFTSize(size);
+
+    size_t offset = 0;
+    kernels.push_back(
+        {"analysis_stereo_" + std::to_string(size), {}, 0, true});
+    timeKernel(options, kernels.back(), [&] {
+      audioSystem.analyzeStereoSamples(signal.data() + offset,
+                                       right.data() + offset, size);
+      offset = (offset + hopSize) % (signal.size() - size);
+    });
+  }
+  return true;
+}
+
+// Live input: a hop of generated frames at a time through the capture ring
+// and the sliding stereo window. Also runs the generator on its own thread
+// for a moment, as a live input, and checks the analysis heard it.
+bool benchCapture(const BenchmarkOptions& options,
+                  std::vector<KernelSamples>& kernels) {
+  AudioSystem audioSystem;
+  GeneratorSource generator;
+  std::vector<StereoFrame> hop(audioSystem.getAnalysisHopSize());
+
+  for (int size : FFT_SIZES) {
+    audioSystem.setFFTSize(size);
+
+    kernels.push_back({"capture_" + std::to_string(size), {}, 0, true});
+    timeKernel(options, kernels.back(), [&] {
+      generator.generate(hop.data(), hop.size());
+      audioSystem.analyzeCapturedFrames(hop.data(), hop.size());
+    });
+  }
+
+  audioSystem.setFFTSize(2048);
+  if (!audioSystem.setInput(AudioInput::Generator)) {
+    SPDLOG_ERROR("Couldn't start the test generator: {}",
+                 audioSystem.getInputError());
+    return false;
+  }
+
+  // The hats are panned right, so the image should never read as mono
+  double loudestBass = 0.0;
+  double widest = 0.0;
+  for (int i = 0; i < 100; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    audioSystem.updateVisualizationData();
+    const auto& data = audioSystem.getVisualizationData();
+    loudestBass = std::max(loudestBass, data.bassLevel);
+    widest = std::max(widest, data.stereoWidth);
+  }
+  uint64_t dropped = audioSystem.getDroppedCaptureFrames();
+  audioSystem.setInput(AudioInput::File);
+
+  if (loudestBass <= 0.0 || widest <= 0.0 || dropped > 0) {
+    SPDLOG_ERROR("Live generator input: bass {}, width {}, {} frames dropped",
+                 loudestBass, widest, dropped);
+    return false;
+  }
+  return true;
+}
+
+// The multi-pass spectral feature code SpectralAnalyzer replaced, kept as
+// the reference its kernels are checked against
+void computeLegacySpectralFeatures(const std::vector<double>& magnitudes,
+                                   const std::vector<double>& lastMagnitudes,
+                                   const std::vector<double>& frequencies,
+                                   SpectralFeatures& features) {
+  const double bandUpperHz[] = {250.0, 500.0, 2000.0, 4000.0};
+
+  double maxMagnitude = 0.0;
+  for (size_t i = 1; i < magnitudes.size(); ++i) {
+    maxMagnitude = std::max(maxMagnitude, magnitudes[i]);
+  }
+
+  double bandSums[SpectralFeatures::BAND_COUNT] = {};
+  int bandCounts[SpectralFeatures::BAND_COUNT] = {};
+  for (size_t i = 1; i < frequencies.size(); ++i) {
+    int band = 0;
+    while (band < 4 && frequencies[i] > bandUpperHz[band]) band++;
+    bandSums[band] += maxMagnitude > 0.0 ? magnitudes[i] / maxMagnitude : 0.0;
+    bandCounts[band]++;
+  }
+  for (int band = 0; band < SpectralFeatures::BAND_COUNT; ++band) {
+    double level = bandCounts[band] > 0 ? bandSums[band] / bandCounts[band]
+                                        : 0.0;
+    features.bandLevels[band] = std::clamp(level, 0.0, 1.0);
+  }
+
+  features.flux = 0.0;
+  for (size_t i = 0; i < magnitudes.size(); ++i) {
+    if (frequencies[i] < 30.0 || frequencies[i] > 4000.0) continue;
+    double diff = std::log1p(magnitudes[i]) - std::log1p(lastMagnitudes[i]);
+    if (diff > 0.0) features.flux += diff;
+  }
+
+  double weightedSum = 0.0;
+  double magnitudeSum = 0.0;
+  for (size_t i = 0; i < magnitudes.size(); ++i) {
+    weightedSum += frequencies[i] * magnitudes[i];
+    magnitudeSum += magnitudes[i];
+  }
+  features.centroid = magnitudeSum > 0 ? weightedSum / magnitudeSum : 0.0;
+
+  double totalEnergy = 0.0;
+  for (double magnitude : magnitudes) {
+    totalEnergy += magnitude * magnitude;
+  }
+  double currentEnergy = 0.0;
+  features.rolloff = 0.0;
+  for (size_t i = 0; i < magnitudes.size(); ++i) {
+    currentEnergy += magnitudes[i] * magnitudes[i];
+    if (currentEnergy >= 0.85 * totalEnergy) {
+      features.rolloff = frequencies[i];
+      break;
+    }
+  }
+}
+
+bool nearlyEqual(double a, double b) {
+  return std::abs(a - b) <= 1e-9 * std::max({1.0, std::abs(a), std::abs(b)});
+}
+
+// Summation order differs between kernels, so allow reassociation error;
+// the rolloff may land one bin over when the crossing is that close
+bool matchesReference(const SpectralFeatures& features,
+                      const SpectralFeatures& reference, double binHz) {
+  for (int band = 0; band < SpectralFeatures::BAND_COUNT; ++band) {
+    if (!nearlyEqual(features.bandLevels[band], reference.bandLevels[band])) {
+      return false;
+    }
+  }
+  return nearlyEqual(features.centroid, reference.centroid) &&
+         nearlyEqual(features.flux, reference.flux) &&
+         std::abs(features.rolloff - reference.rolloff) <= binHz;
+}
+
+// Falling 1/f-ish noise, roughly the shape of a music spectrum
+void fillTestSpectrum(std::vector<double>& magnitudes) {
+  for (size_t i = 0; i < magnitudes.size(); ++i) {
+    magnitudes[i] = SDL_randf() * 100.0 / (1.0 + 0.05 * i);
+  }
+}
+
+bool benchSpectralFeatures(const BenchmarkOptions& options,
+                           std::vector<KernelSamples>& kernels) {
+  const int sampleRate = 44100;
+  bool verified = true;
+
+  for (int size : FFT_SIZES) {
+    size_t bins = size / 2;
+    std::vector<double> frequencies(bins);
+    for (size_t i = 0; i < bins; ++i) {
+      frequencies[i] = static_cast<double>(i) * sampleRate / size;
+    }
+
+    std::vector<double> previous(bins);
+    std::vector<double> current(bins);
+    fillTestSpectrum(previous);
+    fillTestSpectrum(current);
+
+    SpectralFeatures reference;
+    computeLegacySpectralFeatures(current, previous, frequencies, reference);
+
+    kernels.push_back(
+        {"spectral_legacy_" + std::to_string(size), {}, 0, false});
+    timeKernel(options, kernels.back(), [&] {
+      computeLegacySpectralFeatures(current, previous, frequencies,
+                                    reference);
+    });
+
+    for (SpectralKernel kernel :
+         {SpectralKernel::Scalar, SpectralKernel::SSE2, SpectralKernel::AVX2,
+          SpectralKernel::NEON}) {
+      SpectralAnalyzer analyzer;
+      if (!analyzer.setKernel(kernel)) continue;
+      analyzer.configure(frequencies.data(), bins);
+
+      std::string name = SpectralAnalyzer::getKernelName(kernel);
+      std::transform(name.begin(), name.end(), name.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+
+      // Flux is measured against the previous call
+      SpectralFeatures features;
+      analyzer.compute(previous.data(), features);
+      analyzer.compute(current.data(), features);
+      if (!matchesReference(features, reference, frequencies[1])) {
+        SPDLOG_ERROR("Spectral kernel {} disagrees with the reference at "
+                     "FFT size {}",
+                     SpectralAnalyzer::getKernelName(kernel), size);
+        verified = false;
+      }
+
+      kernels.push_back({"spectral_" + name + "_" + std::to_string(size),
+                         {}, 0, true});
+      timeKernel(options, kernels.back(),
+                 [&] { analyzer.compute(current.data(), features); });
+
+      // The bands-only path used for each side of a stereo source
+      SpectralFeatures bands = reference;
+      analyzer.computeBands(current.data(), bands.bandLevels);
+      if (!matchesReference(bands, reference, frequencies[1])) {
+        SPDLOG_ERROR("Spectral kernel {} bands disagree with the reference "
+                     "at FFT size {}",
+                     SpectralAnalyzer::getKernelName(kernel), size);
+        verified = false;
+      }
+
+      kernels.push_back(
+          {"spectral_bands_" + name + "_" + std::to_string(size), {}, 0,
+           true});
+      timeKernel(options, kernels.back(), [&] {
+        analyzer.computeBands(current.data(), features.bandLevels);
+      });
+    }
+  }
+
+  return verified;
+}
+
+// Filterbank mat-vec at the largest FFT size, for each band count and scale
+bool benchFilterbank(const BenchmarkOptions& options,
+                     std::vector<KernelSamples>& kernels) {
+  const int sampleRate = 44100;
+  const int size = 8192;
+  bool verified = true;
+
+  size_t bins = size / 2;
+  std::vector<double> frequencies(bins);
+  for (size_t i = 0; i < bins; ++i) {
+    frequencies[i] = static_cast<double>(i) * sampleRate / size;
+  }
+
+  // Full scale for a Hann-windowed FFT, and 30 dB below it
+  const double fullScale = size / 4.0;
+  std::vector<double> flat(bins, fullScale);
+  std::vector<double> quiet(bins, fullScale * std::pow(10.0, -30.0 / 20.0));
+  std::vector<double> magnitudes(bins);
+  fillTestSpectrum(magnitudes);
+  std::vector<float> levels(Filterbank::MAX_BANDS);
+
+  for (FilterbankScale scale : {FilterbankScale::Log, FilterbankScale::Mel}) {
+    for (int bandCount : {16, 64, 256}) {
+      Filterbank filterbank;
+      filterbank.configure(frequencies.data(), bins, bandCount, scale, 20.0,
+                           20000.0);
+
+      // Bands are weighted means, so a flat spectrum is equally loud in all,
+      // and levels are against full scale, so 30 dB down reads halfway
+      struct Check {
+        const std::vector<double>& spectrum;
+        float expected;
+      };
+      for (const Check& check : {Check{flat, 1.0f}, Check{quiet, 0.5f}}) {
+        filterbank.apply(check.spectrum.data(), levels.data());
+        for (int b = 0; b < bandCount; ++b) {
+          if (std::abs(levels[b] - check.expected) > 1e-4f) {
+            SPDLOG_ERROR("{} filterbank with {} bands: band {} reads {} on a "
+                         "flat spectrum that should read {}",
+                         Filterbank::getScaleName(scale), bandCount, b,
+                         levels[b], check.expected);
+            verified = false;
+            break;
+          }
+        }
+      }
+
+      std::string name = Filterbank::getScaleName(scale);
+      std::transform(name.begin(), name.end(), name.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+      kernels.push_back({"filterbank_" + name + "_" + std::to_string(bandCount),
+                         {}, 0, true});
+      timeKernel(options, kernels.back(), [&] {
+        filterbank.apply(magnitudes.data(), levels.data());
+      });
+    }
+  }
+
+  return verified;
+}
+
+// An onset envelope at `bpm` with one-hop spikes on the beats, low noise
+// between them and off-beat distractors, one value per hop
+std::vector<double> makeOnsetTrain(double bpm, double hopRate, size_t hops) {
+  const double period = 60.0 * hopRate / bpm;
+  std::vector<double> envelope(hops);
+  for (size_t hop = 0; hop < hops; ++hop) {
+    double sinceBeat = std::fmod(static_cast<double>(hop), period);
+    bool onBeat = sinceBeat < 0.5 || period - sinceBeat <= 0.5;
+    envelope[hop] = onBeat ? 10.0 : SDL_randf();
+    if (hop % 7 == 0) envelope[hop] += 3.0 * SDL_randf();
+  }
+  return envelope;
+}
+
+// TempoTracker::push per hop, on onset trains at a few tempos. Each tracker
+// is first run for a while to check it finds the tempo, and that the beats
+// it predicts land on the true ones.
+bool benchTempo(const BenchmarkOptions& options,
+                std::vector<KernelSamples>& kernels) {
+  const double hopRate = 44100.0 / 512;
+  bool verified = true;
+
+  for (double bpm : {90.0, 120.0, 150.0}) {
+    const double period = 60.0 * hopRate / bpm;
+    std::vector<double> envelope =
+        makeOnsetTrain(bpm, hopRate, static_cast<size_t>(40 * hopRate));
+
+    TempoTracker tracker;
+    tracker.configure(hopRate);
+
+    // Give it the first half to settle, then score the second
+    int predicted = 0;
+    int onTime = 0;
+    for (size_t hop = 0; hop < envelope.size(); ++hop) {
+      bool beat = tracker.push(envelope[hop]);
+      if (!beat || hop < envelope.size() / 2) continue;
+
+      predicted++;
+      double error = std::remainder(static_cast<double>(hop), period);
+      if (std::abs(error) <= 1.0) onTime++;
+    }
+
+    if (std::abs(tracker.getTempo() - bpm) > 2.0 ||
+        onTime < predicted * 9 / 10 || predicted == 0) {
+      SPDLOG_ERROR("Tempo tracker at {} BPM read {:.2f} BPM, {} of {} "
+                   "predicted beats on time",
+                   bpm, tracker.getTempo(), onTime, predicted);
+      verified = false;
+    }
+
+    size_t hop = 0;
+    kernels.push_back(
+        {"tempo_" + std::to_string(static_cast<int>(bpm)), {}, 0, true});
+    timeKernel(options, kernels.back(), [&] {
+      tracker.push(envelope[hop]);
+      hop = (hop + 1) % envelope.size();
+    });
+  }
+
+  return verified;
+}
+
+// One binding pass over about 100k cubes and 100k waypoints: wave height
+// from the bass, cube color from the filterbank and waypoint color from
+// beats. Also checks the envelopes reach and leave their targets.
+bool benchBindings(const BenchmarkOptions& options,
+                   std::vector<KernelSamples>& kernels) {
+  const float deltaTime = 1.0f / 60.0f;
+  bool verified = true;
+
+  EntityManager entityManager(nullptr);
+  IsometricCubeArchetype& cubes = entityManager.getCubes();
+  WaypointArchetype& waypoints = entityManager.getWaypoints();
+  cubes.spawnGrid({0.0f, 0.0f}, 317);
+  waypoints.reserve(100000);
+  for (int i = 0; i < 100000; i++) {
+    waypoints.spawn(0.0f, 0.0f);
+  }
+
+  AudioBindingSystem bindings(entityManager);
+
+  AudioBinding wave;
+  wave.feature = AudioFeature::Bass;
+  wave.target = BindingTarget::CubeWaveAmplitude;
+  wave.envelope = {0.05f, 0.02f, 0.3f};
+  wave.low = 5.0f;
+  wave.high = 60.0f;
+  bindings.addBinding(wave);
+
+  AudioBinding bands;
+  bands.feature = AudioFeature::Filterbank;
+  bands.target = BindingTarget::CubeColor;
+  bands.envelope = {0.0f, 0.01f, 0.2f};
+  bindings.addBinding(bands);
+
+  AudioBinding flash;
+  flash.feature = AudioFeature::Beat;
+  flash.target = BindingTarget::WaypointColor;
+  flash.envelope = {0.0f, 0.0f, 0.25f};
+  bindings.addBinding(flash);
+
+  // Loud bass, a rising filterbank and a beat every step, held for two
+  // seconds
+  AudioSystem::VisualizationData data;
+  data.bassLevel = 1.0;
+  data.isBeat = true;
+  data.filterbankBandCount = 64;
+  for (int band = 0; band < data.filterbankBandCount; band++) {
+    data.filterbankLevels[band] =
+        static_cast<float>(band) / (data.filterbankBandCount - 1);
+  }
+  for (int i = 0; i < 120; i++) {
+    data.lastBeatMs += 16;
+    bindings.update(data, deltaTime);
+  }
+
+  const size_t last = cubes.size() - 1;
+  if (std::abs(cubes.waveDy[0] - 60.0f) > 0.5f ||
+      std::abs(cubes.waveDy[last] - 60.0f) > 0.5f ||
+      cubes.color[0].r > 0.01f || cubes.color[last].r < 0.99f ||
+      waypoints.color[0].r != 255 ||
+      bindings.getLastBoundCount() != 2 * cubes.size() + waypoints.size()) {
+    SPDLOG_ERROR("Bindings didn't reach their targets: wave {} to {}, cube "
+                 "red {} to {}, waypoint red {}",
+                 cubes.waveDy[0], cubes.waveDy[last], cubes.color[0].r,
+                 cubes.color[last].r, waypoints.color[0].r);
+    verified = false;
+  }
+
+  // Then silence: everything falls back to its low end
+  data.bassLevel = 0.0;
+  data.isBeat = false;
+  for (int i = 0; i < 180; i++) {
+    bindings.update(data, deltaTime);
+  }
+  if (cubes.waveDy[0] > 5.5f || waypoints.color[0].r != 0) {
+    SPDLOG_ERROR("Bindings didn't release: wave {}, waypoint red {}",
+                 cubes.waveDy[0], waypoints.color[0].r);
+    verified = false;
+  }
+
+  // One beat whose snapshot is read on two fixed steps fires only once
+  data.isBeat = true;
+  data.lastBeatMs += 1000;
+  bindings.update(data, deltaTime);
+  const Uint8 beatRed = waypoints.color[0].r;
+  bindings.update(data, deltaTime);
+  if (beatRed != 255 || waypoints.color[0].r == 255) {
+    SPDLOG_ERROR("Beat fired wrongly: waypoint red {} then {}", beatRed,
+                 waypoints.color[0].r);
+    verified = false;
+  }
+  data.isBeat = false;
+
+  // Timed with the bass and beats coming and going
+  int call = 0;
+  kernels.push_back({"bindings_" + std::to_string(bindings.getLastBoundCount()),
+                     {}, 0, true});
+  timeKernel(options, kernels.back(), [&] {
+    data.bassLevel = (call / 30) % 2 ? 1.0 : 0.2;
+    data.isBeat = call % 30 == 0;
+    if (data.isBeat) data.lastBeatMs += 500;
+    bindings.update(data, deltaTime);
+    call++;
+  });
+
+  return verified;
+}
+
+// Checks sequencing, parallel groups, looping and stopping on a few tracks,
+// sampled at known times
+bool verifyTweens() {
+  const float step = 0.01f;
+  auto near = [](float a, float b) { return std::abs(a - b) < 1e-3f; };
+
+  TweenSystem tweens;
+  float value = -1.0f;
+  SDL_FPoint point = {0.0f, 0.0f};
+  SDL_FColor color = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  // Up and back down on one target, alongside a point and a stepped color
+  TweenGroup upAndDown =
+      TweenGroup::sequence()
+          .add(&value, {{0.0f, 0.0f}, {1.0f, 10.0f}})
+          .add(&value, {{0.0f, 10.0f}, {1.0f, 0.0f, Easing::QuadIn}});
+  TweenGroup group =
+      TweenGroup::parallel()
+          .add(upAndDown)
+          .add(&point, {{0.0f, {0.0f, 0.0f}}, {2.0f, {4.0f, 8.0f}}})
+          .add(&color, {{0.0f, {0.0f, 0.0f, 0.0f, 1.0f}},
+                        {1.0f, {1.0f, 1.0f, 1.0f, 1.0f}, Easing::Step}});
+  TweenSystem::TweenId id = tweens.play(group);
+
+  for (int i = 0; i < 50; i++) tweens.update(step);
+  bool halfway = near(value, 5.0f) && near(point.x, 1.0f) &&
+                 near(point.y, 2.0f) && color.r == 0.0f;
+
+  for (int i = 0; i < 100; i++) tweens.update(step);
+  bool onTheWayDown = near(value, 7.5f) && color.r == 1.0f;
+
+  for (int i = 0; i < 60; i++) tweens.update(step);
+  bool finished = value == 0.0f && point.x == 4.0f && !tweens.isPlaying(id) &&
+                  tweens.getTrackCount() == 0;
+
+  // A second long ramp, then a second's rest, over and over until stopped
+  float looped = -1.0f;
+  TweenSystem::TweenId loop = tweens.play(
+      TweenGroup::sequence().add(&looped, {{0.0f, 0.0f}, {1.0f, 1.0f}})
+          .delay(1.0f),
+      true);
+  for (int i = 0; i < 250; i++) tweens.update(step);
+  bool looping = near(looped, 0.5f) && tweens.isPlaying(loop);
+
+  for (int i = 0; i < 80; i++) tweens.update(step);
+  bool resting = looped == 1.0f;
+
+  tweens.stop(loop);
+  tweens.update(0.5f);
+  bool stopped = looped == 1.0f && !tweens.isPlaying(loop) &&
+                 tweens.getTrackCount() == 0;
+
+  // Single keys set their value once reached, at the start and after a
+  // delay
+  float setNow = -1.0f;
+  float setLater = -1.0f;
+  tweens.play(TweenGroup::sequence()
+                  .add(&setNow, {{0.0f, 5.0f}})
+                  .delay(0.5f)
+                  .add(&setLater, {{0.0f, 7.0f}}));
+  tweens.update(step);
+  bool singleKeys = setNow == 5.0f && setLater == -1.0f;
+  for (int i = 0; i < 60; i++) tweens.update(step);
+  singleKeys = singleKeys && setLater == 7.0f && tweens.getTrackCount() == 0;
+
+  if (!halfway || !onTheWayDown || !finished || !looping || !resting ||
+      !stopped || !singleKeys) {
+    SPDLOG_ERROR("Tweens went wrong: halfway {}, on the way down {}, "
+                 "finished {}, looping {}, resting {}, stopped {}, single "
+                 "keys {}",
+                 halfway, onTheWayDown, finished, looping, resting, stopped,
+                 singleKeys);
+    return false;
+  }
+  return true;
+}
+
+// One update of a million looping tracks: 700k floats in two-step
+// sequences, 200k points and 100k colors, with a mix of easings
+bool benchTweens(const BenchmarkOptions& options,
+                 std::vector<KernelSamples>& kernels) {
+  bool verified = verifyTweens();
+
+  const Easing easings[] = {Easing::Linear, Easing::QuadInOut,
+                            Easing::SineInOut, Easing::BackOut};
+  std::vector<float> values(700000);
+  std::vector<SDL_FPoint> points(200000);
+  std::vector<SDL_FColor> colors(100000);
+
+  TweenSystem tweens;
+  for (size_t i = 0; i < values.size(); i += 2) {
+    float peak = 0.5f + (i % 7) * 0.1f;
+    tweens.play(
+        TweenGroup::sequence()
+            .add(&values[i],
+                 {{0.0f, 0.0f}, {peak, 1.0f, easings[i % 4]}, {1.5f, 0.0f}})
+            .add(&values[i + 1],
+                 {{0.0f, 0.0f}, {1.0f, 5.0f, easings[(i / 2) % 4]}}),
+        true);
+  }
+  for (size_t i = 0; i < points.size(); i++) {
+    tweens.play(TweenGroup::parallel().add(
+                    &points[i], {{0.0f, {0.0f, 0.0f}},
+                                 {1.0f + (i % 5) * 0.2f, {10.0f, 10.0f},
+                                  easings[i % 4]}}),
+                true);
+  }
+  for (size_t i = 0; i < colors.size(); i++) {
+    tweens.play(TweenGroup::parallel().add(
+                    &colors[i], {{0.0f, {0.0f, 0.0f, 0.0f, 1.0f}},
+                                 {0.7f, {1.0f, 0.0f, 0.0f, 1.0f}},
+                                 {1.4f, {0.0f, 0.0f, 1.0f, 1.0f},
+                                  Easing::SineInOut}}),
+                true);
+  }
+
+  kernels.push_back({"tweens_" + std::to_string(tweens.getTrackCount()), {},
+                     0, true});
+  timeKernel(options, kernels.back(), [&] { tweens.update(1.0f / 60.0f); });
+
+  return verified;
+}
+
+const std::vector<Scenario>& getScenarios() {
+  static const std::vector<Scenario> scenarios = {
+      {"waypoints",
+       "--waypoints N waypoint entities, paired with waypoints_archetype",
+       spawnWaypoints, nullptr},
+      {"grid",
+       "isometric cube grid wave of side --grid S in archetype storage, "
+       "paired with grid_entities",
+       spawnGrid, nullptr},
+      {"waypoints_archetype", "--waypoints N waypoints in archetype storage",
+       spawnArchetypeWaypoints, nullptr},
+      {"grid_entities", "cube grid wave of side --grid S as entities",
+       spawnEntityGrid, nullptr},
+      {"lines", "--lines M lines with looping gradient animations",
+       spawnGradientLines, nullptr},
+      {"mixed", "waypoints, grid and lines together",
+       [](AppState& appState, const BenchmarkOptions& options) {
+         spawnWaypoints(appState, options);
+         spawnGrid(appState, options);
+         spawnGradientLines(appState, options);
+       },
+       nullptr},
+      {"scaling", "update of 1M cubes on 1, 2, 4 ... --threads N threads",
+       nullptr, benchScaling},
+      {"pick", "spatial index point and rect queries over 100k entities",
+       nullptr, benchPick},
+      {"fft", "AudioSystem::performFFT at each FFT size (512 to 8192)",
+       nullptr, benchFFTSizes},
+      {"analysis", "full audio analysis step at each FFT size",
+       nullptr, benchAnalysis},
+      {"spectral", "spectral feature kernels vs. the legacy multi-pass code",
+       nullptr, benchSpectralFeatures},
+      {"filterbank", "log and mel filterbanks of 16 to 256 bands at FFT 8192",
+       nullptr, benchFilterbank},
+      {"capture", "live input through the capture ring at each FFT size",
+       nullptr, benchCapture},
+      {"tempo", "tempo tracker per hop on onset trains at 90 to 150 BPM",
+       nullptr, benchTempo},
+      {"bindings", "audio bindings over 100k cubes and 100k waypoints",
+       nullptr, benchBindings},
+      {"tweens", "one update of a million looping keyframe tweens",
+       nullptr, benchTweens},
+  };
+  return scenarios;
+}
+
+const Scenario* findScenario(const std::string& name) {
+  for (const Scenario& scenario : getScenarios()) {
+    if (name == scenario.name) return &scenario;
+  }
+  return nullptr;
+}
+
+struct PhaseSamples {
+  const char* name;
+  float FrameTimings::* field;
+  std::vector<float> samples;
+};
+
+bool parseInt(const char* text, int& out) {
+  char* end = nullptr;
+  long value = std::strtol(text, &end, 10);
+  if (end == text || *end != '\0' || value < 0) return false;
+  out = static_cast<int>(value);
+  return true;
+}
+
+// Kernel scenarios: --frames and --warmup count calls instead of frames
+int runKernelBenchmark(const Scenario& scenario,
+                       const BenchmarkOptions& options) {
+  std::vector<KernelSamples> kernels;
+  bool verified = scenario.kernels(options, kernels);
+
+  std::ofstream out(options.outputPath);
+  if (!out) {
+    SPDLOG_ERROR("Couldn't open {} for writing", options.outputPath);
+    return 1;
+  }
+
+  out << "{\n";
+  out << "  \"scenario\": \"" << scenario.name << "\",\n";
+  out << "  \"iterations\": " << options.frames << ",\n";
+  out << "  \"warmup_iterations\": " << options.warmupFrames << ",\n";
+  out << "  \"seed\": " << options.seed << ",\n";
+  out << "  \"kernels_us\": {\n";
+  for (size_t i = 0; i < kernels.size(); i++) {
+    const KernelSamples& kernel = kernels[i];
+    out << "    \"" << kernel.name
+        << "\": {\"p50\": " << percentile(kernel.samples, 0.50f)
+        << ", \"p99\": " << percentile(kernel.samples, 0.99f);
+    if (ALLOCATION_COUNTING) {
+      out << ", \"allocations\": " << kernel.allocations;
+    }
+    out << "}" << (i + 1 < kernels.size() ? ",\n" : "\n");
+  }
+  out << "  }\n";
+  out << "}\n";
+
+  SPDLOG_INFO("Benchmark results written to {}", options.outputPath);
+
+  int result = verified ? 0 : 1;
+  if (!ALLOCATION_COUNTING &&
+      std::any_of(kernels.begin(), kernels.end(),
+                  [](const KernelSamples& kernel) {
+                    return kernel.mustNotAllocate;
+                  })) {
+    SPDLOG_WARN("Heap allocations aren't counted; configure with "
+                "-DSDL_ANIMATIONS_BENCH=ON to check them");
+  }
+  for (const KernelSamples& kernel : kernels) {
+    if (kernel.mustNotAllocate && kernel.allocations > 0) {
+      SPDLOG_ERROR("{} made {} heap allocations in {} calls, expected none",
+                   kernel.name, kernel.allocations, kernel.samples.size());
+      result = 1;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+void configureHeadlessSDL() {
+  // Offscreen needs no display server; dummy is the fallback if it was
+  // compiled out
+  SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+  SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+  SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+}
+
+std::string getBenchmarkScenarioList() {
+  std::string list;
+  for (const Scenario& scenario : getScenarios()) {
+    list += "  ";
+    list += scenario.name;
+    list += ": ";
+    list += scenario.description;
+    list += "\n";
+  }
+  return list;
+}
+
+bool parseBenchmarkArgs(int argc, char* argv[], BenchmarkOptions& options,
+                        bool& benchRequested, std::string& error) {
+  benchRequested = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--bench") benchRequested = true;
+  }
+
+  // Without --bench the arguments belong to the normal run
+  if (!benchRequested) return true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+    auto takeInt = [&](int& out) {
+      if (!value || !parseInt(value, out)) {
+        error = arg + " expects a non-negative integer";
+        return false;
+      }
+      i++;
+      return true;
+    };
+
+    if (arg == "--bench") {
+      // The scenario name is optional
+      if (value && value[0] != '-') {
+        options.scenario = value;
+        i++;
+      }
+    } else if (arg == "--frames") {
+      if (!takeInt(options.frames)) return false;
+    } else if (arg == "--warmup") {
+      if (!takeInt(options.warmupFrames)) return false;
+    } else if (arg == "--waypoints") {
+      if (!takeInt(options.waypoints)) return false;
+    } else if (arg == "--grid") {
+      if (!takeInt(options.gridSide)) return false;
+    } else if (arg == "--lines") {
+      if (!takeInt(options.lines)) return false;
+    } else if (arg == "--threads") {
+      if (!takeInt(options.threads)) return false;
+    } else if (arg == "--seed") {
+      int seed = 0;
+      if (!takeInt(seed)) return false;
+      options.seed = static_cast<uint64_t>(seed);
+    } else if (arg == "--dt") {
+      char* end = nullptr;
+      float dt = value ? std::strtof(value, &end) : 0.0f;
+      if (!value || end == value || *end != '\0' || dt <= 0.0f) {
+        error = "--dt expects a positive number of seconds";
+        return false;
+      }
+      options.deltaTime = dt;
+      i++;
+    } else if (arg == "--out") {
+      if (!value) {
+        error = "--out expects a file path";
+        return false;
+      }
+      options.outputPath = value;
+      i++;
+    } else {
+      error = "Unknown argument: " + arg;
+      return false;
+    }
+  }
+
+  if (!findScenario(options.scenario)) {
+    error = "Unknown benchmark scenario: " + options.scenario;
+    return false;
+  }
+
+  return true;
+}
+
+int runBenchmark(const BenchmarkOptions& options) {
+  const Scenario* scenario = findScenario(options.scenario);
+  if (!scenario) {
+    SPDLOG_ERROR("Unknown benchmark scenario: {}", options.scenario);
+    return 1;
+  }
+
+  // Every random placement goes through SDL_randf, so this fixes the layout
+  SDL_srand(options.seed);
+
+  if (scenario->kernels) {
+    return runKernelBenchmark(*scenario, options);
+  }
+
+  auto eventLoop = std::make_unique<EventLoop>();
+  eventLoop->setTargetFPS(0.0f);
+
+  AppState* appState = eventLoop->getAppState();
+  if (options.threads > 0) {
+    // Swap the pool for the entities and the audio analysis before the
+    // old one goes away
+    auto jobSystem = std::make_unique<JobSystem>(getThreadCount(options) - 1);
+    appState->entityManager.setJobSystem(jobSystem.get());
+    appState->audioSystem->setJobSystem(jobSystem.get());
+    appState->jobSystem = std::move(jobSystem);
+  }
+  scenario->spawn(*appState, options);
+
+  SPDLOG_INFO("Benchmark '{}': {} entities, {} archetype entities, {} frames",
+              scenario->name, appState->entityManager.getEntityCount(),
+              appState->entityManager.getArchetypeEntityCount(),
+              options.frames);
+
+  std::vector<PhaseSamples> phases = {
+      {"input", &FrameTimings::inputMs, {}},
+      {"update", &FrameTimings::updateMs, {}},
+      {"render", &FrameTimings::renderMs, {}},
+      {"ui", &FrameTimings::uiMs, {}},
+      {"present", &FrameTimings::presentMs, {}},
+      {"frame", &FrameTimings::frameMs, {}},
+  };
+  for (PhaseSamples& phase : phases) {
+    phase.samples.reserve(options.frames);
+  }
+
+  for (int frame = 0; frame < options.warmupFrames; frame++) {
+    eventLoop->runFrame(options.deltaTime);
+  }
+
+  for (int frame = 0; frame < options.frames; frame++) {
+    eventLoop->runFrame(options.deltaTime);
+
+    const FrameTimings& timings = eventLoop->getFrameTimings();
+    for (PhaseSamples& phase : phases) {
+      phase.samples.push_back(timings.*phase.field);
+    }
+  }
+
+  std::ofstream out(options.outputPath);
+  if (!out) {
+    SPDLOG_ERROR("Couldn't open {} for writing", options.outputPath);
+    return 1;
+  }
+
+  out << "{\n";
+  out << "  \"scenario\": \"" << scenario->name << "\",\n";
+  out << "  \"frames\": " << options.frames << ",\n";
+  out << "  \"warmup_frames\": " << options.warmupFrames << ",\n";
+  out << "  \"dt\": " << options.deltaTime << ",\n";
+  out << "  \"seed\": " << options.seed << ",\n";
+  out << "  \"threads\": " << appState->jobSystem->getThreadCount() << ",\n";
+  const char* videoDriver = SDL_GetCurrentVideoDriver();
+  const char* renderDriver = SDL_GetRendererName(appState->context->renderer);
+  out << "  \"video_driver\": \"" << (videoDriver ? videoDriver : "")
+      << "\",\n";
+  out << "  \"render_driver\": \"" << (renderDriver ? renderDriver : "")
+      << "\",\n";
+  out << "  \"entities\": " << appState->entityManager.getEntityCount()
+      << ",\n";
+  out << "  \"archetype_entities\": "
+      << appState->entityManager.getArchetypeEntityCount() << ",\n";
+  out << "  \"phases_ms\": {\n";
+  for (size_t i = 0; i < phases.size(); i++) {
+    const PhaseSamples& phase = phases[i];
+    out << "    \"" << phase.name
+        << "\": {\"p50\": " << percentile(phase.samples, 0.50f)
+        << ", \"p99\": " << percentile(phase.samples, 0.99f) << "}"
+        << (i + 1 < phases.size() ? ",\n" : "\n");
+  }
+  out << "  }\n";
+  out << "}\n";
+
+  SPDLOG_INFO("Benchmark results written to {}", options.outputPath);
+  return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Settings for a headless benchmark run, filled from the command line
+struct BenchmarkOptions {
+  std::string scenario = "mixed";
+  std::string outputPath = "bench.json";
+
+  int frames = 600;       // Measured frames
+  int warmupFrames = 60;  // Frames run before measuring starts
+  float deltaTime = 1.0f / 60.0f;
+  uint64_t seed = 1;
+
+  // Scenario sizes
+  int waypoints = 10000;
+  int gridSide = 64;
+  int lines = 1000;
+
+  // Threads updating entities, the calling thread included; 0 uses every
+  // hardware thread
+  int threads = 0;
+};
+
+// Parse `--bench [scenario]` and the options that go with it. Returns false
+// and fills `error` on malformed input. `benchRequested` is set when
+// `--bench` is present; without it the arguments are left alone and
+// nothing is validated.
+bool parseBenchmarkArgs(int argc, char* argv[], BenchmarkOptions& options,
+                        bool& benchRequested, std::string& error);
+
+// Point SDL at the offscreen video driver and the software renderer. Must
+// be called before SDL_Init.
+void configureHeadlessSDL();
+
+// Spawn the scenario, run the frames and write the JSON report. Returns the
+// process exit code.
+int runBenchmark(const BenchmarkOptions& options);
+
+// Names of the available scenarios, for --help
+std::string getBenchmarkScenarioList();
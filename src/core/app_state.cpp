@@ -6,12 +6,21 @@
 #include "backends/imgui_impl_sdlrenderer3.h"
 #include "constants.h"
 #include "systems/animation_system.h"
+#include "systems/audio_binding_system.h"
 #include "systems/input_system.h"
+#include "systems/job_system.h"
 
 AppState::AppState(Context* context) : context(context), entityManager(this) {
   inputSystem = std::make_unique<InputSystem>(this);
   animationSystem = std::make_unique<AnimationSystem>(this);
   audioSystem = std::make_unique<AudioSystem>();
+  audioBindingSystem = std::make_unique<AudioBindingSystem>(entityManager);
+  jobSystem = std::make_unique<JobSystem>();
+
+  entityManager.setJobSystem(jobSystem.get());
+  audioSystem->setJobSystem(jobSystem.get());
+  spdlog::info("Job system started with {} threads",
+               jobSystem->getThreadCount());
   audioUI = std::make_unique<AudioUI>();
 
   // Set the audio system for the UI
@@ -49,6 +58,9 @@ AppState::AppState(Context* context) : context(context), entityManager(this) {
 }
 
 AppState::~AppState() {
+  // A background track analysis may be using the pool, which goes first
+  audioSystem->setJobSystem(nullptr);
+
   ImGui_ImplSDLRenderer3_Shutdown();
   ImGui_ImplSDL3_Shutdown();
   ImGui::DestroyContext();
@@ -15,6 +15,8 @@
 
 class InputSystem;
 class AnimationSystem;
+class AudioBindingSystem;
+class JobSystem;
 
 class AppState {
  public:
@@ -33,6 +35,8 @@ class AppState {
   std::unique_ptr<InputSystem> inputSystem;
   std::unique_ptr<AnimationSystem> animationSystem;
   std::unique_ptr<AudioSystem> audioSystem;
+  std::unique_ptr<AudioBindingSystem> audioBindingSystem;
+  std::unique_ptr<JobSystem> jobSystem;
   std::unique_ptr<AudioUI> audioUI;
 
   AppState(Context* context);
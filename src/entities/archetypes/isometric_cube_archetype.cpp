@@ -0,0 +1,192 @@
+#include "isometric_cube_archetype.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+const int ISOMETRIC_CUBE_LINE_COUNT = 11;
+const int ISOMETRIC_CUBE_VERTEX_COUNT = 12;
+const int ISOMETRIC_CUBE_INDEX_COUNT = 18;
+
+static const int QUAD_INDICES[6] = {0, 1, 2, 0, 2, 3};
+
+size_t IsometricCubeArchetype::spawn(SDL_FPoint position, float startTime) {
+  x.push_back(position.x);
+  y.push_back(position.y);
+  anchorX.push_back(position.x);
+  anchorY.push_back(position.y);
+  time.push_back(startTime);
+  speed.push_back(2.0f);
+  cubeSize.push_back(50.0f);
+  waveDy.push_back(25.0f);
+  color.push_back({0.5f, 0.5f, 0.5f, 1.0f});
+  visible.push_back(1);
+
+  drawOrderDirty = true;
+
+  return x.size() - 1;
+}
+
+void IsometricCubeArchetype::spawnGrid(SDL_FPoint front, int side) {
+  reserve(x.size() + static_cast<size_t>(side) * side);
+
+  SDL_FPoint rowStart = front;
+  for (int r = 0; r < side; r++) {
+    size_t first = spawn(rowStart, r * 75.0f);
+    float halfsize = cubeSize[first] / 2.0f;
+
+    // Walk towards the back-left, as IsometricCubeEntity::getBehindLeft does
+    SDL_FPoint colPos = {rowStart.x - cubeSize[first], rowStart.y - halfsize};
+    for (int c = 1; c < side; c++) {
+      spawn(colPos, (r + c) * 75.0f);
+      colPos = {colPos.x - cubeSize[first], colPos.y - halfsize};
+    }
+
+    rowStart = {rowStart.x + cubeSize[first], rowStart.y - halfsize};
+  }
+}
+
+void IsometricCubeArchetype::reserve(size_t count) {
+  x.reserve(count);
+  y.reserve(count);
+  anchorX.reserve(count);
+  anchorY.reserve(count);
+  time.reserve(count);
+  speed.reserve(count);
+  cubeSize.reserve(count);
+  waveDy.reserve(count);
+  color.reserve(count);
+  visible.reserve(count);
+}
+
+void IsometricCubeArchetype::clear() {
+  x.clear();
+  y.clear();
+  anchorX.clear();
+  anchorY.clear();
+  time.clear();
+  speed.clear();
+  cubeSize.clear();
+  waveDy.clear();
+  color.clear();
+  visible.clear();
+  drawOrder.clear();
+  drawOrderDirty = false;
+}
+
+void IsometricCubeArchetype::update(float deltaTime) {
+  update(deltaTime, 0, x.size());
+}
+
+void IsometricCubeArchetype::update(float deltaTime, size_t begin,
+                                    size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    time[i] += deltaTime * speed[i];
+  }
+
+  // Same easing as IsometricCubeEntity::update, between anchor -/+ waveDy
+  for (size_t i = begin; i < end; ++i) {
+    float t = (sinf(time[i] - M_PI / 2.0f) + 1.0f) / 2.0f;
+    y[i] = anchorY[i] - waveDy[i] + t * 2.0f * waveDy[i];
+  }
+}
+
+void IsometricCubeArchetype::rebuildDrawOrder() {
+  drawOrder.resize(x.size());
+  std::iota(drawOrder.begin(), drawOrder.end(), 0);
+
+  // Stable so cubes on the same row keep their spawn order, like the
+  // per-entity z-order sort
+  std::stable_sort(drawOrder.begin(), drawOrder.end(),
+                   [this](size_t a, size_t b) {
+                     return anchorY[a] < anchorY[b];
+                   });
+
+  drawOrderDirty = false;
+}
+
+void IsometricCubeArchetype::render(GeometryBatch& batch,
+                                    const BoundingBox* viewport,
+                                    CullStats& stats) {
+  if (x.empty()) return;
+
+  if (drawOrderDirty) {
+    rebuildDrawOrder();
+  }
+
+  vertices.resize(ISOMETRIC_CUBE_VERTEX_COUNT);
+  indices.resize(ISOMETRIC_CUBE_INDEX_COUNT);
+  for (int face = 0; face < 3; face++) {
+    for (int i = 0; i < 6; i++) {
+      indices[face * 6 + i] = face * 4 + QUAD_INDICES[i];
+    }
+  }
+
+  SDL_FPoint lines[ISOMETRIC_CUBE_LINE_COUNT];
+
+  for (size_t i : drawOrder) {
+    if (!visible[i]) continue;
+
+    float cx = x[i];
+    float cy = y[i];
+    float s = cubeSize[i];
+    float h = s / 2.0f;
+
+    // Same extents as IsometricCubeEntity::getBoundingBox
+    if (viewport &&
+        isOutsideViewport(BoundingBox(cx - s, cy - s * 2, cx + s, cy),
+                          *viewport)) {
+      stats.culled++;
+      continue;
+    }
+    stats.drawn++;
+
+    // Shade the three faces from the base color: top, left, right
+    const SDL_FColor& base = color[i];
+    const SDL_FColor top = {base.r * 0.8f, base.g * 0.8f, base.b * 0.8f,
+                            base.a};
+    const SDL_FColor left = {base.r * 0.6f, base.g * 0.6f, base.b * 0.6f,
+                             base.a};
+    const SDL_FColor right = base;
+
+    const SDL_FPoint facePoints[ISOMETRIC_CUBE_VERTEX_COUNT] = {
+        // Top
+        {cx - s, cy - s - h},
+        {cx, cy - s * 2},
+        {cx + s, cy - s - h},
+        {cx, cy - s},
+        // Left
+        {cx - s, cy - h},
+        {cx - s, cy - s - h},
+        {cx, cy - s},
+        {cx, cy},
+        // Right
+        {cx, cy},
+        {cx, cy - s},
+        {cx + s, cy - s - h},
+        {cx + s, cy - h}};
+
+    for (int v = 0; v < ISOMETRIC_CUBE_VERTEX_COUNT; v++) {
+      vertices[v].position = facePoints[v];
+      vertices[v].color = v < 4 ? top : (v < 8 ? left : right);
+      vertices[v].tex_coord = {0.0f, 0.0f};
+    }
+
+    batch.addGeometry(vertices.data(), ISOMETRIC_CUBE_VERTEX_COUNT,
+                      indices.data(), ISOMETRIC_CUBE_INDEX_COUNT);
+
+    lines[0] = {cx, cy};
+    lines[1] = {cx - s, cy - h};
+    lines[2] = {cx - s, cy - s - h};
+    lines[3] = {cx, cy - s};
+    lines[4] = {cx, cy};
+    lines[5] = {cx + s, cy - h};
+    lines[6] = {cx + s, cy - s - h};
+    lines[7] = {cx, cy - s};
+    lines[8] = {cx + s, cy - s - h};
+    lines[9] = {cx, cy - s * 2};
+    lines[10] = {cx - s, cy - s - h};
+
+    batch.addLines(lines, ISOMETRIC_CUBE_LINE_COUNT, {0.0f, 0.0f, 0.0f, 0.0f});
+  }
+}
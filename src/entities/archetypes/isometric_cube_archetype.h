@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <vector>
+
+#include "entities/utils/culling.h"
+#include "graphics/geometry_batch.h"
+
+// Structure-of-arrays storage for isometric cubes.
+//
+// Mirrors IsometricCubeEntity: each cube bobs vertically around its anchor
+// by `waveDy` and is depth-sorted by the anchor's screen y. Because anchors
+// never move after spawning, the draw order is only rebuilt when cubes are
+// added.
+class IsometricCubeArchetype {
+ public:
+  // Current position
+  std::vector<float> x;
+  std::vector<float> y;
+
+  // Resting position the wave oscillates around
+  std::vector<float> anchorX;
+  std::vector<float> anchorY;
+
+  std::vector<float> time;
+  std::vector<float> speed;
+  std::vector<float> cubeSize;
+  std::vector<float> waveDy;
+  std::vector<SDL_FColor> color;
+  std::vector<Uint8> visible;
+
+  size_t spawn(SDL_FPoint position, float startTime = 0.0f);
+
+  // Lay out a side x side diamond of cubes whose front-most cube sits at
+  // `front`, matching the debug panel's "Isometric Grid Wave"
+  void spawnGrid(SDL_FPoint front, int side);
+
+  void reserve(size_t count);
+  void clear();
+
+  void update(float deltaTime);
+  // Update only elements [begin, end). Disjoint ranges may be updated
+  // concurrently.
+  void update(float deltaTime, size_t begin, size_t end);
+  // Draw everything, skipping items entirely outside `viewport` when one is
+  // given
+  void render(GeometryBatch& batch, const BoundingBox* viewport,
+              CullStats& stats);
+
+  size_t size() const { return x.size(); }
+
+ private:
+  // Indices sorted by anchorY, rebuilt lazily after spawns
+  std::vector<size_t> drawOrder;
+  bool drawOrderDirty = false;
+
+  // Per-cube geometry, reused between frames
+  std::vector<SDL_Vertex> vertices;
+  std::vector<int> indices;
+
+  void rebuildDrawOrder();
+};
@@ -0,0 +1,83 @@
+#include "waypoint_archetype.h"
+
+#include <cmath>
+
+size_t WaypointArchetype::spawn(float centerX, float centerY) {
+  float randomAngle = SDL_randf() * 2.0f * M_PI;
+  float randomDistance = SDL_randf() * 500.0f;
+
+  x.push_back(centerX);
+  y.push_back(centerY);
+  originX.push_back(centerX);
+  originY.push_back(centerY);
+  targetX.push_back(centerX + cosf(randomAngle) * randomDistance);
+  targetY.push_back(centerY + sinf(randomAngle) * randomDistance);
+  time.push_back(0.0f);
+  speed.push_back(2.0f);
+  color.push_back({255, 255, 255, 255});
+  visible.push_back(1);
+
+  return x.size() - 1;
+}
+
+void WaypointArchetype::reserve(size_t count) {
+  x.reserve(count);
+  y.reserve(count);
+  originX.reserve(count);
+  originY.reserve(count);
+  targetX.reserve(count);
+  targetY.reserve(count);
+  time.reserve(count);
+  speed.reserve(count);
+  color.reserve(count);
+  visible.reserve(count);
+}
+
+void WaypointArchetype::clear() {
+  x.clear();
+  y.clear();
+  originX.clear();
+  originY.clear();
+  targetX.clear();
+  targetY.clear();
+  time.clear();
+  speed.clear();
+  color.clear();
+  visible.clear();
+}
+
+void WaypointArchetype::update(float deltaTime) {
+  update(deltaTime, 0, size());
+}
+
+void WaypointArchetype::update(float deltaTime, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    time[i] += deltaTime * speed[i];
+  }
+
+  // Same easing as WaypointEntity::update: start at the origin (t=0) and
+  // swing out to the target (t=1)
+  for (size_t i = begin; i < end; ++i) {
+    float t = (sinf(time[i] - M_PI / 2.0f) + 1.0f) / 2.0f;
+    x[i] = originX[i] + t * (targetX[i] - originX[i]);
+    y[i] = originY[i] + t * (targetY[i] - originY[i]);
+  }
+}
+
+void WaypointArchetype::render(GeometryBatch& batch,
+                               const BoundingBox* viewport, CullStats& stats) {
+  const size_t count = size();
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!visible[i]) continue;
+
+    if (viewport && isOutsideViewport(BoundingBox(x[i], y[i], x[i], y[i]),
+                                      *viewport)) {
+      stats.culled++;
+      continue;
+    }
+    stats.drawn++;
+
+    batch.addPoint({x[i], y[i]}, toFColor(color[i]));
+  }
+}
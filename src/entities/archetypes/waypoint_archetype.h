@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <vector>
+
+#include "entities/utils/culling.h"
+#include "graphics/geometry_batch.h"
+
+// Structure-of-arrays storage for waypoints.
+//
+// Every waypoint lives at the same index across all columns, so a batch
+// update is a straight loop over contiguous floats with no pointer chasing
+// or virtual dispatch. Behaviour mirrors WaypointEntity.
+class WaypointArchetype {
+ public:
+  // Current position
+  std::vector<float> x;
+  std::vector<float> y;
+
+  // Sine-wave endpoints (WaypointEntity's position0 / position1)
+  std::vector<float> originX;
+  std::vector<float> originY;
+  std::vector<float> targetX;
+  std::vector<float> targetY;
+
+  std::vector<float> time;
+  std::vector<float> speed;
+  std::vector<SDL_Color> color;
+  std::vector<Uint8> visible;
+
+  // Spawn a waypoint wandering up to 500px around the given center
+  size_t spawn(float centerX, float centerY);
+
+  void reserve(size_t count);
+  void clear();
+
+  void update(float deltaTime);
+  // Update only elements [begin, end). Disjoint ranges may be updated
+  // concurrently.
+  void update(float deltaTime, size_t begin, size_t end);
+  // Draw everything, skipping items entirely outside `viewport` when one is
+  // given
+  void render(GeometryBatch& batch, const BoundingBox* viewport,
+              CullStats& stats);
+
+  size_t size() const { return x.size(); }
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+struct BoundingBox {
+  float minX, minY, maxX, maxY;
+
+  BoundingBox(float minX, float minY, float maxX, float maxY)
+      : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
+};
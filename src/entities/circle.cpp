@@ -7,36 +7,30 @@ CircleEntity::CircleEntity(const SDL_FPoint& center, float radius)
 
 void CircleEntity::update(float) {}
 
-void CircleEntity::render(SDL_Renderer* renderer) {
+void CircleEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-
-  // Draw circle using multiple line segments
+  // Approximate the circle with a polygon
   const int segments = 32;
   const float angleStep = 2.0f * M_PI / segments;
 
-  std::vector<SDL_FPoint> points;
-  points.reserve(segments + 1);
-
+  SDL_FPoint points[segments + 1];
   for (int i = 0; i <= segments; ++i) {
     float angle = i * angleStep;
-    SDL_FPoint point = {center.x + radius * cosf(angle),
-                        center.y + radius * sinf(angle)};
-    points.push_back(point);
+    points[i] = {center.x + radius * cosf(angle),
+                 center.y + radius * sinf(angle)};
   }
 
+  SDL_FColor fillColor = toFColor(color);
+
   if (filled) {
-    // Draw filled circle by connecting points to center
-    for (size_t i = 0; i < points.size() - 1; ++i) {
-      SDL_RenderLine(renderer, center.x, center.y, points[i].x, points[i].y);
+    // Triangle fan around the center
+    for (int i = 0; i < segments; ++i) {
+      batch.addTriangle(center, points[i], points[i + 1], fillColor);
     }
   } else {
     // Draw circle outline
-    for (size_t i = 0; i < points.size() - 1; ++i) {
-      SDL_RenderLine(renderer, points[i].x, points[i].y, points[i + 1].x,
-                     points[i + 1].y);
-    }
+    batch.addLines(points, segments + 1, fillColor, borderThickness);
   }
 }
 
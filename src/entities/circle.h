@@ -18,7 +18,7 @@ class CircleEntity : public Entity, public IPositionable, public IInteractive {
 
   void update(float deltaTime) override;
 
-  void render(SDL_Renderer* renderer) override;
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -46,9 +46,15 @@ class CircleEntity : public Entity, public IPositionable, public IInteractive {
   void setDraggable(bool draggable) { this->draggable = draggable; }
 
   // Circle-specific methods
-  void setCenter(const SDL_FPoint& center) { this->center = center; }
+  void setCenter(const SDL_FPoint& center) {
+    this->center = center;
+    notifyMoved();
+  }
 
-  void setRadius(float radius) { this->radius = radius; }
+  void setRadius(float radius) {
+    this->radius = radius;
+    notifyMoved();
+  }
 
   void setColor(const SDL_Color& color) { this->color = color; }
 
@@ -5,6 +5,12 @@
 #include <algorithm>
 
 #include "core/app_state.h"
+#include "systems/job_system.h"
+
+// Smallest unit of work handed to the job system. Entity updates are
+// virtual calls, archetype updates a few flops per element.
+static const size_t ENTITY_UPDATE_CHUNK = 256;
+static const size_t ARCHETYPE_UPDATE_CHUNK = 4096;
 
 uint32_t EntityTypeRegistry::registerType(const std::string& typeName) {
   auto it = typeMap.find(typeName);
@@ -33,61 +39,360 @@ uint32_t EntityTypeRegistry::getTypeId(const std::string& typeName) const {
   return UINT32_MAX;  // Invalid type ID
 }
 
+void Entity::setZOrder(float z) {
+  if (z == z_order) return;
+
+  z_order = z;
+  if (manager) {
+    manager->onZOrderChanged(this);
+  }
+}
+
+void Entity::notifyMoved() {
+  if (manager) {
+    manager->onEntityMoved(this);
+  }
+}
+
 EntityManager::EntityManager(AppState* appState) : appState(appState) {}
 
+void EntityManager::onZOrderChanged(Entity*) {
+  pendingZOrderChanges++;
+  renderOrderDirty = true;
+}
+
+void EntityManager::onEntityMoved(Entity* entity) {
+  // Called from worker threads during a parallel update; only the entity
+  // itself may be written, the queue is filled in afterwards
+  if (parallelUpdateActive) {
+    entity->movedInParallel = true;
+    return;
+  }
+
+  if (entity->boundsDirty || entity->removed) return;
+
+  entity->boundsDirty = true;
+  movedEntities.push_back(entity->handle);
+}
+
+void EntityManager::refreshSpatialIndex() {
+  for (EntityHandle handle : movedEntities) {
+    Entity* entity = get(handle);
+    if (!entity) continue;
+
+    entity->boundsDirty = false;
+    spatialIndex.update(handle.index, entity->getBoundingBox());
+  }
+  movedEntities.clear();
+}
+
+void EntityManager::queryPoint(SDL_FPoint point, std::vector<Entity*>& out) {
+  refreshSpatialIndex();
+
+  queryScratch.clear();
+  spatialIndex.queryPoint(point.x, point.y, queryScratch);
+  for (uint32_t slot : queryScratch) {
+    out.push_back(slotEntities[slot]);
+  }
+}
+
+void EntityManager::queryRect(const BoundingBox& rect,
+                              std::vector<Entity*>& out) {
+  refreshSpatialIndex();
+
+  queryScratch.clear();
+  spatialIndex.queryRect(rect, queryScratch);
+  for (uint32_t slot : queryScratch) {
+    out.push_back(slotEntities[slot]);
+  }
+}
+
+BoundingBox EntityManager::getIndexedBounds(Entity* entity) {
+  refreshSpatialIndex();
+
+  uint32_t slot = entity->handle.index;
+  if (entity->manager != this || !spatialIndex.contains(slot)) {
+    return entity->getBoundingBox();
+  }
+  return spatialIndex.getBounds(slot);
+}
+
+void EntityManager::registerEntity(std::unique_ptr<Entity> entity) {
+  uint32_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  } else {
+    slot = static_cast<uint32_t>(slotEntities.size());
+    slotEntities.push_back(nullptr);
+    slotGenerations.push_back(1);  // Generation 0 is never handed out
+  }
+
+  Entity* ptr = entity.get();
+  ptr->manager = this;
+  ptr->handle = EntityHandle{slot, slotGenerations[slot]};
+  ptr->denseIndex = static_cast<uint32_t>(entities.size());
+  ptr->spawnOrder = nextSpawnOrder++;
+  ptr->independentUpdate = ptr->hasIndependentUpdate();
+  slotEntities[slot] = ptr;
+  if (!ptr->independentUpdate) {
+    dependentEntities.push_back(ptr);
+  }
+
+  entities.push_back(std::move(entity));
+
+  // Appended unsorted, so it counts as a z-order change: a mass spawn
+  // takes the full sort instead of an insertion sort per entity
+  renderOrder.push_back(ptr);
+  pendingZOrderChanges++;
+  renderOrderDirty = true;
+
+  onEntityMoved(ptr);
+}
+
+void EntityManager::destroyEntity(Entity* entity) {
+  // Invalidate the handle and recycle the slot
+  uint32_t slot = entity->handle.index;
+  slotEntities[slot] = nullptr;
+  slotGenerations[slot]++;
+  freeSlots.push_back(slot);
+  spatialIndex.remove(slot);
+
+  // Swap-and-pop out of the dense array
+  uint32_t index = entity->denseIndex;
+  std::unique_ptr<Entity> owned = std::move(entities[index]);
+  if (index != entities.size() - 1) {
+    entities[index] = std::move(entities.back());
+    entities[index]->denseIndex = index;
+  }
+  entities.pop_back();
+
+  owned->removed = true;
+  graveyard.push_back(std::move(owned));
+}
+
+void EntityManager::removeEntity(EntityHandle handle) {
+  removeEntity(get(handle));
+}
+
 void EntityManager::removeEntity(Entity* entity) {
+  if (!entity || entity->manager != this || entity->pendingRemoval) return;
+
+  entity->pendingRemoval = true;
   entitiesToRemove.push_back(entity);
 }
 
 void EntityManager::clear() {
+  for (uint32_t slot = 0; slot < slotEntities.size(); ++slot) {
+    if (slotEntities[slot]) {
+      slotEntities[slot] = nullptr;
+      slotGenerations[slot]++;
+      freeSlots.push_back(slot);
+    }
+  }
+
   entities.clear();
   entitiesToRemove.clear();
+  dependentEntities.clear();
+  graveyard.clear();
+  spatialIndex.clear();
+  movedEntities.clear();
+  renderOrder.clear();
+  pendingZOrderChanges = 0;
+  renderOrderDirty = false;
+  waypoints.clear();
+  cubes.clear();
 }
 
 void EntityManager::update(float deltaTime) {
   // Remove marked entities
   if (!entitiesToRemove.empty()) {
-    entities.erase(
-        std::remove_if(
-            entities.begin(), entities.end(),
-            [this](const std::unique_ptr<Entity>& entity) {
-              return std::find(entitiesToRemove.begin(), entitiesToRemove.end(),
-                               entity.get()) != entitiesToRemove.end();
-            }),
-        entities.end());
+    bool dependentRemoved = false;
+    for (Entity* entity : entitiesToRemove) {
+      dependentRemoved |= !entity->independentUpdate;
+      destroyEntity(entity);
+    }
     entitiesToRemove.clear();
+
+    // Still alive in the graveyard, and erased in order
+    if (dependentRemoved) {
+      std::erase_if(dependentEntities,
+                    [](Entity* entity) { return entity->removed; });
+    }
+
+    // Reclaim dead render-order entries once they make up a sizeable share,
+    // so the cost is amortized over the removals that produced them
+    if (graveyard.size() * 4 >= renderOrder.size()) {
+      compactRenderOrder();
+    }
   }
 
-  // Update all active entities
-  for (auto& entity : entities) {
+  if (jobSystem && parallelUpdateEnabled) {
+    // Batch-update archetype storage in parallel chunks
+    jobSystem->parallelFor(waypoints.size(), ARCHETYPE_UPDATE_CHUNK,
+                           [this, deltaTime](size_t begin, size_t end) {
+                             waypoints.update(deltaTime, begin, end);
+                           });
+    jobSystem->parallelFor(cubes.size(), ARCHETYPE_UPDATE_CHUNK,
+                           [this, deltaTime](size_t begin, size_t end) {
+                             cubes.update(deltaTime, begin, end);
+                           });
+
+    updateIndependentEntities(deltaTime);
+  } else {
+    // Batch-update archetype storage
+    waypoints.update(deltaTime);
+    cubes.update(deltaTime);
+
+    // Independent entities, in whatever order removals have left them
+    for (auto& entity : entities) {
+      if (entity->independentUpdate && entity->isActive()) {
+        entity->update(deltaTime);
+      }
+    }
+  }
+
+  // The rest, in creation order, on this thread
+  for (Entity* entity : dependentEntities) {
     if (entity->isActive()) {
       entity->update(deltaTime);
     }
   }
+
+  // Re-index everything that moved this step
+  refreshSpatialIndex();
 }
 
-void EntityManager::render(SDL_Renderer* renderer) {
-  // Sort entities by z-order for proper layering
-  std::vector<Entity*> sortedEntities;
-  sortedEntities.reserve(entities.size());
+void EntityManager::updateIndependentEntities(float deltaTime) {
+  parallelUpdateActive = true;
+  jobSystem->parallelFor(
+      entities.size(), ENTITY_UPDATE_CHUNK,
+      [this, deltaTime](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          Entity* entity = entities[i].get();
+          if (entity->independentUpdate && entity->isActive()) {
+            entity->update(deltaTime);
+          }
+        }
+      });
+  parallelUpdateActive = false;
 
+  // Queue the moves that were recorded on the entities themselves
   for (auto& entity : entities) {
-    if (entity->isVisible()) {
-      sortedEntities.push_back(entity.get());
+    if (entity->movedInParallel) {
+      entity->movedInParallel = false;
+      onEntityMoved(entity.get());
     }
   }
+}
+
+void EntityManager::render(SDL_Renderer* renderer) {
+  updateViewport(renderer);
+  cullStats = CullStats{};
+  batch.begin(renderer);
+
+  const BoundingBox* cullViewport = cullingEnabled ? &viewport : nullptr;
+
+  // Archetype storage is drawn first, underneath the per-object entities
+  cubes.render(batch, cullViewport, cullStats);
+  waypoints.render(batch, cullViewport, cullStats);
 
-  std::sort(sortedEntities.begin(), sortedEntities.end(),
-            [](const Entity* a, const Entity* b) {
-              return a->getZOrder() < b->getZOrder();
-            });
+  // Bring the persistent z-order index up to date, if anything changed
+  updateRenderOrder();
+
+  if (cullingEnabled) {
+    markEntitiesInView();
+  }
 
   // Render entities in z-order
-  for (Entity* entity : sortedEntities) {
-    entity->render(renderer);
+  for (Entity* entity : renderOrder) {
+    if (entity->removed || !entity->isVisible()) continue;
+
+    if (cullingEnabled && entity->cullStamp != currentCullStamp) {
+      cullStats.culled++;
+      continue;
+    }
+
+    entity->render(batch);
+    cullStats.drawn++;
+  }
+
+  batch.end();
+}
+
+void EntityManager::updateViewport(SDL_Renderer* renderer) {
+  int outputWidth = 0, outputHeight = 0;
+  float scaleX = 1.0f, scaleY = 1.0f;
+  SDL_GetCurrentRenderOutputSize(renderer, &outputWidth, &outputHeight);
+  SDL_GetRenderScale(renderer, &scaleX, &scaleY);
+
+  // Entities are positioned in logical coordinates, before render scale
+  viewport = BoundingBox(0.0f, 0.0f, outputWidth / scaleX,
+                         outputHeight / scaleY);
+}
+
+void EntityManager::markEntitiesInView() {
+  refreshSpatialIndex();
+
+  currentCullStamp++;
+
+  // Only entities near the viewport are visited, so far-away ones cost a
+  // single stamp comparison in the render loop
+  queryScratch.clear();
+  spatialIndex.queryRect(viewport, queryScratch);
+  for (uint32_t slot : queryScratch) {
+    slotEntities[slot]->cullStamp = currentCullStamp;
   }
 }
 
+void EntityManager::compactRenderOrder() {
+  // Dropping entries keeps the remaining render order sorted
+  renderOrder.erase(std::remove_if(renderOrder.begin(), renderOrder.end(),
+                                   [](Entity* entity) {
+                                     return entity->removed;
+                                   }),
+                    renderOrder.end());
+  graveyard.clear();
+}
+
+void EntityManager::updateRenderOrder() {
+  renderOrderStats = RenderOrderStats{};
+  if (!renderOrderDirty) return;
+
+  if (!graveyard.empty()) {
+    compactRenderOrder();
+  }
+
+  renderOrderStats.resorts = 1;
+  renderOrderStats.zOrderChanges = pendingZOrderChanges;
+
+  auto byZOrder = [](const Entity* a, const Entity* b) {
+    return a->getZOrder() < b->getZOrder();
+  };
+
+  // A handful of changed keys leaves the order nearly sorted, which
+  // insertion sort fixes in close to linear time. Past that, fall back to a
+  // full sort. Both are stable, so equal z-orders keep creation order.
+  if (pendingZOrderChanges * 8 < renderOrder.size()) {
+    for (size_t i = 1; i < renderOrder.size(); ++i) {
+      Entity* entity = renderOrder[i];
+      size_t j = i;
+      while (j > 0 && byZOrder(entity, renderOrder[j - 1])) {
+        renderOrder[j] = renderOrder[j - 1];
+        --j;
+      }
+      renderOrder[j] = entity;
+    }
+    renderOrderStats.incrementalSorts = 1;
+  } else {
+    std::stable_sort(renderOrder.begin(), renderOrder.end(), byZOrder);
+    renderOrderStats.fullSorts = 1;
+  }
+
+  pendingZOrderChanges = 0;
+  renderOrderDirty = false;
+}
+
 std::vector<Entity*> EntityManager::getEntitiesByType(EntityType type) {
   std::vector<Entity*> result;
   for (auto& entity : entities) {
@@ -7,16 +7,18 @@
 #include <unordered_map>
 #include <vector>
 
+#include "entities/archetypes/isometric_cube_archetype.h"
+#include "entities/archetypes/waypoint_archetype.h"
+#include "entities/bounding_box.h"
+#include "entities/entity_handle.h"
+#include "entities/utils/culling.h"
+#include "entities/utils/spatial_grid.h"
+#include "graphics/geometry_batch.h"
 #include "utils/uuid.h"
 
 class AppState;
-
-struct BoundingBox {
-  float minX, minY, maxX, maxY;
-
-  BoundingBox(float minX, float minY, float maxX, float maxY)
-      : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
-};
+class EntityManager;
+class JobSystem;
 
 class EntityTypeRegistry {
  private:
@@ -65,16 +67,6 @@ class IInteractive {
   virtual void onDragEnd() {}
 };
 
-class IAnimatable {
- public:
-  virtual ~IAnimatable() = default;
-  virtual void addAnimation(std::shared_ptr<class Animation> animation) = 0;
-  virtual void removeAnimation(std::shared_ptr<class Animation> animation) = 0;
-  virtual std::vector<std::shared_ptr<class Animation>> getAnimations()
-      const = 0;
-  virtual void clearAnimations() = 0;
-};
-
 class Entity {
  protected:
   bool visible = true;
@@ -82,15 +74,32 @@ class Entity {
   float z_order = 0.0f;
   std::string uuid;
   AppState* appState = nullptr;
+  EntityManager* manager = nullptr;
+
+  // Bookkeeping owned by EntityManager
+  EntityHandle handle;
+  uint32_t denseIndex = 0;
+  uint64_t spawnOrder = 0;
+  bool pendingRemoval = false;
+  bool removed = false;
+  bool boundsDirty = false;
+  bool independentUpdate = false;
+  bool movedInParallel = false;
+  uint32_t cullStamp = 0;
 
   void setAppState(AppState* appState) { this->appState = appState; }
 
+  // Call whenever the bounding box may have changed so the manager's
+  // spatial index picks up the new position
+  void notifyMoved();
+
  public:
   Entity() : uuid(generateUUID()) {}
 
   virtual ~Entity() = default;
 
-  virtual void render(SDL_Renderer* renderer) = 0;
+  // Append this entity's geometry to the frame batch
+  virtual void render(GeometryBatch& batch) = 0;
 
   virtual EntityType getEntityType() const = 0;
 
@@ -98,7 +107,7 @@ class Entity {
 
   virtual void setActive(bool active) { this->active = active; }
 
-  virtual void setZOrder(float z) { z_order = z; }
+  virtual void setZOrder(float z);
 
   bool isVisible() const { return visible; }
 
@@ -108,8 +117,16 @@ class Entity {
 
   const std::string& getUUID() const { return uuid; }
 
+  EntityHandle getHandle() const { return handle; }
+
   virtual void update(float) {}
 
+  // True if update() only reads and writes this entity's own state, so it
+  // may run on a worker thread alongside other entities. Such an update may
+  // call notifyMoved() but must not touch other entities, the manager or
+  // shared globals (including setZOrder). Checked once, at registration.
+  virtual bool hasIndependentUpdate() const { return false; }
+
   virtual BoundingBox getBoundingBox() const { return BoundingBox(0, 0, 0, 0); }
 
   virtual IPositionable* asPositionable() { return nullptr; }
@@ -118,35 +135,176 @@ class Entity {
 
   virtual IInteractive* asInteractive() { return nullptr; }
 
-  virtual IAnimatable* asAnimatable() { return nullptr; }
-
   friend class EntityManager;
 };
 
 class EntityManager {
  private:
+  // Densely packed live entities; removal swaps the last entity into the
+  // freed position
   std::vector<std::unique_ptr<Entity>> entities;
   std::vector<Entity*> entitiesToRemove;
+
+  // Entities without an independent update, in creation order. They may
+  // read each other, so they are updated in that order, and removal keeps
+  // it by erasing them in one pass per update.
+  std::vector<Entity*> dependentEntities;
   AppState* appState;
 
+  // Handle slots. A slot's generation is bumped whenever its entity is
+  // removed so stale handles stop resolving.
+  std::vector<Entity*> slotEntities;
+  std::vector<uint32_t> slotGenerations;
+  std::vector<uint32_t> freeSlots;
+
+  // Removed entities still referenced from renderOrder. They are destroyed
+  // when renderOrder is next compacted, which keeps removal O(1) per entity.
+  std::vector<std::unique_ptr<Entity>> graveyard;
+
+  // Spatial index over entity bounding boxes, keyed by handle slot. Moved
+  // entities are queued and re-indexed in one pass before the next query.
+  SpatialGrid spatialIndex;
+  std::vector<EntityHandle> movedEntities;
+  std::vector<uint32_t> queryScratch;
+  uint64_t nextSpawnOrder = 0;
+
+  void refreshSpatialIndex();
+
+  // View culling state, refreshed every render
+  bool cullingEnabled = true;
+  BoundingBox viewport{0, 0, 0, 0};
+  CullStats cullStats;
+  uint32_t currentCullStamp = 0;
+
+  void updateViewport(SDL_Renderer* renderer);
+  void markEntitiesInView();
+
+  // Optional worker pool for update(). Entities with an independent update
+  // and archetype storage are updated in parallel chunks; everything else
+  // runs serially afterwards on the calling thread.
+  JobSystem* jobSystem = nullptr;
+  bool parallelUpdateEnabled = true;
+  bool parallelUpdateActive = false;
+
+  void updateIndependentEntities(float deltaTime);
+
+  // Everything the manager draws is collected here and submitted in a few
+  // SDL_RenderGeometry calls at the end of render()
+  GeometryBatch batch;
+
+  // Structure-of-arrays storage for high-count entity types. These are
+  // updated and rendered in batches before the per-object entities above.
+  WaypointArchetype waypoints;
+  IsometricCubeArchetype cubes;
+
+  // Entities kept sorted by z-order across frames. Only re-sorted when an
+  // entity is added or its z-order changes.
+  std::vector<Entity*> renderOrder;
+  size_t pendingZOrderChanges = 0;
+  bool renderOrderDirty = false;
+
+  void updateRenderOrder();
+  void compactRenderOrder();
+
+  void registerEntity(std::unique_ptr<Entity> entity);
+  void destroyEntity(Entity* entity);
+
+ public:
+  struct RenderOrderStats {
+    size_t resorts = 0;           // Sort passes run this frame (0 or 1)
+    size_t incrementalSorts = 0;  // Insertion-sort fixups this frame
+    size_t fullSorts = 0;         // Full stable sorts this frame
+    size_t zOrderChanges = 0;     // z-order changes and spawns consumed
+  };
+
+ private:
+  RenderOrderStats renderOrderStats;
+
  public:
   explicit EntityManager(AppState* appState);
 
   template <typename T, typename... Args>
-  T* createEntity(Args&&... args) {
+  TypedEntityHandle<T> createEntity(Args&&... args) {
     auto entity = std::make_unique<T>(std::forward<Args>(args)...);
     T* ptr = entity.get();
     ptr->setAppState(appState);
-    entities.push_back(std::move(entity));
-    return ptr;
+    registerEntity(std::move(entity));
+    return TypedEntityHandle<T>(ptr->getHandle());
   }
 
+  // Resolve a handle, returning nullptr if its entity has been removed
+  Entity* get(EntityHandle handle) const {
+    if (handle.index >= slotEntities.size() ||
+        slotGenerations[handle.index] != handle.generation) {
+      return nullptr;
+    }
+    return slotEntities[handle.index];
+  }
+
+  template <typename T>
+  T* get(TypedEntityHandle<T> handle) const {
+    return static_cast<T*>(get(static_cast<EntityHandle>(handle)));
+  }
+
+  // Queue an entity for removal at the start of the next update
+  void removeEntity(EntityHandle handle);
   void removeEntity(Entity* entity);
   void clear();
 
   void update(float deltaTime);
   void render(SDL_Renderer* renderer);
 
+  // Called by Entity::setZOrder so the render order can be fixed up lazily
+  void onZOrderChanged(Entity* entity);
+
+  // Called by Entity::notifyMoved to queue a spatial index update
+  void onEntityMoved(Entity* entity);
+
+  // Append entities whose bounding box contains the point / overlaps the
+  // rectangle. Backed by the spatial index, so cost scales with the number
+  // of nearby entities rather than the total.
+  void queryPoint(SDL_FPoint point, std::vector<Entity*>& out);
+  void queryRect(const BoundingBox& rect, std::vector<Entity*>& out);
+
+  // Bounding box as last recorded by the spatial index
+  BoundingBox getIndexedBounds(Entity* entity);
+
+  // True if `a` was created after `b`, i.e. is drawn above it at equal
+  // z-order
+  bool isSpawnedAfter(const Entity* a, const Entity* b) const {
+    return a->spawnOrder > b->spawnOrder;
+  }
+
+  const RenderOrderStats& getRenderOrderStats() const {
+    return renderOrderStats;
+  }
+
+  void setJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+
+  JobSystem* getJobSystem() const { return jobSystem; }
+
+  void setParallelUpdateEnabled(bool enabled) {
+    parallelUpdateEnabled = enabled;
+  }
+
+  bool isParallelUpdateEnabled() const { return parallelUpdateEnabled; }
+
+  // Skip drawing anything whose bounding box is entirely off-screen
+  void setCullingEnabled(bool enabled) { cullingEnabled = enabled; }
+
+  bool isCullingEnabled() const { return cullingEnabled; }
+
+  // Drawn / culled counts from the last render, archetypes included
+  const CullStats& getCullStats() const { return cullStats; }
+
+  // Draw calls and vertex counts from the last render
+  const GeometryBatch::Stats& getBatchStats() const {
+    return batch.getStats();
+  }
+
+  // Visible area in entity coordinates, as of the last render
+  const BoundingBox& getViewport() const { return viewport; }
+
   std::vector<Entity*> getEntitiesByType(EntityType type);
   std::vector<Entity*> getAllEntities();
 
@@ -162,4 +320,12 @@ class EntityManager {
   }
 
   size_t getEntityCount() const { return entities.size(); }
+
+  WaypointArchetype& getWaypoints() { return waypoints; }
+
+  IsometricCubeArchetype& getCubes() { return cubes; }
+
+  size_t getArchetypeEntityCount() const {
+    return waypoints.size() + cubes.size();
+  }
 };
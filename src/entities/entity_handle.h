@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Generational reference to an entity owned by EntityManager.
+//
+// `index` names a slot in the manager and `generation` is the slot's
+// generation at creation time. Removing an entity bumps its slot's
+// generation, so handles held elsewhere resolve to nullptr instead of
+// dangling.
+struct EntityHandle {
+  static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+  uint32_t index = INVALID_INDEX;
+  uint32_t generation = 0;
+
+  bool isNull() const { return index == INVALID_INDEX; }
+
+  explicit operator bool() const { return !isNull(); }
+
+  bool operator==(const EntityHandle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator!=(const EntityHandle& other) const {
+    return !(*this == other);
+  }
+};
+
+// Handle that remembers the concrete type it was created with, so
+// EntityManager::get can hand back a T* without a cast at the call site.
+// Converts implicitly to a plain EntityHandle.
+template <typename T>
+struct TypedEntityHandle : EntityHandle {
+  TypedEntityHandle() = default;
+
+  explicit TypedEntityHandle(EntityHandle handle) : EntityHandle(handle) {}
+};
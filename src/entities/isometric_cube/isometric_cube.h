@@ -30,7 +30,9 @@ class IsometricCubeEntity : public Entity,
 
   void update(float) override;
 
-  void render(SDL_Renderer* renderer) override;
+  bool hasIndependentUpdate() const override { return true; }
+
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -10,6 +10,7 @@ void IsometricCubeEntity::setPosition(const SDL_FPoint& position) {
 
   // Depth-sort by screen y so items higher on screen (smaller y) render first
   setZOrder(current_position.y);
+  notifyMoved();
 }
 
 SDL_FPoint IsometricCubeEntity::getBehindLeft() {
@@ -1,15 +1,12 @@
 #include "SDL3/SDL_render.h"
-#include "entities/utils/quad_geometry.h"
 #include "isometric_cube.h"
 
 const int ISOMETRIC_CUBE_LINE_COUNT = 11;
 const int ISOMETRIC_QUAD_POINTS_LENGTH = 4;
 
-void IsometricCubeEntity::render(SDL_Renderer* renderer) {
+void IsometricCubeEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
-  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
   float x = current_position.x;
   float y = current_position.y;
   float halfsize = size / 2.0f;
@@ -21,7 +18,7 @@ void IsometricCubeEntity::render(SDL_Renderer* renderer) {
       {x, y - size * 2},
       {x + size, y - size - halfsize},
       {x, y - size}};
-  renderQuadGeometry(renderer, points, color);
+  batch.addQuad(points, color);
 
   // Left
   color = {0.3f, 0.3f, 0.3f, 1.0f};
@@ -30,7 +27,7 @@ void IsometricCubeEntity::render(SDL_Renderer* renderer) {
       {x - size, y - size - halfsize},
       {x, y - size},
       {x, y}};
-  renderQuadGeometry(renderer, leftPoints, color);
+  batch.addQuad(leftPoints, color);
 
   // Right
   color = {0.5f, 0.5f, 0.5f, 1.0f};
@@ -39,7 +36,7 @@ void IsometricCubeEntity::render(SDL_Renderer* renderer) {
       {x, y - size},
       {x + size, y - size - halfsize},
       {x + size, y - halfsize}};
-  renderQuadGeometry(renderer, rightPoints, color);
+  batch.addQuad(rightPoints, color);
 
   SDL_FPoint lines[ISOMETRIC_CUBE_LINE_COUNT] = {
       {x, y},
@@ -53,6 +50,5 @@ void IsometricCubeEntity::render(SDL_Renderer* renderer) {
       {x + size, y - size - halfsize},
       {x, y - size * 2},
       {x - size, y - size - halfsize}};
-  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-  SDL_RenderLines(renderer, lines, ISOMETRIC_CUBE_LINE_COUNT);
+  batch.addLines(lines, ISOMETRIC_CUBE_LINE_COUNT, {0.0f, 0.0f, 0.0f, 0.0f});
 }
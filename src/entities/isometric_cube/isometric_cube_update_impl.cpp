@@ -10,4 +10,7 @@ void IsometricCubeEntity::update(float deltaTime) {
   // Interpolate between position0 and position1
   current_position.x = position0.x + t * (position1.x - position0.x);
   current_position.y = position0.y + t * (position1.y - position0.y);
+
+  // The wave moves the bounding box every step
+  notifyMoved();
 }
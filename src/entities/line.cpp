@@ -4,8 +4,6 @@
 
 #include <cmath>
 
-#include "systems/animation_system.h"
-
 LineEntity::LineEntity(const SDL_FPoint& start, const SDL_FPoint& end)
     : start(start), end(end) {
   // Calculate the origin (center point) of the line
@@ -31,62 +29,13 @@ void LineEntity::update(float deltaTime) {
       angle += 2.0f * M_PI;
     }
   }
-
-  // Update animations
-  for (auto& animation : animations) {
-    if (animation && !animation->isFinished()) {
-      animation->update(deltaTime);
-
-      // Handle gradient animations
-      if (auto* gradientAnim =
-              dynamic_cast<class GradientAnimation*>(animation.get())) {
-        setAnimatedColor(gradientAnim->getCurrentColor());
-      }
-    }
-  }
-
-  // Remove finished animations
-  animations.erase(
-      std::remove_if(animations.begin(), animations.end(),
-                     [](const std::shared_ptr<class Animation>& anim) {
-                       return anim && anim->isFinished();
-                     }),
-      animations.end());
 }
 
-void LineEntity::render(SDL_Renderer* renderer) {
+void LineEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
   // Use animated color if available, otherwise use base color
-  SDL_Color renderColor = animatedColor;
-  SDL_SetRenderDrawColor(renderer, renderColor.r, renderColor.g, renderColor.b,
-                         renderColor.a);
-
-  // Draw the line
-  SDL_RenderLine(renderer, start.x, start.y, end.x, end.y);
-}
-
-void LineEntity::addAnimation(std::shared_ptr<class Animation> animation) {
-  if (animation) {
-    animations.push_back(animation);
-  }
-}
-
-void LineEntity::removeAnimation(std::shared_ptr<class Animation> animation) {
-  auto it = std::find(animations.begin(), animations.end(), animation);
-  if (it != animations.end()) {
-    animations.erase(it);
-  }
-}
-
-std::vector<std::shared_ptr<class Animation>> LineEntity::getAnimations()
-    const {
-  return animations;
-}
-
-void LineEntity::clearAnimations() {
-  animations.clear();
-  animatedColor = color;  // Reset to base color
+  batch.addLine(start, end, toFColor(animatedColor), thickness);
 }
 
 BoundingBox LineEntity::getBoundingBox() const {
@@ -118,6 +67,8 @@ void LineEntity::setPosition(const SDL_FPoint& position) {
     origin.x += offsetX;
     origin.y += offsetY;
   }
+
+  notifyMoved();
 }
 
 SDL_FPoint LineEntity::getPosition() const {
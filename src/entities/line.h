@@ -6,15 +6,10 @@
 
 #include "entity.h"
 
-// Forward declarations
-class Animation;
-class GradientAnimation;
-
 class LineEntity : public Entity,
                    public IPositionable,
                    public IUpdatable,
-                   public IInteractive,
-                   public IAnimatable {
+                   public IInteractive {
  public:
   // Gradient properties
   struct GradientProperties {
@@ -39,8 +34,6 @@ class LineEntity : public Entity,
   float lineLength = 0.0f;     // Length of the line for rotation calculations
   bool draggable = true;       // Can be set to false to disable dragging
 
-  // Animation support
-  std::vector<std::shared_ptr<class Animation>> animations;
   SDL_Color animatedColor = color;  // Color that can be modified by animations
 
  public:
@@ -48,7 +41,7 @@ class LineEntity : public Entity,
 
   void update(float deltaTime) override;
 
-  void render(SDL_Renderer* renderer) override;
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -67,8 +60,6 @@ class LineEntity : public Entity,
 
   IInteractive* asInteractive() override { return this; }
 
-  IAnimatable* asAnimatable() override { return this; }
-
   // IPositionable implementation
   void setPosition(const SDL_FPoint& position) override;
   SDL_FPoint getPosition() const override;
@@ -78,18 +69,21 @@ class LineEntity : public Entity,
 
   void setDraggable(bool draggable) { this->draggable = draggable; }
 
-  // IAnimatable implementation
-  void addAnimation(std::shared_ptr<class Animation> animation) override;
-  void removeAnimation(std::shared_ptr<class Animation> animation) override;
-  std::vector<std::shared_ptr<class Animation>> getAnimations() const override;
-  void clearAnimations() override;
-
   // Line-specific methods
-  void setStart(const SDL_FPoint& start) { this->start = start; }
+  void setStart(const SDL_FPoint& start) {
+    this->start = start;
+    notifyMoved();
+  }
 
-  void setEnd(const SDL_FPoint& end) { this->end = end; }
+  void setEnd(const SDL_FPoint& end) {
+    this->end = end;
+    notifyMoved();
+  }
 
-  void setThickness(float thickness) { this->thickness = thickness; }
+  void setThickness(float thickness) {
+    this->thickness = thickness;
+    notifyMoved();
+  }
 
   void setColor(const SDL_Color& color) {
     this->color = color;
@@ -100,13 +94,16 @@ class LineEntity : public Entity,
     gradientProps = props;
   }
 
-  // Animation-specific methods
+  // Animation-specific methods, written by AnimationSystem bindings
   void setAnimatedColor(const SDL_Color& color) { animatedColor = color; }
 
   SDL_Color getAnimatedColor() const { return animatedColor; }
 
   // Rotation methods
-  void setOrigin(const SDL_FPoint& origin) { this->origin = origin; }
+  void setOrigin(const SDL_FPoint& origin) {
+    this->origin = origin;
+    notifyMoved();
+  }
 
   void setRotationSpeed(float speed) { rotationSpeed = speed; }
 
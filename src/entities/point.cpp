@@ -1,5 +1,7 @@
 #include "point.h"
 
+#include <algorithm>
+
 #include "core/app_state.h"
 
 PointEntity::PointEntity(AppState* appState, size_t trailLength, float speed)
@@ -28,18 +30,17 @@ void PointEntity::update(float deltaTime) {
         trail[i] = trail[i - 1];
       }
     }
+
+    notifyMoved();
   }
 }
 
-void PointEntity::render(SDL_Renderer* renderer) {
+void PointEntity::render(GeometryBatch& batch) {
   if (!visible || trail.empty()) return;
 
   if (!trailProps.enabled) {
     // Render just the current point
-    SDL_SetRenderDrawColor(renderer, trailProps.startColor.r,
-                           trailProps.startColor.g, trailProps.startColor.b,
-                           trailProps.startColor.a);
-    SDL_RenderPoint(renderer, trail[0].x, trail[0].y);
+    batch.addPoint(trail[0], toFColor(trailProps.startColor));
     return;
   }
 
@@ -72,26 +73,44 @@ void PointEntity::render(SDL_Renderer* renderer) {
         trailProps.startColor.a +
         (trailProps.endColor.a - trailProps.startColor.a) * normalizedProgress);
 
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderPoint(renderer, trail[i].x, trail[i].y);
+    batch.addPoint(trail[i], toFColor(color));
   }
 }
 
 void PointEntity::setTrailLength(size_t length) {
   trailLength = length;
   trail.resize(length);
+  notifyMoved();
 }
 
 void PointEntity::setInitialPosition(float x, float y) {
   for (size_t i = 0; i < trail.size(); ++i) {
     trail[i] = {x - i, y - i};  // Create initial trail
   }
+  notifyMoved();
 }
 
 void PointEntity::setPosition(const SDL_FPoint& position) {
   if (!trail.empty()) {
     trail[0] = position;
   }
+  notifyMoved();
 }
 
 SDL_FPoint PointEntity::getPosition() const { return getCurrentPosition(); }
+
+BoundingBox PointEntity::getBoundingBox() const {
+  if (trail.empty()) return BoundingBox(0, 0, 0, 0);
+
+  float minX = trail[0].x, minY = trail[0].y;
+  float maxX = minX, maxY = minY;
+  for (const SDL_FPoint& point : trail) {
+    minX = std::min(minX, point.x);
+    minY = std::min(minY, point.y);
+    maxX = std::max(maxX, point.x);
+    maxY = std::max(maxY, point.y);
+  }
+
+  // Points are drawn a pixel wide
+  return BoundingBox(minX, minY, maxX + 1.0f, maxY + 1.0f);
+}
@@ -40,7 +40,9 @@ class PointEntity : public Entity,
 
   void update(float deltaTime) override;
 
-  void render(SDL_Renderer* renderer) override;
+  bool hasIndependentUpdate() const override { return true; }
+
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -49,6 +51,9 @@ class PointEntity : public Entity,
     return typeId;
   }
 
+  // Covers the whole trail, so culling and picking follow it
+  BoundingBox getBoundingBox() const override;
+
   // Interface implementations
   IPositionable* asPositionable() override { return this; }
 
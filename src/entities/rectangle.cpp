@@ -6,15 +6,13 @@ RectangleEntity::RectangleEntity(const SDL_FRect& rect) : rect(rect) {}
 
 void RectangleEntity::update(float) {}
 
-void RectangleEntity::render(SDL_Renderer* renderer) {
+void RectangleEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-
   if (filled) {
-    SDL_RenderFillRect(renderer, &rect);
+    batch.addRect(rect, toFColor(color));
   } else {
-    SDL_RenderRect(renderer, &rect);
+    batch.addRectOutline(rect, toFColor(color));
   }
 }
 
@@ -28,6 +26,8 @@ void RectangleEntity::setPosition(const SDL_FPoint& position) {
   float height = rect.h;
   rect.x = position.x - width / 2.0f;  // Center the rectangle on the position
   rect.y = position.y - height / 2.0f;
+
+  notifyMoved();
 }
 
 SDL_FPoint RectangleEntity::getPosition() const {
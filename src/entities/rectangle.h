@@ -19,7 +19,7 @@ class RectangleEntity : public Entity,
 
   void update(float deltaTime) override;
 
-  void render(SDL_Renderer* renderer) override;
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -46,7 +46,10 @@ class RectangleEntity : public Entity,
   void setDraggable(bool draggable) { this->draggable = draggable; }
 
   // Rectangle-specific methods
-  void setRect(const SDL_FRect& rect) { this->rect = rect; }
+  void setRect(const SDL_FRect& rect) {
+    this->rect = rect;
+    notifyMoved();
+  }
 
   void setColor(const SDL_Color& color) { this->color = color; }
 
@@ -8,22 +8,17 @@ TriangleEntity::TriangleEntity(const SDL_FPoint& p1, const SDL_FPoint& p2,
 
 void TriangleEntity::update(float) {}
 
-void TriangleEntity::render(SDL_Renderer* renderer) {
+void TriangleEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+  SDL_FColor fillColor = toFColor(color);
 
   if (filled) {
-    // Draw filled triangle using lines (simple approach)
-    // For a proper filled triangle, you'd need to implement scanline filling
-    SDL_RenderLine(renderer, point1.x, point1.y, point2.x, point2.y);
-    SDL_RenderLine(renderer, point2.x, point2.y, point3.x, point3.y);
-    SDL_RenderLine(renderer, point3.x, point3.y, point1.x, point1.y);
+    batch.addTriangle(point1, point2, point3, fillColor);
   } else {
     // Draw triangle outline
-    SDL_RenderLine(renderer, point1.x, point1.y, point2.x, point2.y);
-    SDL_RenderLine(renderer, point2.x, point2.y, point3.x, point3.y);
-    SDL_RenderLine(renderer, point3.x, point3.y, point1.x, point1.y);
+    const SDL_FPoint outline[4] = {point1, point2, point3, point1};
+    batch.addLines(outline, 4, fillColor);
   }
 }
 
@@ -52,6 +47,8 @@ void TriangleEntity::setPosition(const SDL_FPoint& position) {
   point2.y += offsetY;
   point3.x += offsetX;
   point3.y += offsetY;
+
+  notifyMoved();
 }
 
 SDL_FPoint TriangleEntity::getPosition() const {
@@ -65,4 +62,6 @@ void TriangleEntity::setPoints(const SDL_FPoint& p1, const SDL_FPoint& p2,
   point1 = p1;
   point2 = p2;
   point3 = p3;
+
+  notifyMoved();
 }
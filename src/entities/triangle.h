@@ -18,7 +18,7 @@ class TriangleEntity : public Entity,
                  const SDL_FPoint& p3);
 
   void update(float deltaTime) override;
-  void render(SDL_Renderer* renderer) override;
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification - automatically registers "Triangle"
   EntityType getEntityType() const override {
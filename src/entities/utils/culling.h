@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+#include "entities/bounding_box.h"
+
+// Per-frame counters for the view culling pass
+struct CullStats {
+  size_t drawn = 0;
+  size_t culled = 0;
+};
+
+// True if the box lies entirely outside the viewport
+inline bool isOutsideViewport(const BoundingBox& box,
+                              const BoundingBox& viewport) {
+  return box.maxX < viewport.minX || box.minX > viewport.maxX ||
+         box.maxY < viewport.minY || box.minY > viewport.maxY;
+}
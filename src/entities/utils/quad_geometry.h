@@ -1,6 +0,0 @@
-#pragma once
-
-#include "SDL3/SDL_render.h"
-
-void renderQuadGeometry(SDL_Renderer* renderer, SDL_FPoint* points,
-                        SDL_FColor color);
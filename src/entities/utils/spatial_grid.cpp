@@ -0,0 +1,225 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {}
+
+int SpatialGrid::toCell(float coordinate) const {
+  return static_cast<int>(std::floor(coordinate * inverseCellSize));
+}
+
+SpatialGrid::CellRange SpatialGrid::cellRange(const BoundingBox& bounds) const {
+  return CellRange{toCell(bounds.minX), toCell(bounds.minY),
+                   toCell(bounds.maxX), toCell(bounds.maxY)};
+}
+
+void SpatialGrid::link(uint32_t id, Item& item) {
+  item.home = nullptr;
+  if (item.oversized) {
+    oversizedItems.push_back(id);
+    return;
+  }
+
+  const bool single = item.range.minX == item.range.maxX &&
+                      item.range.minY == item.range.maxY;
+  for (int cy = item.range.minY; cy <= item.range.maxY; ++cy) {
+    for (int cx = item.range.minX; cx <= item.range.maxX; ++cx) {
+      Cell& cell = cells[cellKey(cx, cy)];
+      if (single) {
+        item.home = &cell;
+        item.homeIndex = static_cast<uint32_t>(cell.ids.size());
+      }
+      cell.ids.push_back(id);
+      cell.bounds.push_back(item.bounds);
+    }
+  }
+}
+
+void SpatialGrid::unlink(uint32_t id, const Item& item) {
+  if (item.oversized) {
+    auto it = std::find(oversizedItems.begin(), oversizedItems.end(), id);
+    if (it != oversizedItems.end()) {
+      *it = oversizedItems.back();
+      oversizedItems.pop_back();
+    }
+    return;
+  }
+
+  for (int cy = item.range.minY; cy <= item.range.maxY; ++cy) {
+    for (int cx = item.range.minX; cx <= item.range.maxX; ++cx) {
+      auto it = cells.find(cellKey(cx, cy));
+      if (it == cells.end()) continue;
+
+      Cell& cell = it->second;
+      size_t index = item.home == &cell
+                         ? item.homeIndex
+                         : std::find(cell.ids.begin(), cell.ids.end(), id) -
+                               cell.ids.begin();
+      if (index >= cell.ids.size()) continue;
+
+      // Swap the last entry in, keeping its owner's home index current
+      const uint32_t moved = cell.ids.back();
+      cell.ids[index] = moved;
+      cell.bounds[index] = cell.bounds.back();
+      cell.ids.pop_back();
+      cell.bounds.pop_back();
+      if (items[moved].home == &cell) {
+        items[moved].homeIndex = static_cast<uint32_t>(index);
+      }
+
+      if (cell.ids.empty()) {
+        cells.erase(it);
+      }
+    }
+  }
+}
+
+void SpatialGrid::update(uint32_t id, const BoundingBox& bounds) {
+  if (id >= items.size()) {
+    items.resize(id + 1);
+  }
+
+  Item& item = items[id];
+  CellRange range = cellRange(bounds);
+  int64_t cellCount = (static_cast<int64_t>(range.maxX) - range.minX + 1) *
+                      (static_cast<int64_t>(range.maxY) - range.minY + 1);
+  bool oversized = cellCount > MAX_CELLS_PER_ITEM;
+
+  // Still in the same cells: only the box and its copies change
+  if (item.indexed && item.oversized == oversized &&
+      (oversized || item.range == range)) {
+    item.bounds = bounds;
+    if (item.home) {
+      item.home->bounds[item.homeIndex] = bounds;
+    } else if (!oversized) {
+      for (int cy = range.minY; cy <= range.maxY; ++cy) {
+        for (int cx = range.minX; cx <= range.maxX; ++cx) {
+          const uint64_t key = cellKey(cx, cy);
+          Cell& cell = cells[key];
+          if (!cell.stale) {
+            cell.stale = true;
+            staleCells.push_back(key);
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  if (item.indexed) {
+    unlink(id, item);
+  }
+
+  item.bounds = bounds;
+  item.range = range;
+  item.oversized = oversized;
+  item.indexed = true;
+  link(id, item);
+}
+
+void SpatialGrid::remove(uint32_t id) {
+  if (!contains(id)) return;
+
+  unlink(id, items[id]);
+  items[id].indexed = false;
+  items[id].home = nullptr;
+}
+
+void SpatialGrid::clear() {
+  cells.clear();
+  items.clear();
+  oversizedItems.clear();
+  staleCells.clear();
+}
+
+void SpatialGrid::refreshStaleCells() {
+  for (uint64_t key : staleCells) {
+    auto it = cells.find(key);
+    if (it == cells.end()) continue;
+
+    Cell& cell = it->second;
+    for (size_t i = 0; i < cell.ids.size(); ++i) {
+      cell.bounds[i] = items[cell.ids[i]].bounds;
+    }
+    cell.stale = false;
+  }
+  staleCells.clear();
+}
+
+void SpatialGrid::queryPoint(float x, float y, std::vector<uint32_t>& out) {
+  refreshStaleCells();
+
+  auto hit = [x, y](const BoundingBox& b) {
+    return x >= b.minX && x <= b.maxX && y >= b.minY && y <= b.maxY;
+  };
+
+  // A point falls in exactly one cell, so no de-duplication is needed
+  auto it = cells.find(cellKey(toCell(x), toCell(y)));
+  if (it != cells.end()) {
+    const Cell& cell = it->second;
+    for (size_t i = 0; i < cell.ids.size(); ++i) {
+      if (hit(cell.bounds[i])) out.push_back(cell.ids[i]);
+    }
+  }
+
+  for (uint32_t id : oversizedItems) {
+    if (hit(items[id].bounds)) out.push_back(id);
+  }
+}
+
+void SpatialGrid::queryRect(const BoundingBox& rect,
+                            std::vector<uint32_t>& out) {
+  refreshStaleCells();
+
+  auto overlaps = [&rect](const BoundingBox& b) {
+    return b.maxX >= rect.minX && b.minX <= rect.maxX && b.maxY >= rect.minY &&
+           b.minY <= rect.maxY;
+  };
+
+  CellRange range = cellRange(rect);
+
+  // An item in several cells the query covers is reported only from the
+  // first of them, the cell where its range and the query's start to
+  // overlap, so no per-item bookkeeping is needed to report it once
+  auto visit = [&](int cx, int cy, const Cell& cell) {
+    for (size_t i = 0; i < cell.ids.size(); ++i) {
+      const BoundingBox& b = cell.bounds[i];
+      if (!overlaps(b)) continue;
+      if (cx != std::max(toCell(b.minX), range.minX) ||
+          cy != std::max(toCell(b.minY), range.minY)) {
+        continue;
+      }
+      out.push_back(cell.ids[i]);
+    }
+  };
+
+  int64_t cellCount = (static_cast<int64_t>(range.maxX) - range.minX + 1) *
+                      (static_cast<int64_t>(range.maxY) - range.minY + 1);
+
+  if (cellCount > static_cast<int64_t>(cells.size())) {
+    // Sparse grid relative to the query: walk occupied cells instead
+    for (auto& [key, cell] : cells) {
+      int cx = static_cast<int32_t>(key >> 32);
+      int cy = static_cast<int32_t>(key & 0xFFFFFFFFu);
+      if (cx < range.minX || cx > range.maxX || cy < range.minY ||
+          cy > range.maxY) {
+        continue;
+      }
+      visit(cx, cy, cell);
+    }
+  } else {
+    for (int cy = range.minY; cy <= range.maxY; ++cy) {
+      for (int cx = range.minX; cx <= range.maxX; ++cx) {
+        auto it = cells.find(cellKey(cx, cy));
+        if (it == cells.end()) continue;
+        visit(cx, cy, it->second);
+      }
+    }
+  }
+
+  for (uint32_t id : oversizedItems) {
+    if (overlaps(items[id].bounds)) out.push_back(id);
+  }
+}
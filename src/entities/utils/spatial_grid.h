@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "entities/bounding_box.h"
+
+// Uniform grid over entity bounding boxes, keyed by handle slot index.
+//
+// Each item is stored in every cell its bounding box overlaps, along with a
+// copy of the box kept next to its id, so a query scans a cell's boxes
+// contiguously and never calls back into the entity. Moving an item within
+// the same cells only refreshes the copies; only crossing a cell boundary
+// touches the cell lists. Items spanning more than MAX_CELLS_PER_ITEM cells
+// are kept in a separate list that every query scans, so a single huge
+// entity can't blow up the grid.
+class SpatialGrid {
+ public:
+  static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+  static constexpr int MAX_CELLS_PER_ITEM = 64;
+
+  explicit SpatialGrid(float cellSize = DEFAULT_CELL_SIZE);
+
+  // Insert or move an item
+  void update(uint32_t id, const BoundingBox& bounds);
+  void remove(uint32_t id);
+  void clear();
+
+  // Append the ids of all items whose box contains / overlaps the query.
+  // Each id is reported once.
+  void queryPoint(float x, float y, std::vector<uint32_t>& out);
+  void queryRect(const BoundingBox& rect, std::vector<uint32_t>& out);
+
+  bool contains(uint32_t id) const {
+    return id < items.size() && items[id].indexed;
+  }
+
+  const BoundingBox& getBounds(uint32_t id) const { return items[id].bounds; }
+
+  size_t getCellCount() const { return cells.size(); }
+
+ private:
+  struct CellRange {
+    int minX = 0, minY = 0, maxX = 0, maxY = 0;
+
+    bool operator==(const CellRange& other) const {
+      return minX == other.minX && minY == other.minY && maxX == other.maxX &&
+             maxY == other.maxY;
+    }
+  };
+
+  // Ids and copies of their boxes, at the same index
+  struct Cell {
+    std::vector<uint32_t> ids;
+    std::vector<BoundingBox> bounds;
+    bool stale = false;  // Some copies are out of date
+  };
+
+  struct Item {
+    BoundingBox bounds{0, 0, 0, 0};
+    CellRange range;
+    // The cell and index of an item in a single cell, so its copy can be
+    // refreshed in place. Multi-cell items mark their cells stale instead.
+    Cell* home = nullptr;
+    uint32_t homeIndex = 0;
+    bool indexed = false;
+    bool oversized = false;
+  };
+
+  float cellSize;
+  float inverseCellSize;
+
+  // Nodes never move, so Item::home stays valid until its cell is erased,
+  // which only happens once the cell is empty
+  std::unordered_map<uint64_t, Cell> cells;
+  std::vector<Item> items;
+  std::vector<uint32_t> oversizedItems;
+  std::vector<uint64_t> staleCells;
+
+  int toCell(float coordinate) const;
+  CellRange cellRange(const BoundingBox& bounds) const;
+
+  static uint64_t cellKey(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+           static_cast<uint32_t>(y);
+  }
+
+  void link(uint32_t id, Item& item);
+  void unlink(uint32_t id, const Item& item);
+  void refreshStaleCells();
+};
@@ -3,17 +3,13 @@
 #include <spdlog/spdlog.h>
 
 #include <cmath>
-#include <random>
 
 #include "core/app_state.h"
 
-static std::mt19937 rng(std::random_device{}());
-static std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
 void WaypointEntity::generateRandomPosition() {
   // Generate a random angle between 0 and 2π
-  float randomAngle = dist(rng) * 2.0f * M_PI;
-  float randomDistance = dist(rng) * 500.0f;  // Random distance up to 500
+  float randomAngle = SDL_randf() * 2.0f * M_PI;
+  float randomDistance = SDL_randf() * 500.0f;  // Random distance up to 500
 
   position1.x = position0.x + cos(randomAngle) * randomDistance;
   position1.y = position0.y + sin(randomAngle) * randomDistance;
@@ -38,23 +34,27 @@ void WaypointEntity::update(float deltaTime) {
   // Interpolate between position0 and position1
   current_position.x = position0.x + t * (position1.x - position0.x);
   current_position.y = position0.y + t * (position1.y - position0.y);
+
+  // Keep the spatial index current so off-screen waypoints get culled
+  notifyMoved();
 }
 
-void WaypointEntity::render(SDL_Renderer* renderer) {
+void WaypointEntity::render(GeometryBatch& batch) {
   if (!visible) return;
 
-  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-  SDL_RenderPoint(renderer, current_position.x, current_position.y);
+  batch.addPoint(current_position, {1.0f, 1.0f, 1.0f, 1.0f});
 }
 
 void WaypointEntity::setPosition(const SDL_FPoint& position) {
   current_position = position;
+  notifyMoved();
 }
 
 void WaypointEntity::setInitialPosition(float x, float y) {
   position0.x = x;
   position0.y = y;
   current_position = position0;
+  notifyMoved();
 
   // Regenerate the random position relative to the new center
   regenerateRandomPosition();
@@ -28,7 +28,9 @@ class WaypointEntity : public Entity, public IPositionable, public IUpdatable {
 
   void update(float deltaTime) override;
 
-  void render(SDL_Renderer* renderer) override;
+  bool hasIndependentUpdate() const override { return true; }
+
+  void render(GeometryBatch& batch) override;
 
   // Entity type identification
   EntityType getEntityType() const override {
@@ -44,6 +46,11 @@ class WaypointEntity : public Entity, public IPositionable, public IUpdatable {
   void setPosition(const SDL_FPoint& position) override;
   SDL_FPoint getPosition() const override;
 
+  BoundingBox getBoundingBox() const override {
+    return BoundingBox(current_position.x, current_position.y,
+                       current_position.x, current_position.y);
+  }
+
   void setInitialPosition(float x, float y);
 
   void regenerateRandomPosition();
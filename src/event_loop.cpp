@@ -3,8 +3,14 @@
 #include <spdlog/spdlog.h>
 
 #include "systems/animation_system.h"
+#include "systems/audio_binding_system.h"
 #include "systems/input_system.h"
 
+static float millisecondsSince(Uint64 start) {
+  return static_cast<float>((double)(SDL_GetPerformanceCounter() - start) *
+                            1000.0 / SDL_GetPerformanceFrequency());
+}
+
 EventLoop::EventLoop() {
   try {
     this->context = std::make_unique<Context>();
@@ -30,17 +36,7 @@ void EventLoop::run() {
     double deltaTime = (double)(now - last) / freq;
     last = now;
 
-    this->HandleInputEvents();
-
-    this->accumulator += deltaTime;
-    while (this->accumulator >= FIXED_TIMESTEP) {
-      this->updateEvents(FIXED_TIMESTEP);
-      this->accumulator -= FIXED_TIMESTEP;
-    }
-
-    this->updateFPS(deltaTime);
-
-    this->render();
+    this->runFrame(deltaTime);
 
     // Calculate target frame time each frame to respond to FPS changes
     double targetFrameTime =
@@ -58,6 +54,32 @@ void EventLoop::run() {
   }
 }
 
+/**
+ * @brief Runs one frame: input, fixed-timestep updates and rendering.
+ *
+ * @param deltaTime The time since the last frame.
+ */
+void EventLoop::runFrame(double deltaTime) {
+  Uint64 frameStart = SDL_GetPerformanceCounter();
+
+  this->HandleInputEvents();
+  this->frameTimings.inputMs = millisecondsSince(frameStart);
+
+  Uint64 updateStart = SDL_GetPerformanceCounter();
+  this->accumulator += deltaTime;
+  while (this->accumulator >= FIXED_TIMESTEP) {
+    this->updateEvents(FIXED_TIMESTEP);
+    this->accumulator -= FIXED_TIMESTEP;
+  }
+  this->frameTimings.updateMs = millisecondsSince(updateStart);
+
+  this->updateFPS(deltaTime);
+
+  this->render();
+
+  this->frameTimings.frameMs = millisecondsSince(frameStart);
+}
+
 /**
  * @brief Handles all input events (keyboard, mouse, etc.).
  */
@@ -89,12 +111,19 @@ void EventLoop::HandleInputEvents() {
 void EventLoop::updateEvents(float deltaTime) {
   this->appState->inputSystem->update();
   this->appState->animationSystem->update(deltaTime);
+
+  Uint64 updateStart = SDL_GetPerformanceCounter();
   this->appState->entityManager.update(deltaTime);
+  this->entityUpdateMs = millisecondsSince(updateStart);
 
   // Update audio visualization data
   if (this->appState->audioSystem) {
     this->appState->audioSystem->updateVisualizationData();
     this->appState->audioSystem->updatePlayback();
+
+    // Drive bound entity parameters from the analysis just picked up
+    this->appState->audioBindingSystem->update(
+        this->appState->audioSystem->getVisualizationData(), deltaTime);
   }
 }
 
@@ -110,6 +139,8 @@ void EventLoop::updateFPS(float deltaTime) {
 }
 
 void EventLoop::render() {
+  Uint64 renderStart = SDL_GetPerformanceCounter();
+
   // Clear the renderer at the start of each frame
   SDL_SetRenderScale(this->appState->context->renderer,
                      this->appState->io->DisplayFramebufferScale.x,
@@ -119,23 +150,35 @@ void EventLoop::render() {
   SDL_RenderClear(this->appState->context->renderer);
 
   // Render entities
+  Uint64 entitiesStart = SDL_GetPerformanceCounter();
   this->appState->entityManager.render(this->appState->context->renderer);
+  this->entityRenderMs = millisecondsSince(entitiesStart);
 
   if (this->ui->debug.isDebugFramesEnabled()) {
     this->renderDebugFrames();
   }
+  this->frameTimings.renderMs = millisecondsSince(renderStart);
 
+  Uint64 uiStart = SDL_GetPerformanceCounter();
   this->ui->render();
+  this->frameTimings.uiMs = millisecondsSince(uiStart);
 
+  Uint64 presentStart = SDL_GetPerformanceCounter();
   SDL_RenderPresent(this->appState->context->renderer);
+  this->frameTimings.presentMs = millisecondsSince(presentStart);
 }
 
 void EventLoop::renderDebugFrames() {
   // Set green color for debug frames
   SDL_SetRenderDrawColor(this->appState->context->renderer, 0, 255, 0, 255);
 
-  // Get all entities and draw debug frames around them
-  auto entities = this->appState->entityManager.getAllEntities();
+  // Draw debug frames around the entities that are on screen
+  std::vector<Entity*> entities;
+  this->appState->entityManager.queryRect(
+      this->appState->entityManager.getViewport(), entities);
+
+  // Debug text from every entity goes out in a single batch
+  this->appState->renderer.beginText();
 
   for (auto* entity : entities) {
     if (entity->isVisible()) {
@@ -153,6 +196,8 @@ void EventLoop::renderDebugFrames() {
       }
     }
   }
+
+  this->appState->renderer.endText();
 }
 
 void EventLoop::renderDebugInfo(Entity* entity) {
@@ -11,6 +11,16 @@
 #include "entities/entity.h"
 #include "ui/ui.h"
 
+// Wall-clock time spent in each phase of one frame, in milliseconds
+struct FrameTimings {
+  float inputMs = 0.0f;    // Event polling and input handling
+  float updateMs = 0.0f;   // All fixed-timestep updates run this frame
+  float renderMs = 0.0f;   // Clearing and submitting entity geometry
+  float uiMs = 0.0f;       // Building and submitting the ImGui frame
+  float presentMs = 0.0f;  // SDL_RenderPresent
+  float frameMs = 0.0f;    // Whole frame, excluding the frame limiter
+};
+
 class EventLoop {
  private:
   std::unique_ptr<Context> context;
@@ -30,12 +40,22 @@ class EventLoop {
   int frameCount = 0;
   float fpsUpdateTimer = 0.0f;
 
+  // Time spent in EntityManager::update / render, in milliseconds
+  float entityUpdateMs = 0.0f;
+  float entityRenderMs = 0.0f;
+
+  FrameTimings frameTimings;
+
  public:
   EventLoop();
   ~EventLoop() = default;
 
   void run();
 
+  // Process input, run the fixed-timestep updates covered by `deltaTime`
+  // and render one frame. run() calls this once per iteration.
+  void runFrame(double deltaTime);
+
   void stop() { running = false; }
 
   // Set target rendering FPS (0 = unlimited)
@@ -47,6 +67,16 @@ class EventLoop {
   // Get current FPS
   float getFPS() const { return fps; }
 
+  // Get time spent updating / rendering entities in the last frame
+  float getEntityUpdateMs() const { return entityUpdateMs; }
+
+  float getEntityRenderMs() const { return entityRenderMs; }
+
+  // Phase timings of the last runFrame()
+  const FrameTimings& getFrameTimings() const { return frameTimings; }
+
+  AppState* getAppState() const { return appState.get(); }
+
  private:
   void HandleInputEvents();
   void updateEvents(float deltaTime);
@@ -0,0 +1,160 @@
+#include "geometry_batch.h"
+
+#include <cmath>
+
+static const int QUAD_INDICES[6] = {0, 1, 2, 0, 2, 3};
+
+void GeometryBatch::begin(SDL_Renderer* renderer) {
+  this->renderer = renderer;
+  texture = nullptr;
+  vertices.clear();
+  indices.clear();
+  stats = Stats{};
+
+  SDL_GetRenderDrawBlendMode(renderer, &initialBlendMode);
+  blendMode = initialBlendMode;
+}
+
+void GeometryBatch::end() {
+  flush();
+  SDL_SetRenderDrawBlendMode(renderer, initialBlendMode);
+  texture = nullptr;
+}
+
+void GeometryBatch::flush() {
+  if (indices.empty()) {
+    vertices.clear();
+    return;
+  }
+
+  // Untextured geometry is blended with the renderer's draw blend mode
+  SDL_SetRenderDrawBlendMode(renderer, blendMode);
+  SDL_RenderGeometry(renderer, texture, vertices.data(),
+                     static_cast<int>(vertices.size()), indices.data(),
+                     static_cast<int>(indices.size()));
+
+  stats.drawCalls++;
+  stats.vertices += vertices.size();
+  stats.indices += indices.size();
+
+  vertices.clear();
+  indices.clear();
+}
+
+void GeometryBatch::setTexture(SDL_Texture* texture) {
+  if (texture == this->texture) return;
+
+  flush();
+  this->texture = texture;
+}
+
+void GeometryBatch::setBlendMode(SDL_BlendMode blendMode) {
+  if (blendMode == this->blendMode) return;
+
+  flush();
+  this->blendMode = blendMode;
+}
+
+int GeometryBatch::reserveVertices(size_t vertexCount) {
+  if (vertices.size() + vertexCount > MAX_VERTICES) {
+    flush();
+  }
+  return static_cast<int>(vertices.size());
+}
+
+void GeometryBatch::addGeometry(const SDL_Vertex* vertices, int vertexCount,
+                                const int* indices, int indexCount) {
+  int base = reserveVertices(vertexCount);
+
+  this->vertices.insert(this->vertices.end(), vertices,
+                        vertices + vertexCount);
+  for (int i = 0; i < indexCount; i++) {
+    this->indices.push_back(base + indices[i]);
+  }
+}
+
+void GeometryBatch::addTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c,
+                                SDL_FColor color) {
+  int base = reserveVertices(3);
+
+  vertices.push_back({a, color, {0.0f, 0.0f}});
+  vertices.push_back({b, color, {0.0f, 0.0f}});
+  vertices.push_back({c, color, {0.0f, 0.0f}});
+  indices.push_back(base);
+  indices.push_back(base + 1);
+  indices.push_back(base + 2);
+}
+
+void GeometryBatch::addQuad(const SDL_FPoint* corners, SDL_FColor color) {
+  int base = reserveVertices(4);
+
+  for (int i = 0; i < 4; i++) {
+    vertices.push_back({corners[i], color, {0.0f, 0.0f}});
+  }
+  for (int i = 0; i < 6; i++) {
+    indices.push_back(base + QUAD_INDICES[i]);
+  }
+}
+
+void GeometryBatch::addRect(const SDL_FRect& rect, SDL_FColor color) {
+  const SDL_FPoint corners[4] = {{rect.x, rect.y},
+                                 {rect.x + rect.w, rect.y},
+                                 {rect.x + rect.w, rect.y + rect.h},
+                                 {rect.x, rect.y + rect.h}};
+  addQuad(corners, color);
+}
+
+void GeometryBatch::addTexturedRect(const SDL_FRect& rect, const SDL_FRect& uv,
+                                    SDL_FColor color) {
+  int base = reserveVertices(4);
+
+  vertices.push_back({{rect.x, rect.y}, color, {uv.x, uv.y}});
+  vertices.push_back({{rect.x + rect.w, rect.y}, color, {uv.x + uv.w, uv.y}});
+  vertices.push_back({{rect.x + rect.w, rect.y + rect.h},
+                      color,
+                      {uv.x + uv.w, uv.y + uv.h}});
+  vertices.push_back({{rect.x, rect.y + rect.h}, color, {uv.x, uv.y + uv.h}});
+  for (int i = 0; i < 6; i++) {
+    indices.push_back(base + QUAD_INDICES[i]);
+  }
+}
+
+void GeometryBatch::addRectOutline(const SDL_FRect& rect, SDL_FColor color) {
+  addRect({rect.x, rect.y, rect.w, 1.0f}, color);
+  addRect({rect.x, rect.y + rect.h - 1.0f, rect.w, 1.0f}, color);
+  addRect({rect.x, rect.y + 1.0f, 1.0f, rect.h - 2.0f}, color);
+  addRect({rect.x + rect.w - 1.0f, rect.y + 1.0f, 1.0f, rect.h - 2.0f},
+          color);
+}
+
+void GeometryBatch::addLine(SDL_FPoint start, SDL_FPoint end,
+                            SDL_FColor color, float thickness) {
+  float dx = end.x - start.x;
+  float dy = end.y - start.y;
+  float length = sqrtf(dx * dx + dy * dy);
+  if (length == 0.0f) {
+    addPoint(start, color);
+    return;
+  }
+
+  // Offset both endpoints half the thickness along the segment's normal
+  float nx = -dy / length * thickness / 2.0f;
+  float ny = dx / length * thickness / 2.0f;
+
+  const SDL_FPoint corners[4] = {{start.x + nx, start.y + ny},
+                                 {end.x + nx, end.y + ny},
+                                 {end.x - nx, end.y - ny},
+                                 {start.x - nx, start.y - ny}};
+  addQuad(corners, color);
+}
+
+void GeometryBatch::addLines(const SDL_FPoint* points, int count,
+                             SDL_FColor color, float thickness) {
+  for (int i = 0; i + 1 < count; i++) {
+    addLine(points[i], points[i + 1], color, thickness);
+  }
+}
+
+void GeometryBatch::addPoint(SDL_FPoint point, SDL_FColor color) {
+  addRect({point.x, point.y, 1.0f, 1.0f}, color);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <vector>
+
+inline SDL_FColor toFColor(const SDL_Color& color) {
+  return SDL_FColor{color.r / 255.0f, color.g / 255.0f, color.b / 255.0f,
+                    color.a / 255.0f};
+}
+
+// Collects a frame's worth of 2D geometry and submits it with as few
+// SDL_RenderGeometry calls as possible.
+//
+// Everything - filled shapes, lines and points - is emitted as triangles
+// into one stream, so submission order (and thus painter's-algorithm
+// layering) is preserved across shape kinds. The pending geometry is only
+// flushed when the texture or blend mode changes, when the buffer reaches
+// MAX_VERTICES, or at end().
+class GeometryBatch {
+ public:
+  struct Stats {
+    size_t drawCalls = 0;  // SDL_RenderGeometry calls issued
+    size_t vertices = 0;   // Vertices submitted
+    size_t indices = 0;    // Indices submitted
+  };
+
+  // Vertex count at which pending geometry is flushed early, to bound the
+  // size of a single submission
+  static constexpr size_t MAX_VERTICES = 1 << 16;
+
+  // Start a frame. Resets the stats and picks up the renderer's current
+  // draw blend mode.
+  void begin(SDL_Renderer* renderer);
+
+  // Flush remaining geometry and restore the renderer's blend mode
+  void end();
+
+  // Submit pending geometry now. Call before drawing directly through
+  // getRenderer() so the direct draw lands on top of what was batched.
+  void flush();
+
+  void setTexture(SDL_Texture* texture);
+  void setBlendMode(SDL_BlendMode blendMode);
+
+  // Append raw vertices and indices. Indices are relative to `vertices`.
+  void addGeometry(const SDL_Vertex* vertices, int vertexCount,
+                   const int* indices, int indexCount);
+
+  void addTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FColor color);
+
+  // Quad with corners in winding order
+  void addQuad(const SDL_FPoint* corners, SDL_FColor color);
+
+  void addRect(const SDL_FRect& rect, SDL_FColor color);
+
+  // Rectangle sampling `uv` (normalized) from the current texture, tinted by
+  // `color`
+  void addTexturedRect(const SDL_FRect& rect, const SDL_FRect& uv,
+                       SDL_FColor color);
+
+  // One-pixel outline inside the rectangle, like SDL_RenderRect
+  void addRectOutline(const SDL_FRect& rect, SDL_FColor color);
+
+  // Line segment drawn as a quad of the given thickness
+  void addLine(SDL_FPoint start, SDL_FPoint end, SDL_FColor color,
+               float thickness = 1.0f);
+
+  // Connected segments through `count` points, like SDL_RenderLines
+  void addLines(const SDL_FPoint* points, int count, SDL_FColor color,
+                float thickness = 1.0f);
+
+  // Single pixel, like SDL_RenderPoint
+  void addPoint(SDL_FPoint point, SDL_FColor color);
+
+  SDL_Renderer* getRenderer() const { return renderer; }
+
+  // Totals since the last begin()
+  const Stats& getStats() const { return stats; }
+
+ private:
+  SDL_Renderer* renderer = nullptr;
+  SDL_Texture* texture = nullptr;
+  SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+  SDL_BlendMode initialBlendMode = SDL_BLENDMODE_NONE;
+
+  std::vector<SDL_Vertex> vertices;
+  std::vector<int> indices;
+
+  Stats stats;
+
+  // Make room for `vertexCount` more vertices, flushing if the batch would
+  // grow past MAX_VERTICES. Returns the index of the first new vertex.
+  int reserveVertices(size_t vertexCount);
+};
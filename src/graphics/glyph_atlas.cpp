@@ -0,0 +1,126 @@
+#include "glyph_atlas.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+GlyphAtlas::~GlyphAtlas() { destroy(); }
+
+void GlyphAtlas::destroy() {
+  if (texture) {
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+  }
+}
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, TTF_Font* font) {
+  destroy();
+
+  const SDL_Color white = {255, 255, 255, 255};
+
+  // Render every glyph up front so the cell size is known before packing
+  std::array<SDL_Surface*, GLYPH_COUNT> surfaces{};
+  int cellWidth = 0;
+  int cellHeight = TTF_GetFontHeight(font);
+
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    Uint32 ch = FIRST_GLYPH + static_cast<Uint32>(i);
+    surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+    if (!surfaces[i]) continue;
+
+    cellWidth = std::max(cellWidth, surfaces[i]->w);
+    cellHeight = std::max(cellHeight, surfaces[i]->h);
+  }
+
+  const int rows =
+      static_cast<int>((GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS);
+  const int cellStrideX = cellWidth + CELL_GUTTER;
+  const int cellStrideY = cellHeight + CELL_GUTTER;
+  const int atlasWidth = cellStrideX * ATLAS_COLUMNS + CELL_GUTTER;
+  const int atlasHeight = cellStrideY * rows + CELL_GUTTER;
+
+  SDL_Surface* atlas =
+      SDL_CreateSurface(atlasWidth, atlasHeight, SDL_PIXELFORMAT_RGBA32);
+  if (!atlas) {
+    SPDLOG_ERROR("Couldn't create glyph atlas surface: {}", SDL_GetError());
+    for (SDL_Surface* surface : surfaces) SDL_DestroySurface(surface);
+    return false;
+  }
+  SDL_FillSurfaceRect(atlas, nullptr, 0);
+
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    Glyph& glyph = glyphs[i];
+    Uint32 ch = FIRST_GLYPH + static_cast<Uint32>(i);
+
+    int advance = 0;
+    TTF_GetGlyphMetrics(font, ch, nullptr, nullptr, nullptr, nullptr,
+                        &advance);
+    glyph.advance = static_cast<float>(advance);
+
+    SDL_Surface* surface = surfaces[i];
+    if (!surface) continue;
+
+    SDL_Rect cell = {
+        CELL_GUTTER + static_cast<int>(i % ATLAS_COLUMNS) * cellStrideX,
+        CELL_GUTTER + static_cast<int>(i / ATLAS_COLUMNS) * cellStrideY,
+        surface->w, surface->h};
+
+    // Copy coverage as-is rather than blending onto the transparent atlas
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(surface, nullptr, atlas, &cell);
+    SDL_DestroySurface(surface);
+
+    glyph.uv = {static_cast<float>(cell.x) / atlasWidth,
+                static_cast<float>(cell.y) / atlasHeight,
+                static_cast<float>(cell.w) / atlasWidth,
+                static_cast<float>(cell.h) / atlasHeight};
+    glyph.width = static_cast<float>(cell.w);
+    glyph.height = static_cast<float>(cell.h);
+  }
+
+  texture = SDL_CreateTextureFromSurface(renderer, atlas);
+  SDL_DestroySurface(atlas);
+  if (!texture) {
+    SPDLOG_ERROR("Couldn't create glyph atlas texture: {}", SDL_GetError());
+    return false;
+  }
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+  lineHeight = static_cast<float>(TTF_GetFontHeight(font));
+
+  SPDLOG_INFO("Glyph atlas built: {}x{}", atlasWidth, atlasHeight);
+  return true;
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::lookup(char c) const {
+  Uint32 ch = static_cast<unsigned char>(c);
+  if (ch < FIRST_GLYPH || ch > LAST_GLYPH) {
+    ch = '?';
+  }
+  return glyphs[ch - FIRST_GLYPH];
+}
+
+void GlyphAtlas::addText(GeometryBatch& batch, std::string_view text,
+                         float x, float y, SDL_FColor color) const {
+  if (!texture) return;
+
+  batch.setTexture(texture);
+
+  float penX = x;
+  for (char c : text) {
+    const Glyph& glyph = lookup(c);
+    if (c != ' ' && glyph.width > 0) {
+      batch.addTexturedRect({penX, y, glyph.width, glyph.height}, glyph.uv,
+                            color);
+    }
+    penX += glyph.advance;
+  }
+}
+
+float GlyphAtlas::measure(std::string_view text) const {
+  float width = 0.0f;
+  for (char c : text) {
+    width += lookup(c).advance;
+  }
+  return width;
+}
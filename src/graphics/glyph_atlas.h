@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include <array>
+#include <string_view>
+
+#include "geometry_batch.h"
+
+// Printable ASCII rasterized once into a single texture.
+//
+// Text is then drawn as one textured quad per character, appended to a
+// GeometryBatch, so any amount of text costs one draw call per batch
+// flush instead of a surface and texture per string. Glyphs are rendered
+// white and tinted through the vertex color.
+class GlyphAtlas {
+ public:
+  static constexpr Uint32 FIRST_GLYPH = 32;  // ' '
+  static constexpr Uint32 LAST_GLYPH = 126;  // '~'
+
+  struct Glyph {
+    SDL_FRect uv;     // Normalized source rectangle in the atlas
+    float width = 0;  // Size of the glyph's cell, in pixels
+    float height = 0;
+    float advance = 0;  // Pen movement after this glyph
+  };
+
+  GlyphAtlas() = default;
+  ~GlyphAtlas();
+
+  GlyphAtlas(const GlyphAtlas&) = delete;
+  GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+  // Rasterize the glyphs of `font`, replacing any previous atlas. Returns
+  // false if SDL_ttf or texture creation fails.
+  bool build(SDL_Renderer* renderer, TTF_Font* font);
+  void destroy();
+
+  bool isBuilt() const { return texture != nullptr; }
+
+  // Append quads for `text` with its top-left corner at (x, y). Characters
+  // outside the atlas are drawn as '?'.
+  void addText(GeometryBatch& batch, std::string_view text, float x, float y,
+               SDL_FColor color) const;
+
+  // Width of `text` in pixels
+  float measure(std::string_view text) const;
+
+  float getLineHeight() const { return lineHeight; }
+
+  SDL_Texture* getTexture() const { return texture; }
+
+ private:
+  static constexpr size_t GLYPH_COUNT = LAST_GLYPH - FIRST_GLYPH + 1;
+  static constexpr int ATLAS_COLUMNS = 16;
+
+  // Transparent pixels between cells and around the edge, so linear
+  // filtering of a scaled glyph never picks up its neighbours
+  static constexpr int CELL_GUTTER = 1;
+
+  SDL_Texture* texture = nullptr;
+  float lineHeight = 0.0f;
+  std::array<Glyph, GLYPH_COUNT> glyphs{};
+
+  const Glyph& lookup(char c) const;
+};
@@ -2,35 +2,54 @@
 
 #include "spdlog/spdlog.h"
 
-void Renderer::renderText(const std::string& text, int x, int y,
-                          SDL_Color color) {
+void Renderer::setRenderer(SDL_Renderer* renderer) {
+  // Textures belong to a renderer, so the atlas must be rebuilt
+  glyphAtlas.destroy();
+  this->renderer = renderer;
+}
+
+void Renderer::setFont(std::shared_ptr<TTF_Font> font) {
+  glyphAtlas.destroy();
+  this->font = font;
+}
+
+bool Renderer::ensureGlyphAtlas() {
   // Check if font is loaded
   if (!this->font.get()) {
     SPDLOG_WARN("Font not loaded, skipping text rendering");
-    return;
+    return false;
   }
 
-  SDL_Surface* text_surface = TTF_RenderText_Blended(
-      this->font.get(), text.c_str(), text.length(), color);
-  if (!text_surface) {
-    SPDLOG_ERROR("Couldn't render text: %s", SDL_GetError());
-    return;
+  if (!glyphAtlas.isBuilt()) {
+    return glyphAtlas.build(this->renderer, this->font.get());
   }
+  return true;
+}
 
-  SDL_Texture* text_texture =
-      SDL_CreateTextureFromSurface(this->renderer, text_surface);
-  if (!text_texture) {
-    SPDLOG_ERROR("Couldn't create texture from surface: %s", SDL_GetError());
-    SDL_DestroySurface(text_surface);
+void Renderer::beginText() {
+  textBatch.begin(this->renderer);
+  textBatchOpen = true;
+}
+
+void Renderer::endText() {
+  textBatch.end();
+  textBatchOpen = false;
+}
+
+void Renderer::renderText(const std::string& text, int x, int y,
+                          SDL_Color color) {
+  if (!ensureGlyphAtlas()) return;
+
+  if (textBatchOpen) {
+    glyphAtlas.addText(textBatch, text, static_cast<float>(x),
+                       static_cast<float>(y), toFColor(color));
     return;
   }
 
-  SDL_FRect dest_rect = {(float)x, (float)y, (float)text_surface->w,
-                         (float)text_surface->h};
-  SDL_RenderTexture(this->renderer, text_texture, nullptr, &dest_rect);
-
-  SDL_DestroySurface(text_surface);
-  SDL_DestroyTexture(text_texture);
+  beginText();
+  glyphAtlas.addText(textBatch, text, static_cast<float>(x),
+                     static_cast<float>(y), toFColor(color));
+  endText();
 }
 
 void Renderer::clear() { SDL_RenderClear(renderer); }
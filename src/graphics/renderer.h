@@ -6,25 +6,47 @@
 #include <string>
 
 #include "SDL3_ttf/SDL_ttf.h"
+#include "geometry_batch.h"
+#include "glyph_atlas.h"
 
 class Renderer {
  private:
   SDL_Renderer* renderer;
   std::shared_ptr<TTF_Font> font;
 
+  // Built lazily from `font` on first use
+  GlyphAtlas glyphAtlas;
+
+  // Text drawn between beginText() and endText() is queued here
+  GeometryBatch textBatch;
+  bool textBatchOpen = false;
+
+  bool ensureGlyphAtlas();
+
  public:
   Renderer() : renderer(nullptr), font(nullptr) {}
 
   Renderer(SDL_Renderer* renderer, std::shared_ptr<TTF_Font> font)
       : renderer(renderer), font(font) {}
 
-  void setRenderer(SDL_Renderer* renderer) { this->renderer = renderer; }
+  void setRenderer(SDL_Renderer* renderer);
 
-  void setFont(std::shared_ptr<TTF_Font> font) { this->font = font; }
+  void setFont(std::shared_ptr<TTF_Font> font);
 
+  // Draw text from the glyph atlas. Between beginText() and endText() the
+  // glyphs are batched and submitted together; otherwise they are drawn
+  // immediately.
   void renderText(const std::string& text, int x, int y,
                   SDL_Color color = {255, 255, 255, 255});
 
+  void beginText();
+  void endText();
+
+  // Draw calls and vertices used by the last endText()
+  const GeometryBatch::Stats& getTextStats() const {
+    return textBatch.getStats();
+  }
+
   void clear();
   void present();
 
@@ -2,13 +2,29 @@
 #include <spdlog/spdlog.h>
 
 #include <memory>
+#include <string>
 
+#include "bench/benchmark.h"
 #include "core/constants.h"
 #include "event_loop.h"
 
-int main() {
+int main(int argc, char* argv[]) {
   spdlog::set_pattern("[%D %H:%M:%S %z] [%^%l%$] %v");
 
+  BenchmarkOptions benchOptions;
+  bool benchRequested = false;
+  std::string argError;
+  if (!parseBenchmarkArgs(argc, argv, benchOptions, benchRequested,
+                          argError)) {
+    SPDLOG_ERROR("{}", argError);
+    SPDLOG_INFO("Benchmark scenarios:\n{}", getBenchmarkScenarioList());
+    return -1;
+  }
+
+  if (benchRequested) {
+    configureHeadlessSDL();
+  }
+
   SDL_SetAppMetadata(APPLICATION_TITLE.c_str(), VERSION_STRING.c_str(),
                      APPLICATION_IDENTIFIER.c_str());
 
@@ -18,6 +34,12 @@ int main() {
   }
 
   try {
+    if (benchRequested) {
+      int result = runBenchmark(benchOptions);
+      SDL_Quit();
+      return result;
+    }
+
     std::unique_ptr<EventLoop> event_loop = std::make_unique<EventLoop>();
     event_loop->setTargetFPS(TARGET_FRAME_RATE);
     event_loop->run();
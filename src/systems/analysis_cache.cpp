@@ -0,0 +1,156 @@
+#include "analysis_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+namespace {
+
+const char SIDECAR_MAGIC[8] = {'S', 'D', 'L', 'A', 'N', 'L', 'Y', 'Z'};
+const uint32_t SIDECAR_VERSION = 1;
+
+struct SidecarHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t frameBytes;  // sizeof(Frame), so a layout change is caught
+  uint64_t sourceBytes;
+  int64_t sourceModified;
+  uint32_t sampleRate;
+  uint32_t fftSize;
+  uint32_t hopSize;
+  uint32_t frameCount;
+  uint32_t beatCount;
+  uint32_t reserved;
+  double tempo;
+};
+
+static_assert(std::is_trivially_copyable_v<AnalysisCache::Frame>);
+static_assert(std::is_trivially_copyable_v<AnalysisCache::Beat>);
+
+// Size and modification time of the audio file, to tell when a sidecar is
+// stale
+bool getSourceStamp(const std::string& audioPath, uint64_t& bytes,
+                    int64_t& modified) {
+  std::error_code error;
+  auto size = std::filesystem::file_size(audioPath, error);
+  if (error) return false;
+  auto time = std::filesystem::last_write_time(audioPath, error);
+  if (error) return false;
+
+  bytes = static_cast<uint64_t>(size);
+  modified = static_cast<int64_t>(time.time_since_epoch().count());
+  return true;
+}
+
+}  // namespace
+
+std::string AnalysisCache::getSidecarPath(const std::string& audioPath) {
+  return audioPath + ".analysis";
+}
+
+void AnalysisCache::clear() {
+  sampleRate = 0;
+  fftSize = 0;
+  hopSize = 0;
+  tempo = 0.0;
+  frames.clear();
+  beats.clear();
+}
+
+bool AnalysisCache::load(const std::string& audioPath) {
+  clear();
+
+  uint64_t sourceBytes = 0;
+  int64_t sourceModified = 0;
+  if (!getSourceStamp(audioPath, sourceBytes, sourceModified)) return false;
+
+  const std::string sidecarPath = getSidecarPath(audioPath);
+  std::error_code error;
+  const uint64_t sidecarBytes = std::filesystem::file_size(sidecarPath, error);
+  if (error) return false;
+
+  std::ifstream file(sidecarPath, std::ios::binary);
+  if (!file) return false;
+
+  SidecarHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) != 0 ||
+      header.version != SIDECAR_VERSION ||
+      header.frameBytes != sizeof(Frame) ||
+      header.sourceBytes != sourceBytes ||
+      header.sourceModified != sourceModified || header.hopSize == 0 ||
+      header.frameCount == 0) {
+    return false;
+  }
+
+  // The counts come from disk, so a truncated or corrupt sidecar must not
+  // get to size the allocations
+  const uint64_t payloadBytes =
+      static_cast<uint64_t>(header.frameCount) * sizeof(Frame) +
+      static_cast<uint64_t>(header.beatCount) * sizeof(Beat);
+  if (sidecarBytes - sizeof(header) != payloadBytes) return false;
+
+  frames.resize(header.frameCount);
+  beats.resize(header.beatCount);
+  file.read(reinterpret_cast<char*>(frames.data()),
+            static_cast<std::streamsize>(frames.size() * sizeof(Frame)));
+  file.read(reinterpret_cast<char*>(beats.data()),
+            static_cast<std::streamsize>(beats.size() * sizeof(Beat)));
+
+  // Beats index into frames and are searched by hop
+  bool beatsValid = true;
+  for (size_t i = 0; i < beats.size() && beatsValid; ++i) {
+    beatsValid = beats[i].hop < header.frameCount &&
+                 (i == 0 || beats[i - 1].hop < beats[i].hop);
+  }
+  if (!file || !beatsValid) {
+    clear();
+    return false;
+  }
+
+  sampleRate = static_cast<int>(header.sampleRate);
+  fftSize = static_cast<int>(header.fftSize);
+  hopSize = static_cast<int>(header.hopSize);
+  tempo = header.tempo;
+  return true;
+}
+
+bool AnalysisCache::save(const std::string& audioPath) const {
+  SidecarHeader header{};
+  std::memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+  header.version = SIDECAR_VERSION;
+  header.frameBytes = sizeof(Frame);
+  if (!getSourceStamp(audioPath, header.sourceBytes, header.sourceModified)) {
+    return false;
+  }
+  header.sampleRate = static_cast<uint32_t>(sampleRate);
+  header.fftSize = static_cast<uint32_t>(fftSize);
+  header.hopSize = static_cast<uint32_t>(hopSize);
+  header.frameCount = static_cast<uint32_t>(frames.size());
+  header.beatCount = static_cast<uint32_t>(beats.size());
+  header.tempo = tempo;
+
+  std::ofstream file(getSidecarPath(audioPath),
+                     std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(frames.data()),
+             static_cast<std::streamsize>(frames.size() * sizeof(Frame)));
+  file.write(reinterpret_cast<const char*>(beats.data()),
+             static_cast<std::streamsize>(beats.size() * sizeof(Beat)));
+  return static_cast<bool>(file);
+}
+
+size_t AnalysisCache::getHopIndex(int64_t frame) const {
+  if (frames.empty() || frame <= 0 || hopSize <= 0) return 0;
+  return std::min(static_cast<size_t>(frame / hopSize), frames.size() - 1);
+}
+
+const AnalysisCache::Beat* AnalysisCache::findNextBeat(size_t hop) const {
+  auto it = std::upper_bound(
+      beats.begin(), beats.end(), hop,
+      [](size_t value, const Beat& beat) { return value < beat.hop; });
+  return it != beats.end() ? &*it : nullptr;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Precomputed per-hop analysis of a whole track
+ *
+ * Built once by AudioSystem's batch analysis and saved next to the audio
+ * file as a binary sidecar, so later playthroughs look features up by hop
+ * index instead of running FFTs, and can see beats before they happen.
+ *
+ * The sidecar records the audio file's size and modification time and is
+ * ignored once either changes. It is written in host byte order.
+ */
+struct AnalysisCache {
+  /** @brief Features of one hop, for the window centred on its first frame */
+  struct Frame {
+    static constexpr int BAND_COUNT = 5;
+
+    float bandLevels[BAND_COUNT];
+    float centroid;
+    float rolloff;
+    float flux;
+    float smoothedFlux;  // EMA of flux, as beat detection sees it
+    float rmsEnergy;
+    float peak;
+  };
+
+  struct Beat {
+    uint32_t hop;
+    float intensity;  // How far the flux cleared the threshold, in [0, 1]
+  };
+
+  /** @brief Sidecar path for an audio file */
+  static std::string getSidecarPath(const std::string& audioPath);
+
+  /** @brief Empty the cache, so isLoaded() is false */
+  void clear();
+
+  /**
+   * @brief Read the sidecar for `audioPath`. Fails, leaving the cache
+   * empty, if there is none or it no longer matches the audio file.
+   */
+  bool load(const std::string& audioPath);
+
+  /** @brief Write the sidecar for `audioPath`, stamped with its size and
+   * modification time */
+  bool save(const std::string& audioPath) const;
+
+  bool isLoaded() const { return !frames.empty(); }
+
+  int sampleRate = 0;
+  int fftSize = 0;
+  int hopSize = 0;
+  double tempo = 0.0;  // Beats per minute, 0 if no tempo was found
+
+  std::vector<Frame> frames;  // One per hop
+  std::vector<Beat> beats;    // Sorted by hop
+
+  /** @brief Hop containing `frame`, clamped to the cached range */
+  size_t getHopIndex(int64_t frame) const;
+
+  double getHopTime(size_t hop) const {
+    return sampleRate > 0 ? static_cast<double>(hop) * hopSize / sampleRate
+                          : 0.0;
+  }
+
+  /** @brief First beat at a hop after `hop`, or nullptr */
+  const Beat* findNextBeat(size_t hop) const;
+};
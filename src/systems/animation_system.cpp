@@ -5,50 +5,95 @@
 #include <algorithm>
 
 void AnimationSystem::update(float deltaTime) {
-  // Remove finished animations
-  animations.erase(std::remove_if(animations.begin(), animations.end(),
-                                  [](const std::shared_ptr<Animation>& anim) {
-                                    return anim->isFinished() &&
-                                           !anim->isLooping();
-                                  }),
-                   animations.end());
-
-  // Update all active animations
-  for (auto& animation : animations) {
-    animation->update(deltaTime);
-
-    // Handle looping animations
-    if (animation->isFinished() && animation->isLooping()) {
-      animation->reset();
-    }
+  for (auto& pool : pools) {
+    if (pool) pool->update(deltaTime, appState->entityManager, expired);
+  }
+
+  // Removal swaps within the pools, so it waits until they are all done
+  for (Animation* animation : expired) {
+    remove(animation);
+  }
+  expired.clear();
+
+  tweens.update(deltaTime);
+}
+
+void AnimationSystem::removeAnimation(
+    const std::shared_ptr<Animation>& animation) {
+  if (animation && contains(animation.get())) {
+    remove(animation.get());
   }
 }
 
-void AnimationSystem::addAnimation(std::shared_ptr<Animation> animation) {
-  if (animation) {
-    animations.push_back(animation);
+void AnimationSystem::clear() {
+  for (auto& pool : pools) {
+    if (pool) pool->clear();
   }
+  entityAnimations.clear();
+  expired.clear();
+  animationCount = 0;
+  tweens.clear();
 }
 
-void AnimationSystem::removeAnimation(std::shared_ptr<Animation> animation) {
-  auto it = std::find(animations.begin(), animations.end(), animation);
+const std::vector<std::shared_ptr<Animation>>&
+AnimationSystem::getAnimationsForEntity(EntityHandle entity) const {
+  static const std::vector<std::shared_ptr<Animation>> none;
 
-  if (it != animations.end()) {
-    animations.erase(it);
+  if (entity.index >= entityAnimations.size() ||
+      entityAnimations[entity.index].generation != entity.generation) {
+    return none;
   }
+  return entityAnimations[entity.index].animations;
+}
+
+bool AnimationSystem::contains(const Animation* animation) const {
+  return animation->poolType < pools.size() && pools[animation->poolType] &&
+         animation->poolIndex < pools[animation->poolType]->size() &&
+         pools[animation->poolType]->at(animation->poolIndex) == animation;
 }
 
-void AnimationSystem::clear() { animations.clear(); }
+void AnimationSystem::listForEntity(
+    const std::shared_ptr<Animation>& animation) {
+  const EntityHandle entity = animation->getTargetEntity();
+  animation->listedEntity = entity;
+  if (entity.isNull()) return;
+
+  if (entityAnimations.size() <= entity.index) {
+    entityAnimations.resize(entity.index + 1);
+  }
+  EntityAnimations& slot = entityAnimations[entity.index];
+
+  // The slot's entity was removed and its animations not yet dropped;
+  // they can only ever be stale now
+  if (slot.generation != entity.generation) {
+    while (!slot.animations.empty()) {
+      remove(slot.animations.back().get());
+    }
+    slot.generation = entity.generation;
+  }
+
+  animation->entityIndex = slot.animations.size();
+  slot.animations.push_back(animation);
+}
 
-std::vector<std::shared_ptr<Animation>> AnimationSystem::getAnimationsForEntity(
-    Entity* entity) {
-  std::vector<std::shared_ptr<Animation>> result;
+void AnimationSystem::remove(Animation* animation) {
+  const size_t type = animation->poolType;
+  const size_t index = animation->poolIndex;
+  const EntityHandle entity = animation->listedEntity;
+  animation->poolType = SIZE_MAX;
+  animation->listedEntity = EntityHandle{};
 
-  for (auto& animation : animations) {
-    if (animation->getTargetEntity() == entity) {
-      result.push_back(animation);
+  if (!entity.isNull()) {
+    auto& list = entityAnimations[entity.index].animations;
+    const size_t listIndex = animation->entityIndex;
+    if (listIndex + 1 != list.size()) {
+      list[listIndex] = std::move(list.back());
+      list[listIndex]->entityIndex = listIndex;
     }
+    list.pop_back();
   }
 
-  return result;
+  // May release the last reference, so nothing touches it after this
+  pools[type]->remove(index);
+  animationCount--;
 }
@@ -2,29 +2,129 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "core/app_state.h"
+#include "entities/entity_handle.h"
+#include "systems/tween_system.h"
 
-// Forward declarations
-class Entity;
 class Animation;
 
+/**
+ * @brief Where an animation writes its value: an entity, by handle, and a
+ * typed setter to call on it
+ *
+ * Made with bindProperty, which checks the setter against the entity type
+ * when it is compiled, so writing back needs no RTTI.
+ */
+template <typename V>
+struct PropertyBinding {
+  EntityHandle entity;
+  void (*write)(Entity& entity, const V& value) = nullptr;
+};
+
+namespace detail {
+
+// The class and parameter of a one-argument setter, for bindProperty
+template <typename E, typename V>
+std::type_identity<E> setterClass(void (E::*)(V));
+
+template <typename E, typename V>
+std::type_identity<std::remove_cvref_t<V>> setterValue(void (E::*)(V));
+
+}  // namespace detail
+
+/**
+ * @brief Bind a setter of an entity, e.g.
+ * bindProperty<&LineEntity::setAnimatedColor>(lineHandle)
+ */
+template <auto Setter>
+auto bindProperty(
+    TypedEntityHandle<typename decltype(detail::setterClass(Setter))::type>
+        entity) {
+  using E = typename decltype(detail::setterClass(Setter))::type;
+  using V = typename decltype(detail::setterValue(Setter))::type;
+
+  PropertyBinding<V> binding;
+  binding.entity = entity;
+  binding.write = [](Entity& target, const V& value) {
+    (static_cast<E&>(target).*Setter)(value);
+  };
+  return binding;
+}
+
 /**
  * @brief Handles entity animations and movement
  *
- * This system is responsible for:
- * - Managing entity animations
- * - Handling movement and interpolation
- * - Coordinating with the entity manager
- * - Providing animation utilities
+ * The one scheduler every animation runs in. Animations are kept in a pool
+ * per concrete type, so an update is one virtual call per type and a
+ * direct call per animation, and each writes its value back through the
+ * PropertyBinding it was added with. Animations whose entity is removed
+ * are dropped on the next update, as are finished ones that don't loop.
+ * Each entity's animations are also listed by its handle's slot, so they
+ * can be found without a search.
  */
 class AnimationSystem {
  private:
+  // Every animation of one concrete type
+  struct PoolBase {
+    virtual ~PoolBase() = default;
+
+    // Update each animation and write its value, collecting those that
+    // have finished or lost their entity
+    virtual void update(float deltaTime, const EntityManager& entityManager,
+                        std::vector<Animation*>& expired) = 0;
+    virtual Animation* at(size_t index) const = 0;
+    virtual void remove(size_t index) = 0;
+    virtual void clear() = 0;
+    virtual size_t size() const = 0;
+  };
+
+  template <typename T>
+  struct Pool final : PoolBase {
+    struct Entry {
+      std::shared_ptr<T> animation;
+      PropertyBinding<typename T::Value> binding;
+    };
+    std::vector<Entry> entries;
+
+    void update(float deltaTime, const EntityManager& entityManager,
+                std::vector<Animation*>& expired) override;
+    Animation* at(size_t index) const override {
+      return entries[index].animation.get();
+    }
+    void remove(size_t index) override;
+    void clear() override { entries.clear(); }
+    size_t size() const override { return entries.size(); }
+  };
+
+  struct EntityAnimations {
+    uint32_t generation = 0;
+    std::vector<std::shared_ptr<Animation>> animations;
+  };
+
+  // A dense index per animation type, handed out on first use
+  template <typename T>
+  static size_t getPoolType() {
+    static const size_t type = nextPoolType++;
+    return type;
+  }
+  inline static size_t nextPoolType = 0;
+
+  bool contains(const Animation* animation) const;
+  void listForEntity(const std::shared_ptr<Animation>& animation);
+  void remove(Animation* animation);
+
   AppState* appState;
-  std::vector<std::shared_ptr<Animation>> animations;
-  std::vector<std::shared_ptr<Animation>> animationsToRemove;
+  std::vector<std::unique_ptr<PoolBase>> pools;  // By pool type
+  std::vector<EntityAnimations> entityAnimations;  // By handle slot
+  std::vector<Animation*> expired;
+  size_t animationCount = 0;
+  TweenSystem tweens;
 
  public:
   AnimationSystem(AppState* appState) : appState(appState) {}
@@ -35,25 +135,38 @@ class AnimationSystem {
   void update(float deltaTime);
 
   /**
-   * @brief Add an animation to the system
+   * @brief Add an animation to the system, writing its value through
+   * `binding` each update
+   *
+   * The binding's entity becomes the animation's target. Without a binding
+   * the animation still runs, writing nowhere.
    */
-  void addAnimation(std::shared_ptr<Animation> animation);
+  template <typename T>
+  void addAnimation(std::shared_ptr<T> animation,
+                    PropertyBinding<typename T::Value> binding = {});
 
   /**
    * @brief Remove an animation from the system
    */
-  void removeAnimation(std::shared_ptr<Animation> animation);
+  void removeAnimation(const std::shared_ptr<Animation>& animation);
 
   /**
    * @brief Clear all animations
    */
   void clear();
 
+  size_t getAnimationCount() const { return animationCount; }
+
+  /**
+   * @brief Keyframe tweens, advanced with the animations each update
+   */
+  TweenSystem& getTweens() { return tweens; }
+
   /**
    * @brief Get all animations for a specific entity
    */
-  std::vector<std::shared_ptr<Animation>> getAnimationsForEntity(
-      Entity* entity);
+  const std::vector<std::shared_ptr<Animation>>& getAnimationsForEntity(
+      EntityHandle entity) const;
 };
 
 /**
@@ -65,10 +178,10 @@ class Animation {
   float currentTime;
   bool finished = false;
   bool looping = false;
-  Entity* targetEntity = nullptr;
+  EntityHandle targetEntity;
 
  public:
-  Animation(float duration, Entity* targetEntity = nullptr)
+  Animation(float duration, EntityHandle targetEntity = EntityHandle{})
       : duration(duration), currentTime(0.0f), targetEntity(targetEntity) {}
 
   virtual ~Animation() = default;
@@ -94,14 +207,17 @@ class Animation {
   void setLooping(bool loop) { looping = loop; }
 
   /**
-   * @brief Get the target entity
+   * @brief Get the target entity handle
+   *
+   * Resolve it through EntityManager::get; it resolves to nullptr once the
+   * entity has been removed.
    */
-  Entity* getTargetEntity() const { return targetEntity; }
+  EntityHandle getTargetEntity() const { return targetEntity; }
 
   /**
    * @brief Set the target entity
    */
-  void setTargetEntity(Entity* entity) { targetEntity = entity; }
+  void setTargetEntity(EntityHandle entity) { targetEntity = entity; }
 
   /**
    * @brief Reset the animation
@@ -117,12 +233,22 @@ class Animation {
   float getProgress() const {
     return duration > 0.0f ? std::min(currentTime / duration, 1.0f) : 0.0f;
   }
+
+ private:
+  friend class AnimationSystem;
+
+  // Where the AnimationSystem keeps this animation, so it can be removed
+  // without a search
+  size_t poolType = SIZE_MAX;
+  size_t poolIndex = 0;
+  EntityHandle listedEntity;
+  size_t entityIndex = 0;
 };
 
 /**
  * @brief Animation for cycling through gradient colors
  */
-class GradientAnimation : public Animation {
+class GradientAnimation final : public Animation {
  private:
   std::vector<SDL_Color> colors;
   size_t currentColorIndex = 0;
@@ -131,7 +257,10 @@ class GradientAnimation : public Animation {
   float colorTransitionDuration = 1.0f;
 
  public:
-  GradientAnimation(float duration, Entity* targetEntity,
+  // What the animation writes to its binding
+  using Value = SDL_Color;
+
+  GradientAnimation(float duration, EntityHandle targetEntity,
                     const std::vector<SDL_Color>& colors)
       : Animation(duration, targetEntity), colors(colors) {
     if (colors.size() < 2) {
@@ -179,6 +308,8 @@ class GradientAnimation : public Animation {
     return result;
   }
 
+  SDL_Color getValue() const { return getCurrentColor(); }
+
   /**
    * @brief Get the next color in the sequence
    */
@@ -199,3 +330,62 @@ class GradientAnimation : public Animation {
    */
   float getColorTransitionDuration() const { return colorTransitionDuration; }
 };
+
+template <typename T>
+void AnimationSystem::Pool<T>::update(float deltaTime,
+                                      const EntityManager& entityManager,
+                                      std::vector<Animation*>& expired) {
+  for (Entry& entry : entries) {
+    T& animation = *entry.animation;
+
+    Entity* target = nullptr;
+    if (entry.binding.write) {
+      target = entityManager.get(entry.binding.entity);
+      if (!target) {
+        expired.push_back(&animation);
+        continue;
+      }
+    }
+
+    // Named directly, so the call is neither virtual nor a type check
+    animation.T::update(deltaTime);
+    if (target) entry.binding.write(*target, animation.getValue());
+
+    if (animation.isFinished()) {
+      if (animation.isLooping()) {
+        animation.reset();
+      } else {
+        expired.push_back(&animation);
+      }
+    }
+  }
+}
+
+template <typename T>
+void AnimationSystem::Pool<T>::remove(size_t index) {
+  if (index + 1 != entries.size()) {
+    entries[index] = std::move(entries.back());
+    entries[index].animation->poolIndex = index;
+  }
+  entries.pop_back();
+}
+
+template <typename T>
+void AnimationSystem::addAnimation(
+    std::shared_ptr<T> animation, PropertyBinding<typename T::Value> binding) {
+  static_assert(std::is_base_of_v<Animation, T>,
+                "AnimationSystem runs Animation subclasses");
+  if (!animation || contains(animation.get())) return;
+
+  const size_t type = getPoolType<T>();
+  if (pools.size() <= type) pools.resize(type + 1);
+  if (!pools[type]) pools[type] = std::make_unique<Pool<T>>();
+  auto& entries = static_cast<Pool<T>&>(*pools[type]).entries;
+
+  if (binding.write) animation->setTargetEntity(binding.entity);
+  listForEntity(animation);
+  animation->poolType = type;
+  animation->poolIndex = entries.size();
+  entries.push_back({std::move(animation), binding});
+  animationCount++;
+}
@@ -0,0 +1,289 @@
+#include "audio_binding_system.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "entities/entity.h"
+#include "entities/line.h"
+
+namespace {
+
+// Fraction of the way a one-pole filter with time constant `seconds`
+// moves towards its input in `deltaTime`
+float followRate(float seconds, float deltaTime) {
+  return seconds > 0.0f ? 1.0f - std::exp(-deltaTime / seconds) : 1.0f;
+}
+
+SDL_FColor mixColor(const SDL_FColor& a, const SDL_FColor& b, float t) {
+  return {a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t,
+          a.b + (b.b - a.b) * t, a.a + (b.a - a.a) * t};
+}
+
+SDL_Color toColor(const SDL_FColor& color) {
+  auto channel = [](float value) {
+    return static_cast<Uint8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+  };
+  return {channel(color.r), channel(color.g), channel(color.b),
+          channel(color.a)};
+}
+
+// Split targets [begin, end) into as many equal runs as there are levels
+// and call fill(runBegin, runEnd, level) for each. Every target in a run
+// gets the same value, so it is worked out once and filled.
+template <typename Fill>
+void forEachRun(size_t begin, size_t end, const std::vector<float>& levels,
+                Fill&& fill) {
+  const size_t count = end - begin;
+  const size_t channels = levels.size();
+  for (size_t c = 0; c < channels; ++c) {
+    const size_t runBegin = begin + count * c / channels;
+    const size_t runEnd = begin + count * (c + 1) / channels;
+    if (runBegin < runEnd) fill(runBegin, runEnd, levels[c]);
+  }
+}
+
+// Fill [begin, end) of an archetype column with one value
+template <typename T>
+void fillColumn(std::vector<T>& column, size_t begin, size_t end,
+                const T& value) {
+  std::fill(column.begin() + begin, column.begin() + end, value);
+}
+
+}  // namespace
+
+const char* getAudioFeatureName(AudioFeature feature) {
+  switch (feature) {
+    case AudioFeature::Bass:
+      return "Bass";
+    case AudioFeature::LowMid:
+      return "Low Mid";
+    case AudioFeature::Mid:
+      return "Mid";
+    case AudioFeature::HighMid:
+      return "High Mid";
+    case AudioFeature::Treble:
+      return "Treble";
+    case AudioFeature::Energy:
+      return "Energy";
+    case AudioFeature::Peak:
+      return "Peak";
+    case AudioFeature::Flux:
+      return "Flux";
+    case AudioFeature::BeatIntensity:
+      return "Beat Intensity";
+    case AudioFeature::Beat:
+      return "Beat";
+    case AudioFeature::BeatPhase:
+      return "Beat Phase";
+    case AudioFeature::Filterbank:
+      return "Filterbank";
+  }
+  return "Unknown";
+}
+
+const char* getBindingTargetName(BindingTarget target) {
+  switch (target) {
+    case BindingTarget::CubeWaveAmplitude:
+      return "Cube Wave Amplitude";
+    case BindingTarget::CubeSpeed:
+      return "Cube Speed";
+    case BindingTarget::CubeColor:
+      return "Cube Color";
+    case BindingTarget::WaypointSpeed:
+      return "Waypoint Speed";
+    case BindingTarget::WaypointColor:
+      return "Waypoint Color";
+    case BindingTarget::LineColor:
+      return "Line Color";
+    case BindingTarget::LineThickness:
+      return "Line Thickness";
+  }
+  return "Unknown";
+}
+
+AudioBindingSystem::BindingId AudioBindingSystem::addBinding(
+    AudioBinding binding) {
+  // Up front, so the filterbank never makes update() allocate
+  inputs.reserve(Filterbank::MAX_BANDS);
+
+  Entry entry;
+  entry.id = nextId++;
+  entry.binding = std::move(binding);
+  bindings.push_back(std::move(entry));
+  return bindings.back().id;
+}
+
+void AudioBindingSystem::removeBinding(BindingId id) {
+  bindings.erase(std::remove_if(bindings.begin(), bindings.end(),
+                                [id](const Entry& entry) {
+                                  return entry.id == id;
+                                }),
+                 bindings.end());
+}
+
+void AudioBindingSystem::clear() { bindings.clear(); }
+
+void AudioBindingSystem::update(const AudioSystem::VisualizationData& data,
+                                float deltaTime) {
+  // isBeat stays set for the whole snapshot, which several fixed steps can
+  // read, so only a new beat time counts
+  const bool newBeat = data.lastBeatMs != lastBeatMs;
+  lastBeatMs = data.lastBeatMs;
+  lastBoundCount = 0;
+
+  for (Entry& entry : bindings) {
+    const AudioBinding& binding = entry.binding;
+    readFeature(entry, data, newBeat);
+
+    // A filterbank's band count can change under it; levels start over
+    if (entry.levels.size() != inputs.size()) {
+      entry.smoothed.assign(inputs.begin(), inputs.end());
+      entry.levels.assign(inputs.size(), 0.0f);
+    }
+
+    const float smoothing =
+        followRate(binding.envelope.smoothing, deltaTime);
+    const float attack = followRate(binding.envelope.attack, deltaTime);
+    const float release = followRate(binding.envelope.release, deltaTime);
+    for (size_t c = 0; c < inputs.size(); ++c) {
+      float input = std::clamp(binding.gain * inputs[c], 0.0f, 1.0f);
+      float& smoothed = entry.smoothed[c];
+      float& level = entry.levels[c];
+      smoothed += (input - smoothed) * smoothing;
+      level += (smoothed - level) * (smoothed > level ? attack : release);
+    }
+
+    apply(entry);
+  }
+}
+
+void AudioBindingSystem::readFeature(
+    const Entry& entry, const AudioSystem::VisualizationData& data,
+    bool newBeat) {
+  if (entry.binding.feature == AudioFeature::Filterbank) {
+    std::span<const float> bands = data.getFilterbankLevels();
+    inputs.assign(bands.begin(), bands.end());
+    return;
+  }
+
+  double value = 0.0;
+  switch (entry.binding.feature) {
+    case AudioFeature::Bass:
+      value = data.bassLevel;
+      break;
+    case AudioFeature::LowMid:
+      value = data.lowMidLevel;
+      break;
+    case AudioFeature::Mid:
+      value = data.midLevel;
+      break;
+    case AudioFeature::HighMid:
+      value = data.highMidLevel;
+      break;
+    case AudioFeature::Treble:
+      value = data.trebleLevel;
+      break;
+    case AudioFeature::Energy:
+      value = data.rmsEnergy;
+      break;
+    case AudioFeature::Peak:
+      value = data.currentPeak;
+      break;
+    case AudioFeature::Flux:
+      value = data.spectralFluxEMA;
+      break;
+    case AudioFeature::BeatIntensity:
+      value = data.beatIntensity;
+      break;
+    case AudioFeature::Beat:
+      value = newBeat ? 1.0 : 0.0;
+      break;
+    case AudioFeature::BeatPhase:
+      value = data.secondsToNextBeat >= 0.0 ? 1.0 - data.beatPhase : 0.0;
+      break;
+    case AudioFeature::Filterbank:
+      break;
+  }
+  inputs.assign(1, static_cast<float>(value));
+}
+
+void AudioBindingSystem::apply(const Entry& entry) {
+  const AudioBinding& binding = entry.binding;
+  if (entry.levels.empty()) return;
+
+  const float low = binding.low;
+  const float span = binding.high - binding.low;
+
+  // Archetype targets: clip the range to the storage as it is now
+  auto range = [&](size_t size, size_t& begin, size_t& end) {
+    begin = std::min(binding.first, size);
+    end = binding.count == AudioBinding::ALL
+              ? size
+              : begin + std::min(binding.count, size - begin);
+    lastBoundCount += end - begin;
+  };
+
+  IsometricCubeArchetype& cubes = entityManager.getCubes();
+  WaypointArchetype& waypoints = entityManager.getWaypoints();
+  size_t begin;
+  size_t end;
+
+  switch (binding.target) {
+    case BindingTarget::CubeWaveAmplitude:
+      range(cubes.size(), begin, end);
+      forEachRun(begin, end, entry.levels, [&](size_t b, size_t e, float l) {
+        fillColumn(cubes.waveDy, b, e, low + span * l);
+      });
+      break;
+    case BindingTarget::CubeSpeed:
+      range(cubes.size(), begin, end);
+      forEachRun(begin, end, entry.levels, [&](size_t b, size_t e, float l) {
+        fillColumn(cubes.speed, b, e, low + span * l);
+      });
+      break;
+    case BindingTarget::CubeColor:
+      range(cubes.size(), begin, end);
+      forEachRun(begin, end, entry.levels, [&](size_t b, size_t e, float l) {
+        fillColumn(cubes.color, b, e,
+                   mixColor(binding.lowColor, binding.highColor, l));
+      });
+      break;
+    case BindingTarget::WaypointSpeed:
+      range(waypoints.size(), begin, end);
+      forEachRun(begin, end, entry.levels, [&](size_t b, size_t e, float l) {
+        fillColumn(waypoints.speed, b, e, low + span * l);
+      });
+      break;
+    case BindingTarget::WaypointColor:
+      range(waypoints.size(), begin, end);
+      forEachRun(begin, end, entry.levels, [&](size_t b, size_t e, float l) {
+        fillColumn(waypoints.color, b, e,
+                   toColor(mixColor(binding.lowColor, binding.highColor, l)));
+      });
+      break;
+    case BindingTarget::LineColor:
+      forEachRun(0, binding.lines.size(), entry.levels,
+                 [&](size_t b, size_t e, float l) {
+                   SDL_Color color = toColor(
+                       mixColor(binding.lowColor, binding.highColor, l));
+                   for (size_t i = b; i < e; ++i) {
+                     if (auto* line = entityManager.get(binding.lines[i])) {
+                       line->setAnimatedColor(color);
+                       lastBoundCount++;
+                     }
+                   }
+                 });
+      break;
+    case BindingTarget::LineThickness:
+      forEachRun(0, binding.lines.size(), entry.levels,
+                 [&](size_t b, size_t e, float l) {
+                   for (size_t i = b; i < e; ++i) {
+                     if (auto* line = entityManager.get(binding.lines[i])) {
+                       line->setThickness(low + span * l);
+                       lastBoundCount++;
+                     }
+                   }
+                 });
+      break;
+  }
+}
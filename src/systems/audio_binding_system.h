@@ -0,0 +1,154 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities/entity_handle.h"
+#include "systems/audio_system.h"
+
+class EntityManager;
+class LineEntity;
+
+/** @brief A value read from AudioSystem::VisualizationData, in [0, 1] */
+enum class AudioFeature {
+  Bass,
+  LowMid,
+  Mid,
+  HighMid,
+  Treble,
+  Energy,         // RMS energy
+  Peak,
+  Flux,           // Smoothed spectral flux; unbounded, so scale by gain
+  BeatIntensity,
+  Beat,           // 1 on a detected beat, 0 otherwise
+  BeatPhase,      // 1 on a predicted beat, falling to 0 by the next one
+  Filterbank,     // One value per filterbank band, spread over the targets
+};
+
+const char* getAudioFeatureName(AudioFeature feature);
+
+/** @brief An entity parameter an AudioBinding can drive */
+enum class BindingTarget {
+  CubeWaveAmplitude,  // IsometricCubeArchetype::waveDy
+  CubeSpeed,          // IsometricCubeArchetype::speed
+  CubeColor,          // IsometricCubeArchetype::color
+  WaypointSpeed,      // WaypointArchetype::speed
+  WaypointColor,      // WaypointArchetype::color
+  LineColor,          // LineEntity's animated color
+  LineThickness,      // LineEntity::setThickness
+};
+
+const char* getBindingTargetName(BindingTarget target);
+
+/**
+ * @brief How a binding's level follows its feature, in seconds
+ *
+ * The feature is first smoothed with a symmetric time constant, then
+ * followed with separate attack (rising) and release (falling) times, so
+ * a beat can snap a level up and let it fall away slowly. Zero follows at
+ * once.
+ */
+struct AudioEnvelope {
+  float smoothing = 0.0f;
+  float attack = 0.0f;
+  float release = 0.0f;
+};
+
+/**
+ * @brief "This parameter of these entities follows that audio feature"
+ *
+ * The feature is scaled by `gain` and clamped to [0, 1], passed through
+ * the envelope, and mapped onto low..high, or lowColor..highColor for
+ * color targets. Archetype targets cover `count` entities from `first`;
+ * ALL reaches the end of the storage, including entities spawned later.
+ * Line targets cover `lines`. A Filterbank feature spreads its bands over
+ * the targets in order, lowest band first.
+ */
+struct AudioBinding {
+  static constexpr size_t ALL = SIZE_MAX;
+
+  AudioFeature feature = AudioFeature::Bass;
+  BindingTarget target = BindingTarget::CubeWaveAmplitude;
+  float gain = 1.0f;
+  AudioEnvelope envelope;
+
+  float low = 0.0f;
+  float high = 1.0f;
+  SDL_FColor lowColor = {0.0f, 0.0f, 0.0f, 1.0f};
+  SDL_FColor highColor = {1.0f, 1.0f, 1.0f, 1.0f};
+
+  size_t first = 0;
+  size_t count = ALL;
+  std::vector<TypedEntityHandle<LineEntity>> lines;
+};
+
+/**
+ * @brief Drives entity parameters from the audio analysis
+ *
+ * Holds declarative AudioBindings and evaluates them all in one pass per
+ * update. The envelopes run once per binding, or once per band for the
+ * filterbank, not once per entity; each entity then only costs a store of
+ * its binding's level into the archetype column, so the pass stays cheap
+ * however many entities are bound.
+ *
+ * Runs after the entity update, so a bound parameter overrides whatever
+ * the entity or its animations set.
+ */
+class AudioBindingSystem {
+ public:
+  using BindingId = uint32_t;
+
+  explicit AudioBindingSystem(EntityManager& entityManager)
+      : entityManager(entityManager) {}
+
+  /** @brief Add a binding, returning an id to remove it by */
+  BindingId addBinding(AudioBinding binding);
+
+  /** @brief Remove a binding; bound parameters keep their last values */
+  void removeBinding(BindingId id);
+
+  /** @brief Remove all bindings */
+  void clear();
+
+  size_t getBindingCount() const { return bindings.size(); }
+
+  /**
+   * @brief Advance every binding's envelope by `deltaTime` towards `data`
+   * and write the levels to the bound parameters
+   */
+  void update(const AudioSystem::VisualizationData& data, float deltaTime);
+
+  /** @brief Entity parameters written by the last update */
+  size_t getLastBoundCount() const { return lastBoundCount; }
+
+ private:
+  struct Entry {
+    BindingId id;
+    AudioBinding binding;
+
+    // Envelope state, one per channel: a single channel, or one per band
+    // for the filterbank
+    std::vector<float> smoothed;
+    std::vector<float> levels;
+  };
+
+  void readFeature(const Entry& entry,
+                   const AudioSystem::VisualizationData& data,
+                   bool newBeat);
+  void apply(const Entry& entry);
+
+  EntityManager& entityManager;
+  std::vector<Entry> bindings;
+  BindingId nextId = 1;
+
+  // Feature values for the binding being updated, before the envelope
+  std::vector<float> inputs;
+
+  // The last beat seen, so a beat counts once even if the snapshot that
+  // flagged it was skipped or read twice
+  Uint64 lastBeatMs = 0;
+  size_t lastBoundCount = 0;
+};
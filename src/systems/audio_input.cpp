@@ -0,0 +1,219 @@
+#include "audio_input.h"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+namespace {
+
+const double TWO_PI = 6.283185307179586;
+
+// Decay times of the generator's drums, in seconds
+const double KICK_DECAY = 0.12;
+const double HAT_DECAY = 0.02;
+
+}  // namespace
+
+const char* getAudioInputName(AudioInput input) {
+  switch (input) {
+    case AudioInput::File:
+      return "File";
+    case AudioInput::Recording:
+      return "Recording Device";
+    case AudioInput::Generator:
+      return "Test Generator";
+  }
+  return "Unknown";
+}
+
+void CaptureSource::deliver(CaptureRing& ring, const StereoFrame* frames,
+                            size_t count) {
+  size_t written = ring.write(frames, count);
+  if (written < count) {
+    droppedFrames += count - written;
+  }
+}
+
+RecordingSource::RecordingSource(std::string deviceName)
+    : deviceName(std::move(deviceName)) {}
+
+RecordingSource::~RecordingSource() { stop(); }
+
+std::vector<std::string> RecordingSource::getDeviceNames() {
+  std::vector<std::string> names;
+  if (SDL_WasInit(SDL_INIT_AUDIO) == 0 &&
+      !SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+    return names;
+  }
+
+  int count = 0;
+  SDL_AudioDeviceID* devices = SDL_GetAudioRecordingDevices(&count);
+  if (!devices) return names;
+
+  for (int i = 0; i < count; ++i) {
+    const char* name = SDL_GetAudioDeviceName(devices[i]);
+    if (name) names.emplace_back(name);
+  }
+  SDL_free(devices);
+  return names;
+}
+
+bool RecordingSource::start(CaptureRing& ring) {
+  stop();
+
+  if (SDL_WasInit(SDL_INIT_AUDIO) == 0 &&
+      !SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+    error = std::string("Failed to initialize SDL audio: ") + SDL_GetError();
+    return false;
+  }
+
+  SDL_AudioDeviceID device = SDL_AUDIO_DEVICE_DEFAULT_RECORDING;
+  if (!deviceName.empty()) {
+    int count = 0;
+    SDL_AudioDeviceID* devices = SDL_GetAudioRecordingDevices(&count);
+    device = 0;
+    for (int i = 0; devices && i < count; ++i) {
+      const char* name = SDL_GetAudioDeviceName(devices[i]);
+      if (name && std::string(name).find(deviceName) != std::string::npos) {
+        device = devices[i];
+        break;
+      }
+    }
+    SDL_free(devices);
+
+    if (device == 0) {
+      error = "No recording device matches \"" + deviceName + "\"";
+      return false;
+    }
+  }
+
+  // Take the device's own rate, so SDL only has to convert channels and
+  // format
+  SDL_AudioSpec deviceSpec;
+  sampleRate = 48000;
+  if (SDL_GetAudioDeviceFormat(device, &deviceSpec, nullptr) &&
+      deviceSpec.freq > 0) {
+    sampleRate = deviceSpec.freq;
+  }
+
+  // The ring and scratch must be ready before the callback can run
+  this->ring = &ring;
+  scratch.resize(READ_CHUNK_FRAMES);
+
+  SDL_AudioSpec spec = {SDL_AUDIO_F32, 2, sampleRate};
+  stream = SDL_OpenAudioDeviceStream(device, &spec, recordCallback, this);
+  if (!stream) {
+    error = std::string("Failed to open recording device: ") + SDL_GetError();
+    return false;
+  }
+
+  // SDL3 opens device streams paused
+  SDL_ResumeAudioStreamDevice(stream);
+  error.clear();
+  return true;
+}
+
+void RecordingSource::stop() {
+  // Destroying the stream waits out a callback in progress
+  if (stream) {
+    SDL_DestroyAudioStream(stream);
+    stream = nullptr;
+  }
+}
+
+void RecordingSource::recordCallback(void* userdata, SDL_AudioStream* stream,
+                                     int additionalAmount, int totalAmount) {
+  (void)additionalAmount;
+  (void)totalAmount;
+
+  // Runs on SDL's audio thread whenever the device has recorded more
+  auto* source = static_cast<RecordingSource*>(userdata);
+  const int chunkBytes =
+      static_cast<int>(source->scratch.size() * sizeof(StereoFrame));
+
+  int bytes;
+  while ((bytes = SDL_GetAudioStreamData(stream, source->scratch.data(),
+                                         chunkBytes)) > 0) {
+    source->deliver(*source->ring, source->scratch.data(),
+                    static_cast<size_t>(bytes) / sizeof(StereoFrame));
+  }
+}
+
+GeneratorSource::~GeneratorSource() { stop(); }
+
+bool GeneratorSource::start(CaptureRing& ring) {
+  stop();
+
+  frame = 0;
+  noiseState = 1;
+  running = true;
+  thread = std::thread(&GeneratorSource::run, this, std::ref(ring));
+  return true;
+}
+
+void GeneratorSource::stop() {
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void GeneratorSource::run(CaptureRing& ring) {
+  using Clock = std::chrono::steady_clock;
+
+  StereoFrame block[BLOCK_FRAMES];
+  const auto startTime = Clock::now();
+  const auto blockTime = std::chrono::duration<double>(
+      static_cast<double>(BLOCK_FRAMES) / SAMPLE_RATE);
+  uint64_t produced = 0;
+
+  while (running) {
+    // Keep pace with the wall clock, as a device would
+    double elapsed =
+        std::chrono::duration<double>(Clock::now() - startTime).count();
+    auto due = static_cast<uint64_t>(elapsed * SAMPLE_RATE);
+    while (produced + BLOCK_FRAMES <= due) {
+      generate(block, BLOCK_FRAMES);
+      deliver(ring, block, BLOCK_FRAMES);
+      produced += BLOCK_FRAMES;
+    }
+
+    std::this_thread::sleep_for(blockTime);
+  }
+}
+
+void GeneratorSource::generate(StereoFrame* out, size_t count) {
+  const uint64_t beatFrames =
+      static_cast<uint64_t>(SAMPLE_RATE * 60.0 / TEMPO_BPM);
+
+  for (size_t i = 0; i < count; ++i, ++frame) {
+    double time = static_cast<double>(frame) / SAMPLE_RATE;
+    double sinceBeat =
+        static_cast<double>(frame % beatFrames) / SAMPLE_RATE;
+
+    // A low thump on every beat
+    double kick = 0.8 * std::sin(TWO_PI * 55.0 * sinceBeat) *
+                  std::exp(-sinceBeat / KICK_DECAY);
+
+    // A quiet A major chord throughout
+    double chord = 0.04 * (std::sin(TWO_PI * 220.0 * time) +
+                           std::sin(TWO_PI * 277.18 * time) +
+                           std::sin(TWO_PI * 329.63 * time));
+
+    // Noise bursts on the off-beats
+    double hat = 0.0;
+    double sinceOffBeat = sinceBeat - 30.0 / TEMPO_BPM;
+    if (sinceOffBeat >= 0.0) {
+      noiseState ^= noiseState << 13;
+      noiseState ^= noiseState >> 17;
+      noiseState ^= noiseState << 5;
+      double noise = noiseState / 2147483648.0 - 1.0;
+      hat = 0.3 * noise * std::exp(-sinceOffBeat / HAT_DECAY);
+    }
+
+    // Chord a little left, hats mostly right
+    out[i].left = static_cast<float>(kick + 1.2 * chord + 0.3 * hat);
+    out[i].right = static_cast<float>(kick + 0.8 * chord + hat);
+  }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/spsc_ring_buffer.h"
+
+/** @brief Where AudioSystem takes the audio it analyzes from */
+enum class AudioInput {
+  File,       // The loaded WAV, played through the output device
+  Recording,  // A recording device: a microphone, line in or monitor
+  Generator,  // A synthetic test signal that needs no audio hardware
+};
+
+const char* getAudioInputName(AudioInput input);
+
+/** @brief One frame of live input, laid out as SDL's interleaved F32 */
+struct StereoFrame {
+  float left;
+  float right;
+};
+
+using CaptureRing = SpscRingBuffer<StereoFrame>;
+
+/**
+ * @brief Live audio that arrives by itself, rather than being read on demand
+ *
+ * A started source pushes frames into a CaptureRing from its own thread as
+ * they come in, never blocking; frames that find the ring full are counted
+ * and dropped. The analysis thread is the ring's only consumer.
+ */
+class CaptureSource {
+ public:
+  virtual ~CaptureSource() = default;
+
+  /** @brief Start delivering into `ring`. On failure getError() says why. */
+  virtual bool start(CaptureRing& ring) = 0;
+
+  /** @brief Stop delivering; no frames are pushed once this returns */
+  virtual void stop() = 0;
+
+  virtual int getSampleRate() const = 0;
+
+  const std::string& getError() const { return error; }
+
+  /** @brief Frames lost because the ring was full */
+  uint64_t getDroppedFrames() const { return droppedFrames; }
+
+ protected:
+  void deliver(CaptureRing& ring, const StereoFrame* frames, size_t count);
+
+  std::string error;
+  std::atomic<uint64_t> droppedFrames{0};
+};
+
+/**
+ * @brief Capture from an SDL recording device
+ *
+ * SDL converts whatever the device produces to stereo F32 at the device's
+ * own rate. On PipeWire and PulseAudio, the monitor of an output shows up as
+ * a recording device, so this can listen to whatever the machine is playing.
+ * Under SDL's disk driver it reads raw frames from a file instead.
+ */
+class RecordingSource : public CaptureSource {
+ public:
+  /**
+   * @brief `deviceName` picks the first recording device whose name
+   * contains it; empty means the system default
+   */
+  explicit RecordingSource(std::string deviceName = "");
+  ~RecordingSource() override;
+
+  bool start(CaptureRing& ring) override;
+  void stop() override;
+  int getSampleRate() const override { return sampleRate; }
+
+  /** @brief Names of the recording devices present, for the constructor */
+  static std::vector<std::string> getDeviceNames();
+
+ private:
+  static void recordCallback(void* userdata, SDL_AudioStream* stream,
+                             int additionalAmount, int totalAmount);
+
+  // Frames are read out of the stream this many at a time
+  static constexpr int READ_CHUNK_FRAMES = 1024;
+
+  std::string deviceName;
+  SDL_AudioStream* stream = nullptr;
+  CaptureRing* ring = nullptr;
+  int sampleRate = 0;
+  std::vector<StereoFrame> scratch;
+};
+
+/**
+ * @brief Synthetic input, produced in real time on its own thread
+ *
+ * A kick drum at TEMPO_BPM over a sustained chord, with hi-hats on the
+ * off-beats panned right, so beat tracking, the frequency bands and the
+ * stereo image all have something to find. Deterministic from the start,
+ * for headless runs with no audio device at all.
+ */
+class GeneratorSource : public CaptureSource {
+ public:
+  static constexpr int SAMPLE_RATE = 48000;
+  static constexpr double TEMPO_BPM = 120.0;
+
+  ~GeneratorSource() override;
+
+  bool start(CaptureRing& ring) override;
+  void stop() override;
+  int getSampleRate() const override { return SAMPLE_RATE; }
+
+  /** @brief Write the next `count` frames of the signal */
+  void generate(StereoFrame* out, size_t count);
+
+ private:
+  // Frames produced per wake-up of the thread
+  static constexpr int BLOCK_FRAMES = 256;
+
+  void run(CaptureRing& ring);
+
+  std::thread thread;
+  std::atomic<bool> running{false};
+  uint64_t frame = 0;       // Frames generated so far
+  uint32_t noiseState = 1;  // For the hi-hats
+};
@@ -1,9 +1,49 @@
 #include "audio_system.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
-#include <numeric>
+
+#include "systems/job_system.h"
+
+namespace {
+
+// Flux is smoothed with an EMA before beat detection; higher is more
+// responsive
+const double FLUX_EMA_ALPHA = 0.2;
+
+// Hops per batch analysis chunk. Each chunk also analyzes the hop before
+// it, to give flux a previous spectrum.
+const size_t BATCH_CHUNK_HOPS = 256;
+
+// A jump in the served position longer than this is a seek, and doesn't
+// report the beats skipped over
+const double CACHE_SEEK_SECONDS = 0.25;
+
+// FFT buffers and feature state for one batch analysis chunk
+struct BatchWorkspace {
+  explicit BatchWorkspace(int fftSize)
+      : in(fftwf_alloc_real(fftSize)),
+        out(fftwf_alloc_complex(fftSize / 2 + 1)),
+        samples(fftSize),
+        magnitudes(fftSize / 2) {}
+  ~BatchWorkspace() {
+    fftwf_free(in);
+    fftwf_free(out);
+  }
+
+  BatchWorkspace(const BatchWorkspace&) = delete;
+  BatchWorkspace& operator=(const BatchWorkspace&) = delete;
+
+  float* in;
+  fftwf_complex* out;
+  std::vector<float> samples;
+  std::vector<double> magnitudes;
+  SpectralAnalyzer analyzer;
+};
+
+}  // namespace
 
 AudioSystem::AudioSystem()
     : fftPlan(nullptr),
@@ -11,32 +51,31 @@ AudioSystem::AudioSystem()
       fftOut(nullptr),
       fftSize(2048),
       audioStream(nullptr),
-      wavData(nullptr),
-      wavDataLen(0),
       playing(false),
-      paused(false),
-      currentSample(0),
-      playbackStartTime(0) {
+      paused(false) {
   std::cout << "AudioSystem: Initializing..." << std::endl;
 
   // Initialize audio data
+  audioData.sampleRate = 44100;
+  audioData.channels = 0;
+  audioData.totalSamples = 0;
   audioData.loaded = false;
 
   // Initialize visualization data
-  vizData.currentPeak = 0.0;
-  vizData.averagePeak = 0.0;
-  vizData.peakThreshold = 0.1;
-  vizData.bassLevel = 0.0;
-  vizData.lowMidLevel = 0.0;
-  vizData.midLevel = 0.0;
-  vizData.highMidLevel = 0.0;
-  vizData.trebleLevel = 0.0;
-  vizData.beatIntensity = 0.0;
-  vizData.isBeat = false;
-  vizData.tempoEstimate = 120.0;
-  vizData.rmsEnergy = 0.0;
-  vizData.spectralCentroid = 0.0;
-  vizData.spectralRolloff = 0.0;
+  analysisState.currentPeak = 0.0;
+  analysisState.averagePeak = 0.0;
+  analysisState.peakThreshold = 0.1;
+  analysisState.bassLevel = 0.0;
+  analysisState.lowMidLevel = 0.0;
+  analysisState.midLevel = 0.0;
+  analysisState.highMidLevel = 0.0;
+  analysisState.trebleLevel = 0.0;
+  analysisState.beatIntensity = 0.0;
+  analysisState.isBeat = false;
+  analysisState.tempoEstimate = 120.0;
+  analysisState.rmsEnergy = 0.0;
+  analysisState.spectralCentroid = 0.0;
+  analysisState.spectralRolloff = 0.0;
 
   // Initialize FFT
   std::cout << "AudioSystem: Initializing FFT..." << std::endl;
@@ -44,22 +83,42 @@ AudioSystem::AudioSystem()
 
   // Initialize FFT buffer for visualization
   fftBuffer.resize(fftSize, 0.0f);
+  stereoBuffer.resize(STEREO_CHANNELS * fftSize, 0.0f);
+  captureRing.reset(CAPTURE_RING_FRAMES);
+
+  // Start with every snapshot slot holding the initial values
+  for (int i = 0; i < 3; ++i) {
+    vizSnapshots.getWriteBuffer() = analysisState;
+    vizSnapshots.publish();
+  }
+  vizSnapshots.acquire();
+
+  analysisThread = std::thread(&AudioSystem::analysisLoop, this);
 
   std::cout << "AudioSystem: Initialization complete" << std::endl;
 }
 
 AudioSystem::~AudioSystem() {
   std::cout << "AudioSystem: Destructing..." << std::endl;
-  stopPlayback();
-  cleanupFFT();
 
-  // Free WAV data
-  if (wavData) {
-    SDL_free(wavData);
-    wavData = nullptr;
-    wavDataLen = 0;
+  stopAnalysisCacheBuild();
+
+  {
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    analysisStopping = true;
+  }
+  analysisWake.notify_all();
+  if (analysisThread.joinable()) {
+    analysisThread.join();
   }
 
+  // The source writes into captureRing until it stops
+  if (captureSource) {
+    captureSource->stop();
+  }
+  stopPlayback();
+  cleanupFFT();
+
   // Ensure audio stream is destroyed
   if (audioStream) {
     SDL_DestroyAudioStream(audioStream);
@@ -70,15 +129,18 @@ AudioSystem::~AudioSystem() {
 bool AudioSystem::loadAudioFile(const std::string& filename) {
   std::cout << "AudioSystem: Loading audio file: " << filename << std::endl;
 
-  // Stop any current playback
+  // Stop any current playback, and any analysis of the old file
   stopPlayback();
+  stopAnalysisCacheBuild();
 
-  // Free any existing WAV data
-  if (wavData) {
-    SDL_free(wavData);
-    wavData = nullptr;
-    wavDataLen = 0;
-  }
+  // Keep the analysis thread off the audio data while it is replaced
+  std::lock_guard<std::mutex> lock(analysisMutex);
+
+  // Unmap any existing file
+  wavFile.close();
+  analysisCache.clear();
+  tempoTracker.reset();
+  audioData.loaded = false;
 
   // Check file extension
   std::string extension = filename.substr(filename.find_last_of(".") + 1);
@@ -91,100 +153,58 @@ bool AudioSystem::loadAudioFile(const std::string& filename) {
     return false;
   }
 
-  SDL_AudioSpec spec;
-
-  std::cout << "AudioSystem: About to call SDL_LoadWAV..." << std::endl;
-  if (!SDL_LoadWAV(filename.c_str(), &spec, &wavData, &wavDataLen)) {
-    std::cerr << "Failed to load WAV file: " << SDL_GetError() << std::endl;
+  // Only the header is read here; samples are decoded as they are needed
+  if (!wavFile.open(filename)) {
+    std::cerr << "Failed to load WAV file: " << wavFile.getError()
+              << std::endl;
     return false;
   }
 
-  std::cout << "AudioSystem: WAV loaded successfully" << std::endl;
-  std::cout << "  Sample rate: " << spec.freq << std::endl;
-  std::cout << "  Channels: " << spec.channels << std::endl;
-  std::cout << "  Format: " << spec.format << std::endl;
-  std::cout << "  Audio length: " << wavDataLen << " bytes" << std::endl;
-
-  // Store original audio format
-  audioData.sampleRate = spec.freq;
-  audioData.channels = spec.channels;
-  audioData.totalSamples =
-      wavDataLen / (spec.channels * SDL_AUDIO_BYTESIZE(spec.format));
+  // Store the spec for playback; see WavFile::getPlaybackSpec()
+  originalSpec = wavFile.getPlaybackSpec();
 
-  std::cout << "AudioSystem: Total samples: " << audioData.totalSamples
-            << std::endl;
+  audioData.sampleRate = wavFile.getSampleRate();
+  audioData.channels = wavFile.getChannels();
+  audioData.totalSamples = static_cast<size_t>(wavFile.getFrameCount());
 
-  // Convert WAV data to our internal format for FFT analysis
-  // For visualization, we'll use only the first channel if stereo
-  size_t samplesPerChannel = audioData.totalSamples / spec.channels;
-  audioData.samples.resize(samplesPerChannel);
-
-  // Convert based on format
-  if (spec.format == SDL_AUDIO_S16) {
-    Sint16* samples = reinterpret_cast<Sint16*>(wavData);
-    for (size_t i = 0; i < samplesPerChannel; ++i) {
-      // For stereo, average the channels; for mono, just use the sample
-      if (spec.channels == 2) {
-        audioData.samples[i] = (samples[i * 2] + samples[i * 2 + 1]) / 2;
-      } else {
-        audioData.samples[i] = samples[i];
-      }
-    }
-  } else if (spec.format == SDL_AUDIO_S32) {
-    Sint32* samples = reinterpret_cast<Sint32*>(wavData);
-    for (size_t i = 0; i < samplesPerChannel; ++i) {
-      if (spec.channels == 2) {
-        audioData.samples[i] = static_cast<Sint16>(
-            (samples[i * 2] + samples[i * 2 + 1]) / 2 >> 16);
-      } else {
-        audioData.samples[i] = static_cast<Sint16>(samples[i] >> 16);
-      }
-    }
-  } else if (spec.format == SDL_AUDIO_F32) {
-    float* samples = reinterpret_cast<float*>(wavData);
-    for (size_t i = 0; i < samplesPerChannel; ++i) {
-      if (spec.channels == 2) {
-        audioData.samples[i] = static_cast<Sint16>(
-            (samples[i * 2] + samples[i * 2 + 1]) / 2.0f * 32767.0f);
-      } else {
-        audioData.samples[i] = static_cast<Sint16>(samples[i] * 32767.0f);
-      }
-    }
-  } else {
-    std::cerr << "Unsupported audio format: " << spec.format << std::endl;
-    SDL_free(wavData);
-    wavData = nullptr;
-    wavDataLen = 0;
+  // Nothing to play, and an empty loop would leave the feed nowhere to go
+  if (audioData.totalSamples == 0) {
+    std::cerr << "WAV file has no audio frames" << std::endl;
+    wavFile.close();
     return false;
   }
 
-  // Update total samples to reflect the mono conversion
-  audioData.totalSamples = samplesPerChannel;
-  audioData.channels = 1;  // We're now working with mono data for visualization
-
-  // Store the original spec for playback
-  originalSpec = spec;
+  // New files start from the top and loop as a whole
+  startFrame = 0;
+  loopStartFrame = 0;
+  loopEndFrame = getTotalFrames();
 
   audioData.loaded = true;
 
+  // Pick up an earlier batch analysis of this file, if it is still current
+  loadedPath = filename;
+  lastServedHop = -1;
+  if (analysisCache.load(filename)) {
+    std::cout << "AudioSystem: Loaded cached analysis from "
+              << AnalysisCache::getSidecarPath(filename) << " ("
+              << analysisCache.frames.size() << " hops, "
+              << analysisCache.beats.size() << " beats)" << std::endl;
+  }
+
   std::cout << "AudioSystem: Audio file loaded successfully" << std::endl;
-  std::cout << "  Samples: " << audioData.totalSamples
+  std::cout << "  Frames: " << audioData.totalSamples
             << ", Rate: " << audioData.sampleRate
-            << ", Channels: " << audioData.channels << std::endl;
-
-  // Debug: Check first few samples
-  std::cout << "AudioSystem: First 10 samples: ";
-  for (int i = 0; i < std::min(10, static_cast<int>(audioData.samples.size()));
-       ++i) {
-    std::cout << audioData.samples[i] << " ";
-  }
-  std::cout << std::endl;
+            << ", Channels: " << audioData.channels
+            << ", Bits: " << wavFile.getBitsPerSample() << std::endl;
 
   return true;
 }
 
 void AudioSystem::startPlayback() {
-  if (!audioData.loaded || playing) return;
+  if (!audioData.loaded || playing || input != AudioInput::File ||
+      getTotalFrames() == 0) {
+    return;
+  }
 
   // Initialize SDL audio if not already done
   if (SDL_WasInit(SDL_INIT_AUDIO) == 0) {
@@ -195,9 +215,25 @@ void AudioSystem::startPlayback() {
     }
   }
 
-  // Create audio stream using the original WAV format
+  wavFile.prefetch(startFrame, audioData.sampleRate);
+
+  std::lock_guard<std::mutex> lock(clockMutex);
+
+  // Feed state must be ready before the stream's callback can run
+  frameBytes = SDL_AUDIO_BYTESIZE(originalSpec.format) * originalSpec.channels;
+  feedScratch.resize(FEED_CHUNK_FRAMES * frameBytes);
+  feedFrame = startFrame;
+  feedFinished = false;
+  feedSegmentCount = 0;
+  addFeedSegment(0, startFrame);
+  framesPushed = 0;
+  lastConsumedFrames = 0;
+  lastConsumedTicks = SDL_GetPerformanceCounter();
+  pausedFrame = startFrame;
+
+  // Create audio stream using the original WAV format, fed on demand
   audioStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
-                                          &originalSpec, NULL, NULL);
+                                          &originalSpec, feedCallback, this);
 
   if (!audioStream) {
     std::cerr << "Failed to create audio stream: " << SDL_GetError()
@@ -205,9 +241,19 @@ void AudioSystem::startPlayback() {
     return;
   }
 
+  // The device pulls a buffer of this many frames at a time, converted
+  // here to frames of the source rate
+  SDL_AudioSpec deviceSpec;
+  int deviceFrames = 0;
+  deviceBufferFrames = 0;
+  if (SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(audioStream),
+                               &deviceSpec, &deviceFrames) &&
+      deviceSpec.freq > 0) {
+    deviceBufferFrames = static_cast<int64_t>(deviceFrames) *
+                         originalSpec.freq / deviceSpec.freq;
+  }
+
   // Start playback
-  currentSample = 0;
-  playbackStartTime = SDL_GetTicks();
   playing = true;
   paused = false;
 
@@ -218,13 +264,16 @@ void AudioSystem::startPlayback() {
   std::cout << "  Sample rate: " << originalSpec.freq << std::endl;
   std::cout << "  Channels: " << originalSpec.channels << std::endl;
   std::cout << "  Format: " << originalSpec.format << std::endl;
+  std::cout << "  Device buffer: " << deviceBufferFrames << " frames"
+            << std::endl;
 }
 
 void AudioSystem::stopPlayback() {
   if (playing) {
+    std::lock_guard<std::mutex> lock(clockMutex);
     playing = false;
     paused = false;
-    currentSample = 0;
+    startFrame = 0;
 
     // Destroy the audio stream
     if (audioStream) {
@@ -237,7 +286,11 @@ void AudioSystem::stopPlayback() {
 }
 
 void AudioSystem::pausePlayback() {
+  std::lock_guard<std::mutex> lock(clockMutex);
   if (playing && !paused) {
+    // Hold the clock where it is; the device stops pulling, so without this
+    // the in-buffer extrapolation would run on
+    pausedFrame = getAudibleFrameLocked();
     paused = true;
     if (audioStream) {
       SDL_PauseAudioStreamDevice(audioStream);
@@ -245,6 +298,7 @@ void AudioSystem::pausePlayback() {
     std::cout << "Audio playback paused" << std::endl;
   } else if (playing && paused) {
     paused = false;
+    lastConsumedTicks = SDL_GetPerformanceCounter();
     if (audioStream) {
       SDL_ResumeAudioStreamDevice(audioStream);
     }
@@ -252,15 +306,193 @@ void AudioSystem::pausePlayback() {
   }
 }
 
-double AudioSystem::getPlaybackPosition() const {
-  if (!audioData.loaded || !playing) return 0.0;
+void AudioSystem::seek(double seconds) {
+  if (!audioData.loaded) return;
+
+  int64_t frame = std::clamp<int64_t>(
+      static_cast<int64_t>(seconds * audioData.sampleRate), 0,
+      std::max<int64_t>(0, getTotalFrames() - 1));
+
+  // Start paging the new position in now, rather than on the audio thread
+  // when the feed first touches it
+  wavFile.prefetch(frame, audioData.sampleRate);
+
+  std::lock_guard<std::mutex> lock(clockMutex);
+  if (!audioStream) {
+    startFrame = frame;
+    return;
+  }
 
-  Uint64 currentTime = SDL_GetTicks();
-  if (playbackStartTime == 0) return 0.0;
+  // Drop what is queued and continue from the new frame. The device
+  // buffer already taken still plays out, and the clock accounts for it.
+  SDL_LockAudioStream(audioStream);
+  SDL_ClearAudioStream(audioStream);
+  feedFrame = frame;
+  feedFinished = false;
+  addFeedSegment(framesPushed, frame);
+  SDL_UnlockAudioStream(audioStream);
 
-  Uint64 elapsedMs = currentTime - playbackStartTime;
-  double elapsedSeconds = elapsedMs / 1000.0;
-  return elapsedSeconds;
+  pausedFrame = frame;
+}
+
+void AudioSystem::setLooping(bool enabled) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  if (audioStream) SDL_LockAudioStream(audioStream);
+  loopEnabled = enabled;
+  if (audioStream) SDL_UnlockAudioStream(audioStream);
+}
+
+void AudioSystem::setLoopRegion(double startSeconds, double endSeconds) {
+  if (!audioData.loaded) return;
+
+  // Keep the region at least one device-sized chunk long, so the feeder
+  // can't spin on a tiny loop. A file shorter than that loops whole.
+  int64_t totalFrames = getTotalFrames();
+  const int64_t minimumFrames =
+      std::min<int64_t>(audioData.sampleRate / 20, totalFrames);
+  int64_t start = std::clamp<int64_t>(
+      static_cast<int64_t>(startSeconds * audioData.sampleRate), 0,
+      std::max<int64_t>(0, totalFrames - minimumFrames));
+  int64_t end = std::clamp<int64_t>(
+      static_cast<int64_t>(endSeconds * audioData.sampleRate),
+      start + minimumFrames, totalFrames);
+
+  std::lock_guard<std::mutex> lock(clockMutex);
+  if (audioStream) SDL_LockAudioStream(audioStream);
+  loopStartFrame = start;
+  loopEndFrame = end;
+  if (audioStream) SDL_UnlockAudioStream(audioStream);
+}
+
+void AudioSystem::clearLoopRegion() {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  if (audioStream) SDL_LockAudioStream(audioStream);
+  loopStartFrame = 0;
+  loopEndFrame = getTotalFrames();
+  if (audioStream) SDL_UnlockAudioStream(audioStream);
+}
+
+double AudioSystem::getLoopStart() const {
+  if (!audioData.loaded) return 0.0;
+  return static_cast<double>(loopStartFrame) / audioData.sampleRate;
+}
+
+double AudioSystem::getLoopEnd() const {
+  if (!audioData.loaded) return 0.0;
+  return static_cast<double>(loopEndFrame) / audioData.sampleRate;
+}
+
+int64_t AudioSystem::getTotalFrames() const {
+  return wavFile.getFrameCount();
+}
+
+void AudioSystem::feedCallback(void* userdata, SDL_AudioStream* stream,
+                               int additionalAmount, int /*totalAmount*/) {
+  static_cast<AudioSystem*>(userdata)->feedStream(stream, additionalAmount);
+}
+
+void AudioSystem::feedStream(SDL_AudioStream* stream, int additionalBytes) {
+  // Runs on SDL's audio thread with the stream locked. Top the queue up to
+  // FEED_AHEAD_MS, and at least to what the device asked for.
+  int64_t aheadFrames =
+      static_cast<int64_t>(originalSpec.freq) * FEED_AHEAD_MS / 1000;
+  int64_t queuedFrames = SDL_GetAudioStreamQueued(stream) / frameBytes;
+  int64_t framesWanted =
+      std::max<int64_t>((additionalBytes + frameBytes - 1) / frameBytes,
+                        aheadFrames - queuedFrames);
+
+  int64_t totalFrames = getTotalFrames();
+  while (framesWanted > 0 && !feedFinished) {
+    int64_t endFrame = loopEnabled ? loopEndFrame : totalFrames;
+
+    if (feedFrame >= endFrame) {
+      // An empty loop region would never move on; play out instead
+      if (loopEnabled && loopEndFrame > loopStartFrame) {
+        feedFrame = loopStartFrame;
+        addFeedSegment(framesPushed, feedFrame);
+        continue;
+      }
+      feedFinished = true;
+      feedEndStreamFrame = framesPushed;
+      break;
+    }
+
+    int64_t count = std::min({framesWanted, endFrame - feedFrame,
+                              FEED_CHUNK_FRAMES});
+    wavFile.readPlayback(feedFrame, count, feedScratch.data());
+    SDL_PutAudioStreamData(stream, feedScratch.data(),
+                           static_cast<int>(count * frameBytes));
+    feedFrame += count;
+    framesPushed += count;
+    framesWanted -= count;
+  }
+}
+
+void AudioSystem::addFeedSegment(int64_t streamFrame, int64_t fileFrame) {
+  feedSegmentNewest = (feedSegmentNewest + 1) % FEED_SEGMENT_COUNT;
+  feedSegments[feedSegmentNewest] = {streamFrame, fileFrame};
+  feedSegmentCount = std::min(feedSegmentCount + 1, FEED_SEGMENT_COUNT);
+}
+
+int64_t AudioSystem::toFileFrame(int64_t streamFrame) const {
+  if (streamFrame < 0 || feedSegmentCount == 0) return streamFrame;
+
+  // Newest run that starts at or before the frame; the oldest kept run
+  // catches anything earlier
+  const FeedSegment* segment = nullptr;
+  for (int i = 0; i < feedSegmentCount; ++i) {
+    segment = &feedSegments[(feedSegmentNewest - i + FEED_SEGMENT_COUNT) %
+                            FEED_SEGMENT_COUNT];
+    if (segment->streamFrame <= streamFrame) break;
+  }
+  return segment->fileFrame + (streamFrame - segment->streamFrame);
+}
+
+int64_t AudioSystem::getAudibleFrame() const {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  return getAudibleFrameLocked();
+}
+
+int64_t AudioSystem::getAudibleFrameLocked() const {
+  if (!audioStream || frameBytes <= 0) return startFrame;
+  if (paused) return pausedFrame;
+
+  SDL_LockAudioStream(audioStream);
+  int64_t frame = toFileFrame(getAudibleStreamFrame());
+  SDL_UnlockAudioStream(audioStream);
+  return frame;
+}
+
+int64_t AudioSystem::getAudibleStreamFrame() const {
+  // Everything pushed that is no longer queued has gone to the device
+  int queuedBytes = std::max(0, SDL_GetAudioStreamQueued(audioStream));
+  int64_t consumedFrames = framesPushed - queuedBytes / frameBytes;
+
+  // The device takes a whole buffer at a time, so the consumed count moves
+  // in steps. The buffer just taken starts playing at the step; advance
+  // through it with the wall clock, stopping at its end.
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (consumedFrames != lastConsumedFrames) {
+    lastConsumedFrames = consumedFrames;
+    lastConsumedTicks = now;
+  }
+  double secondsIntoBuffer = static_cast<double>(now - lastConsumedTicks) /
+                             SDL_GetPerformanceFrequency();
+  double framesIntoBuffer =
+      std::min(secondsIntoBuffer * originalSpec.freq,
+               static_cast<double>(deviceBufferFrames));
+
+  double latencyFrames = outputLatencyMs / 1000.0 * originalSpec.freq;
+  return static_cast<int64_t>(std::floor(consumedFrames - deviceBufferFrames +
+                                         framesIntoBuffer - latencyFrames));
+}
+
+double AudioSystem::getPlaybackPosition() const {
+  if (!audioData.loaded || audioData.totalSamples == 0) return 0.0;
+
+  int64_t frame = std::clamp<int64_t>(getAudibleFrame(), 0,
+                                      audioData.totalSamples);
+  return static_cast<double>(frame) / audioData.sampleRate;
 }
 
 double AudioSystem::getDuration() const {
@@ -269,39 +501,73 @@ double AudioSystem::getDuration() const {
 }
 
 void AudioSystem::updatePlayback() {
-  if (!playing || !audioStream || !wavData) return;
+  // A finished analysis build is swapped in here, on the thread that reads
+  // the cache
+  if (cacheBuildDone) {
+    cacheBuildThread.join();
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    analysisCache = std::move(builtCache);
+    lastServedHop = -1;
+    cacheBuildDone = false;
+    cacheBuilding = false;
+  }
+
+  if (!playing || paused) return;
 
-  // Check if we need to feed the audio stream more data
-  // We're being lazy here, but if there's less than the entire wav file left to
-  // play, just shove a whole copy of it into the queue, so we always have tons
-  // of data queued for playback
-  if (SDL_GetAudioStreamQueued(audioStream) < (int)wavDataLen) {
-    // Feed more data to the stream. It will queue at the end, and trickle out
-    // as the hardware needs more data
-    SDL_PutAudioStreamData(audioStream, wavData, wavDataLen);
+  // The feed stops at the end of the file when not looping; stop playback
+  // once the last frame pushed has been heard
+  bool finished = false;
+  {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    if (!audioStream) return;
 
-    // Update current sample position for visualization
-    currentSample =
-        (currentSample + audioData.totalSamples) % audioData.totalSamples;
+    SDL_LockAudioStream(audioStream);
+    finished = feedFinished && getAudibleStreamFrame() >= feedEndStreamFrame;
+    SDL_UnlockAudioStream(audioStream);
+  }
+
+  if (finished) {
+    stopPlayback();
   }
 }
 
 void AudioSystem::initializeFFT() {
   std::cout << "AudioSystem: Allocating FFT buffers..." << std::endl;
 
-  fftIn = fftw_alloc_complex(fftSize);
-  fftOut = fftw_alloc_complex(fftSize);
+  // Real input only needs the non-redundant half of the spectrum
+  fftIn = fftwf_alloc_real(fftSize);
+  fftOut = fftwf_alloc_complex(fftSize / 2 + 1);
+  stereoIn = fftwf_alloc_real(STEREO_CHANNELS * fftSize);
+  stereoOut = fftwf_alloc_complex(STEREO_CHANNELS * (fftSize / 2 + 1));
 
-  if (!fftIn || !fftOut) {
+  if (!fftIn || !fftOut || !stereoIn || !stereoOut) {
     std::cerr << "AudioSystem: Failed to allocate FFT buffers!" << std::endl;
     return;
   }
 
-  std::cout << "AudioSystem: Creating FFT plan..." << std::endl;
-  fftPlan =
-      fftw_plan_dft_1d(fftSize, fftIn, fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
+  std::vector<float>& table = windowTables[fftSize];
+  if (table.empty()) {
+    table.resize(fftSize);
+    for (int i = 0; i < fftSize; ++i) {
+      table[i] = static_cast<float>(
+          0.5 * (1.0 - std::cos(2.0 * M_PI * i / (fftSize - 1))));
+    }
+  }
+  window = &table;
 
-  if (!fftPlan) {
+  if (!wisdomImported) {
+    wisdomImported = true;
+    if (fftwf_import_wisdom_from_filename(FFTW_WISDOM_FILE)) {
+      std::cout << "AudioSystem: Loaded FFTW wisdom from " << FFTW_WISDOM_FILE
+                << std::endl;
+    }
+  }
+
+  std::cout << "AudioSystem: Creating FFT plans..." << std::endl;
+  fftPlan = createPlan(1, fftIn, fftOut);
+  stereoPlan = createPlan(STEREO_CHANNELS, stereoIn, stereoOut);
+
+  if (!fftPlan || !stereoPlan) {
     std::cerr << "AudioSystem: Failed to create FFT plan!" << std::endl;
     return;
   }
@@ -309,25 +575,84 @@ void AudioSystem::initializeFFT() {
   std::cout << "AudioSystem: FFT initialization complete" << std::endl;
 }
 
+fftwf_plan AudioSystem::createPlan(int channels, float* in,
+                                   fftwf_complex* out) {
+  // One transform per channel, each fftSize samples in and fftSize / 2 + 1
+  // bins out after the last
+  int size = fftSize;
+  auto plan = [&](unsigned flags) {
+    return fftwf_plan_many_dft_r2c(1, &size, channels, in, nullptr, 1, size,
+                                   out, nullptr, 1, size / 2 + 1, flags);
+  };
+
+  fftwf_plan result = plan(FFTW_MEASURE | FFTW_WISDOM_ONLY);
+  if (!result) {
+    // No saved wisdom for this shape yet: measure once and save the result
+    result = plan(FFTW_MEASURE);
+    if (result && !fftwf_export_wisdom_to_filename(FFTW_WISDOM_FILE)) {
+      std::cerr << "AudioSystem: Failed to save FFTW wisdom to "
+                << FFTW_WISDOM_FILE << std::endl;
+    }
+  }
+  return result;
+}
+
 void AudioSystem::cleanupFFT() {
   if (fftPlan) {
-    fftw_destroy_plan(fftPlan);
+    fftwf_destroy_plan(fftPlan);
     fftPlan = nullptr;
   }
   if (fftIn) {
-    fftw_free(fftIn);
+    fftwf_free(fftIn);
     fftIn = nullptr;
   }
   if (fftOut) {
-    fftw_free(fftOut);
+    fftwf_free(fftOut);
     fftOut = nullptr;
   }
+  if (stereoPlan) {
+    fftwf_destroy_plan(stereoPlan);
+    stereoPlan = nullptr;
+  }
+  if (stereoIn) {
+    fftwf_free(stereoIn);
+    stereoIn = nullptr;
+  }
+  if (stereoOut) {
+    fftwf_free(stereoOut);
+    stereoOut = nullptr;
+  }
 }
 
-AudioSystem::FFTResult AudioSystem::performFFT(
-    const std::vector<float>& audioBuffer) {
-  FFTResult result;
+void AudioSystem::updateFrequencyTable() {
+  FFTResult& result = fftResult;
+  const int sampleRate = getAnalysisSampleRate();
+  if (result.fftSize == fftSize && frequencyTableRate == sampleRate) {
+    return;
+  }
+
   result.fftSize = fftSize;
+  result.spectrum.assign(fftSize / 2, {});
+  result.magnitudes.assign(fftSize / 2, 0.0);
+  result.frequencies.resize(fftSize / 2);
+  for (int i = 0; i < fftSize / 2; ++i) {
+    result.frequencies[i] = static_cast<double>(i) * sampleRate / fftSize;
+  }
+  frequencyTableRate = sampleRate;
+
+  for (SpectralAnalyzer* analyzer :
+       {&spectralAnalyzer, &leftAnalyzer, &rightAnalyzer}) {
+    analyzer->configure(result.frequencies.data(), result.frequencies.size());
+  }
+  leftMagnitudes.assign(fftSize / 2, 0.0);
+  rightMagnitudes.assign(fftSize / 2, 0.0);
+  configureFilterbank();
+}
+
+const AudioSystem::FFTResult& AudioSystem::performFFT(
+    const std::vector<float>& audioBuffer) {
+  FFTResult& result = fftResult;
+  updateFrequencyTable();
 
   // Check if FFT is properly initialized
   if (!fftPlan || !fftIn || !fftOut) {
@@ -335,297 +660,765 @@ AudioSystem::FFTResult AudioSystem::performFFT(
     return result;
   }
 
-  // Apply window function (Hann window) and copy to FFT input
-  for (int i = 0; i < fftSize; ++i) {
-    float window = 0.5f * (1.0f - cos(2.0f * M_PI * i / (fftSize - 1)));
-    fftIn[i][0] = (static_cast<size_t>(i) < audioBuffer.size())
-                      ? audioBuffer[i] * window
-                      : 0.0;
-    fftIn[i][1] = 0.0;
+  // Apply the cached Hann window and copy to FFT input, zero padding
+  const float* hann = window->data();
+  size_t count = std::min(audioBuffer.size(), static_cast<size_t>(fftSize));
+  for (size_t i = 0; i < count; ++i) {
+    fftIn[i] = audioBuffer[i] * hann[i];
   }
+  std::fill(fftIn + count, fftIn + fftSize, 0.0f);
 
   // Perform FFT
-  fftw_execute(fftPlan);
+  fftwf_execute(fftPlan);
 
   // Process results
-  result.spectrum.resize(fftSize / 2);
-  result.magnitudes.resize(fftSize / 2);
-  result.frequencies.resize(fftSize / 2);
-
   for (int i = 0; i < fftSize / 2; ++i) {
     double real = fftOut[i][0];
     double imag = fftOut[i][1];
     result.spectrum[i] = std::complex<double>(real, imag);
     result.magnitudes[i] = std::sqrt(real * real + imag * imag);
-    result.frequencies[i] =
-        static_cast<double>(i) * audioData.sampleRate / fftSize;
   }
 
   return result;
 }
 
-void AudioSystem::updateVisualizationData() {
-  // Initialize buffer if empty
-  if (fftBuffer.empty()) {
-    fftBuffer.resize(fftSize, 0.0f);
+void AudioSystem::updateVisualizationData() { vizSnapshots.acquire(); }
+
+const AudioSystem::FFTResult& AudioSystem::performStereoFFT() {
+  FFTResult& result = fftResult;
+  updateFrequencyTable();
+
+  if (!stereoPlan || !stereoIn || !stereoOut) {
+    std::cerr << "AudioSystem: FFT not properly initialized!" << std::endl;
+    return result;
   }
 
-  if (!playing || !audioData.loaded) {
-    // If not playing or no audio loaded, just return with zero data
-    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
-    return;
+  // Window both channels of the planar buffer into the batched input
+  const float* hann = window->data();
+  for (int channel = 0; channel < STEREO_CHANNELS; ++channel) {
+    const float* samples = stereoBuffer.data() + channel * fftSize;
+    float* in = stereoIn + channel * fftSize;
+    for (int i = 0; i < fftSize; ++i) {
+      in[i] = samples[i] * hann[i];
+    }
   }
 
-  // Calculate the actual current playback position based on elapsed time
-  Uint64 currentTime = SDL_GetTicks();
-  if (playbackStartTime == 0) {
-    playbackStartTime = currentTime;
+  // Left and right in one call
+  fftwf_execute(stereoPlan);
+
+  const fftwf_complex* left = stereoOut;
+  const fftwf_complex* right = stereoOut + (fftSize / 2 + 1);
+  for (int i = 0; i < fftSize / 2; ++i) {
+    double leftReal = left[i][0];
+    double leftImag = left[i][1];
+    double rightReal = right[i][0];
+    double rightImag = right[i][1];
+    leftMagnitudes[i] = std::sqrt(leftReal * leftReal + leftImag * leftImag);
+    rightMagnitudes[i] =
+        std::sqrt(rightReal * rightReal + rightImag * rightImag);
+
+    // Mono is the mean of the channels, and so is its spectrum
+    double real = 0.5 * (leftReal + rightReal);
+    double imag = 0.5 * (leftImag + rightImag);
+    result.spectrum[i] = std::complex<double>(real, imag);
+    result.magnitudes[i] = std::sqrt(real * real + imag * imag);
   }
 
-  Uint64 elapsedMs = currentTime - playbackStartTime;
-  double elapsedSeconds = elapsedMs / 1000.0;
-  size_t actualSamplePosition =
-      static_cast<size_t>(elapsedSeconds * audioData.sampleRate) %
-      audioData.totalSamples;
+  return result;
+}
 
-  // Get current audio data for visualization using the actual playback position
-  size_t startSample = actualSamplePosition;
-  size_t numSamples = std::min(static_cast<size_t>(fftSize),
-                               audioData.samples.size() - startSample);
+void AudioSystem::setAnalysisHopSize(int samples) {
+  if (samples > 0) {
+    analysisHopSize = samples;
+    analysisWake.notify_all();
+  }
+}
+
+double AudioSystem::getAnalysisRate() const {
+  return static_cast<double>(getAnalysisSampleRate()) / analysisHopSize;
+}
+
+int AudioSystem::getAnalysisSampleRate() const {
+  if (input != AudioInput::File) return captureSampleRate;
+  return audioData.loaded ? audioData.sampleRate : 44100;
+}
 
-  if (numSamples > 0) {
-    // Convert Sint16 samples to normalized float values for FFT
-    fftBuffer.clear();
-    fftBuffer.reserve(fftSize);
+void AudioSystem::analysisLoop() {
+  using Clock = std::chrono::steady_clock;
 
-    for (size_t i = 0; i < numSamples; ++i) {
-      Sint16 sample = audioData.samples[startSample + i];
-      float normalizedSample = static_cast<float>(sample) / 32767.0f;
-      fftBuffer.push_back(normalizedSample);
+  auto nextTick = Clock::now();
+  std::unique_lock<std::mutex> lock(analysisMutex);
+
+  while (!analysisStopping) {
+    bool live = input != AudioInput::File;
+    if (live ? captureSource != nullptr
+             : playing && !paused && audioData.loaded) {
+      Uint64 start = SDL_GetPerformanceCounter();
+
+      bool analyzed = true;
+      if (live) {
+        analyzed = analyzeCapture();
+      } else if (useAnalysisCache && analysisCache.isLoaded()) {
+        serveCachedAnalysis();
+      } else {
+        analyzeCurrentPosition();
+      }
+
+      if (analyzed) {
+        vizSnapshots.getWriteBuffer() = analysisState;
+        vizSnapshots.publish();
+
+        lastAnalysisMs = static_cast<float>(
+            (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+            SDL_GetPerformanceFrequency());
+      }
     }
 
-    // Pad with zeros if needed
-    while (fftBuffer.size() < static_cast<size_t>(fftSize)) {
-      fftBuffer.push_back(0.0f);
+    // One analysis per hop of playback, regardless of the frame rate
+    nextTick += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / getAnalysisRate()));
+
+    // After a stall, carry on from now instead of analyzing in a burst
+    auto now = Clock::now();
+    if (nextTick < now) {
+      nextTick = now;
     }
+
+    analysisWake.wait_until(lock, nextTick,
+                            [this] { return analysisStopping; });
+  }
+}
+
+const AudioSystem::VisualizationData& AudioSystem::analyzeSamples(
+    const float* samples, size_t count) {
+  std::lock_guard<std::mutex> lock(analysisMutex);
+
+  fftBuffer.resize(fftSize);
+  count = std::min(count, static_cast<size_t>(fftSize));
+  std::copy(samples, samples + count, fftBuffer.begin());
+  std::fill(fftBuffer.begin() + count, fftBuffer.end(), 0.0f);
+
+  analyzeBuffer();
+  return analysisState;
+}
+
+const AudioSystem::VisualizationData& AudioSystem::analyzeStereoSamples(
+    const float* left, const float* right, size_t count) {
+  std::lock_guard<std::mutex> lock(analysisMutex);
+
+  stereoBuffer.resize(STEREO_CHANNELS * fftSize);
+  count = std::min(count, static_cast<size_t>(fftSize));
+  float* bufferLeft = stereoBuffer.data();
+  float* bufferRight = stereoBuffer.data() + fftSize;
+  std::copy(left, left + count, bufferLeft);
+  std::copy(right, right + count, bufferRight);
+  std::fill(bufferLeft + count, bufferLeft + fftSize, 0.0f);
+  std::fill(bufferRight + count, bufferRight + fftSize, 0.0f);
+
+  analyzeStereoBuffer();
+  return analysisState;
+}
+
+const AudioSystem::VisualizationData& AudioSystem::analyzeCapturedFrames(
+    const StereoFrame* frames, size_t count) {
+  std::lock_guard<std::mutex> lock(analysisMutex);
+
+  captureRing.write(frames, count);
+  analyzeCapture();
+  return analysisState;
+}
+
+bool AudioSystem::setInput(AudioInput input, const std::string& deviceName) {
+  // Live inputs take over the analysis from file playback
+  if (input != AudioInput::File) {
+    stopPlayback();
+  }
+
+  std::lock_guard<std::mutex> lock(analysisMutex);
+
+  if (captureSource) {
+    captureSource->stop();
+    captureSource.reset();
+  }
+  this->input = AudioInput::File;
+  inputError.clear();
+  tempoTracker.reset();
+
+  if (input == AudioInput::File) {
+    return true;
+  }
+
+  std::unique_ptr<CaptureSource> source;
+  if (input == AudioInput::Recording) {
+    source = std::make_unique<RecordingSource>(deviceName);
   } else {
-    // No samples available, fill with zeros
-    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    source = std::make_unique<GeneratorSource>();
   }
 
-  // Ensure buffer has the correct size
-  if (fftBuffer.size() != static_cast<size_t>(fftSize)) {
-    fftBuffer.resize(fftSize, 0.0f);
+  // Nothing is producing now, so the ring can be emptied from here
+  captureRing.discard(captureRing.size());
+  std::fill(stereoBuffer.begin(), stereoBuffer.end(), 0.0f);
+
+  if (!source->start(captureRing)) {
+    inputError = source->getError();
+    std::cerr << "AudioSystem: Failed to start " << getAudioInputName(input)
+              << ": " << inputError << std::endl;
+    return false;
   }
 
-  // Perform FFT on current buffer
-  FFTResult fft = performFFT(fftBuffer);
-
-  // Calculate frequency bands
-  calculateFrequencyBands(fft, vizData);
-
-  // Compute spectral flux (band-limited, log-compressed) and EMA smooth it
-  const double fluxLowHz = 30.0;
-  const double fluxHighHz = 4000.0;
-  vizData.spectralFlux = 0.0;
-  if (vizData.lastMagnitudes.size() != fft.magnitudes.size()) {
-    vizData.lastMagnitudes.assign(fft.magnitudes.size(), 0.0);
-  }
-  for (size_t i = 0; i < fft.magnitudes.size(); ++i) {
-    double freq = fft.frequencies[i];
-    if (freq < fluxLowHz || freq > fluxHighHz) continue;
-    double curr = std::log1p(fft.magnitudes[i]);
-    double prev = std::log1p(vizData.lastMagnitudes[i]);
-    double diff = curr - prev;
-    if (diff > 0.0) vizData.spectralFlux += diff;
-  }
-  vizData.lastMagnitudes = fft.magnitudes;
-
-  // EMA smoothing for stability
-  const double emaAlpha = 0.2;  // responsiveness (0..1)
-  if (vizData.spectralFluxEMA == 0.0) {
-    vizData.spectralFluxEMA = vizData.spectralFlux;
+  captureSampleRate = source->getSampleRate();
+  captureSource = std::move(source);
+  this->input = input;
+  analysisWake.notify_all();
+
+  std::cout << "AudioSystem: Capturing from " << getAudioInputName(input)
+            << " at " << captureSampleRate << " Hz" << std::endl;
+  return true;
+}
+
+uint64_t AudioSystem::getDroppedCaptureFrames() const {
+  return captureSource ? captureSource->getDroppedFrames() : 0;
+}
+
+bool AudioSystem::analyzeCapture() {
+  // Sized once per FFT size; a no-op from then on
+  stereoBuffer.resize(STEREO_CHANNELS * fftSize);
+  captureScratch.resize(fftSize);
+
+  const size_t hop = static_cast<size_t>(analysisHopSize);
+  size_t hops = captureRing.size() / hop;
+  if (hops == 0) return false;
+
+  // Frames older than one window can't affect the newest analysis. Skip
+  // them, so a stall never leaves the visuals lagging behind the input.
+  const size_t maxHops = std::max<size_t>(1, fftSize / hop);
+  if (hops > maxHops) {
+    captureRing.discard((hops - maxHops) * hop);
+    hops = maxHops;
+  }
+
+  // Slide the window along one hop at a time, so flux and beat detection
+  // see the same steps as they do for a file
+  const size_t window = static_cast<size_t>(fftSize);
+  const size_t keep = std::min(hop, window);
+  float* left = stereoBuffer.data();
+  float* right = stereoBuffer.data() + fftSize;
+  for (size_t h = 0; h < hops; ++h) {
+    captureRing.discard(hop - keep);
+    captureRing.read(captureScratch.data(), keep);
+
+    std::copy(left + keep, left + window, left);
+    std::copy(right + keep, right + window, right);
+    for (size_t i = 0; i < keep; ++i) {
+      left[window - keep + i] = captureScratch[i].left;
+      right[window - keep + i] = captureScratch[i].right;
+    }
+
+    analyzeStereoBuffer();
+  }
+  return true;
+}
+
+// What a background build takes from the AudioSystem when it starts
+struct AudioSystem::CacheBuild {
+  std::string path;
+  int sampleRate = 0;
+  int fftSize = 0;
+  int hopSize = 0;
+  int64_t totalFrames = 0;
+  std::vector<float> window;
+  fftwf_plan plan = nullptr;
+};
+
+void AudioSystem::setJobSystem(JobSystem* jobSystem) {
+  // The build may be splitting work across the old pool
+  stopAnalysisCacheBuild();
+  this->jobSystem = jobSystem;
+}
+
+bool AudioSystem::buildAnalysisCache() {
+  if (!audioData.loaded || cacheBuilding) return false;
+  if (cacheBuildThread.joinable()) cacheBuildThread.join();
+
+  auto build = std::make_shared<CacheBuild>();
+  {
+    // FFTW plans on one thread at a time, and live analysis plans under
+    // this lock, so the build's own plan is made here. The live plan left
+    // wisdom for this size, so measuring again costs nothing.
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    if (!fftPlan) return false;
+
+    build->path = loadedPath;
+    build->sampleRate = audioData.sampleRate;
+    build->fftSize = fftSize;
+    build->hopSize = analysisHopSize;
+    build->totalFrames = getTotalFrames();
+    build->window = *window;
+
+    BatchWorkspace planning(fftSize);
+    build->plan = fftwf_plan_dft_r2c_1d(fftSize, planning.in, planning.out,
+                                        FFTW_MEASURE);
+    if (!build->plan) return false;
+  }
+
+  cacheHopCount = static_cast<size_t>(
+      (build->totalFrames + build->hopSize - 1) / build->hopSize);
+  cacheHopsDone = 0;
+  cacheBuildCancelled = false;
+  cacheBuildDone = false;
+  cacheBuilding = true;
+  cacheBuildThread =
+      std::thread([this, build] { runAnalysisCacheBuild(*build); });
+  return true;
+}
+
+float AudioSystem::getAnalysisCacheProgress() const {
+  if (!cacheBuilding || cacheHopCount == 0) return 0.0f;
+  return static_cast<float>(cacheHopsDone) / cacheHopCount;
+}
+
+void AudioSystem::stopAnalysisCacheBuild() {
+  cacheBuildCancelled = true;
+  if (cacheBuildThread.joinable()) cacheBuildThread.join();
+  cacheBuilding = false;
+  cacheBuildDone = false;
+  builtCache.clear();
+}
+
+void AudioSystem::runAnalysisCacheBuild(CacheBuild& build) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  const int fftSize = build.fftSize;
+  const int hopSize = build.hopSize;
+  const size_t hopCount = cacheHopCount;
+
+  AnalysisCache cache;
+  cache.sampleRate = build.sampleRate;
+  cache.fftSize = fftSize;
+  cache.hopSize = hopSize;
+  cache.frames.resize(hopCount);
+
+  std::vector<double> frequencies(fftSize / 2);
+  for (int i = 0; i < fftSize / 2; ++i) {
+    frequencies[i] = static_cast<double>(i) * build.sampleRate / fftSize;
+  }
+
+  // Same window placement and features as analyzeCurrentPosition, with
+  // the file zero padded at both ends instead of wrapping
+  auto analyzeHop = [&](size_t hop, BatchWorkspace& workspace,
+                        AnalysisCache::Frame* frame) {
+    std::vector<float>& samples = workspace.samples;
+    int64_t windowStart = static_cast<int64_t>(hop) * hopSize - fftSize / 2;
+    int64_t first = std::max<int64_t>(windowStart, 0);
+    size_t offset = static_cast<size_t>(first - windowStart);
+    size_t count = static_cast<size_t>(
+        wavFile.readMono(first, fftSize - offset, samples.data() + offset));
+    std::fill(samples.begin(), samples.begin() + offset, 0.0f);
+    std::fill(samples.begin() + offset + count, samples.end(), 0.0f);
+
+    const float* hann = build.window.data();
+    for (int i = 0; i < fftSize; ++i) {
+      workspace.in[i] = samples[i] * hann[i];
+    }
+    fftwf_execute_dft_r2c(build.plan, workspace.in, workspace.out);
+    for (int i = 0; i < fftSize / 2; ++i) {
+      double real = workspace.out[i][0];
+      double imag = workspace.out[i][1];
+      workspace.magnitudes[i] = std::sqrt(real * real + imag * imag);
+    }
+
+    SpectralFeatures features;
+    workspace.analyzer.compute(workspace.magnitudes.data(), features);
+    if (!frame) return;
+
+    for (int band = 0; band < AnalysisCache::Frame::BAND_COUNT; ++band) {
+      frame->bandLevels[band] = static_cast<float>(features.bandLevels[band]);
+    }
+    frame->centroid = static_cast<float>(features.centroid);
+    frame->rolloff = static_cast<float>(features.rolloff);
+    frame->flux = static_cast<float>(features.flux);
+
+    double sum = 0.0;
+    for (float sample : samples) {
+      sum += sample * sample;
+    }
+    frame->rmsEnergy = static_cast<float>(std::sqrt(sum / fftSize));
+    frame->peak = *std::max_element(samples.begin(), samples.end());
+  };
+
+  auto analyzeChunk = [&](size_t begin, size_t end) {
+    if (cacheBuildCancelled) return;
+    BatchWorkspace workspace(fftSize);
+    workspace.analyzer.configure(frequencies.data(), frequencies.size());
+    if (begin > 0) {
+      analyzeHop(begin - 1, workspace, nullptr);
+    }
+    for (size_t hop = begin; hop < end && !cacheBuildCancelled; ++hop) {
+      analyzeHop(hop, workspace, &cache.frames[hop]);
+      cacheHopsDone.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  if (jobSystem) {
+    jobSystem->parallelFor(hopCount, BATCH_CHUNK_HOPS, analyzeChunk);
   } else {
-    vizData.spectralFluxEMA = emaAlpha * vizData.spectralFlux +
-                              (1.0 - emaAlpha) * vizData.spectralFluxEMA;
+    analyzeChunk(0, hopCount);
   }
 
-  // Update spectral flux history of smoothed values (cap to 128 entries)
-  vizData.spectralFluxHistory.push_back(vizData.spectralFluxEMA);
-  while (vizData.spectralFluxHistory.size() > 128) {
-    vizData.spectralFluxHistory.pop_front();
+  {
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    fftwf_destroy_plan(build.plan);
+  }
+  if (cacheBuildCancelled) return;
+
+  // Beat detection and the tempo tracker carry state from hop to hop, so
+  // replay them in order over the flux, on the playback timeline. The
+  // tracker plans and destroys FFTs, which happens under analysisMutex
+  auto tracker = std::make_unique<TempoTracker>();
+  {
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    tracker->configure(static_cast<double>(build.sampleRate) / hopSize);
   }
 
-  // Calculate RMS energy
-  double sum = 0.0;
-  for (const auto& sample : fftBuffer) {
-    sum += sample * sample;
+  VisualizationData replay{};
+  for (size_t hop = 0; hop < hopCount; ++hop) {
+    AnalysisCache::Frame& frame = cache.frames[hop];
+    replay.spectralFlux = frame.flux;
+    smoothFlux(replay);
+    frame.smoothedFlux = static_cast<float>(replay.spectralFluxEMA);
+
+    detectBeat(replay, static_cast<Uint64>(cache.getHopTime(hop) * 1000.0));
+    if (replay.isBeat) {
+      cache.beats.push_back({static_cast<uint32_t>(hop),
+                             static_cast<float>(replay.beatIntensity)});
+    }
+    tracker->push(frame.flux);
   }
-  vizData.rmsEnergy = std::sqrt(sum / fftBuffer.size());
 
-  // Calculate spectral centroid
-  double weightedSum = 0.0;
-  double magnitudeSum = 0.0;
-  for (size_t i = 0; i < fft.magnitudes.size(); ++i) {
-    weightedSum += fft.frequencies[i] * fft.magnitudes[i];
-    magnitudeSum += fft.magnitudes[i];
+  // The estimate as of the last hop, over the track's final window
+  cache.tempo = tracker->getTempo();
+  {
+    std::lock_guard<std::mutex> lock(analysisMutex);
+    tracker.reset();
   }
-  vizData.spectralCentroid =
-      (magnitudeSum > 0) ? weightedSum / magnitudeSum : 0.0;
 
-  // Calculate spectral rolloff (frequency below which 85% of energy is
-  // contained)
-  double totalEnergy = 0.0;
-  for (const auto& mag : fft.magnitudes) {
-    totalEnergy += mag * mag;
+  double elapsedMs = static_cast<double>(SDL_GetPerformanceCounter() - start) *
+                     1000.0 / SDL_GetPerformanceFrequency();
+  std::cout << "AudioSystem: Analyzed " << hopCount << " hops in "
+            << elapsedMs << " ms, " << cache.beats.size() << " beats, "
+            << cache.tempo << " BPM" << std::endl;
+
+  if (!cache.save(build.path)) {
+    std::cerr << "AudioSystem: Failed to save analysis to "
+              << AnalysisCache::getSidecarPath(build.path) << std::endl;
   }
 
-  double targetEnergy = 0.85 * totalEnergy;
-  double currentEnergy = 0.0;
-  vizData.spectralRolloff = 0.0;
+  builtCache = std::move(cache);
+  cacheBuildDone = true;
+}
+
+double AudioSystem::getNextBeatTime() const {
+  if (!analysisCache.isLoaded()) return -1.0;
 
-  for (size_t i = 0; i < fft.magnitudes.size(); ++i) {
-    currentEnergy += fft.magnitudes[i] * fft.magnitudes[i];
-    if (currentEnergy >= targetEnergy) {
-      vizData.spectralRolloff = fft.frequencies[i];
-      break;
+  size_t hop = analysisCache.getHopIndex(getAudibleFrame());
+  const AnalysisCache::Beat* beat = analysisCache.findNextBeat(hop);
+  return beat ? analysisCache.getHopTime(beat->hop) : -1.0;
+}
+
+void AudioSystem::analyzeCurrentPosition() {
+  // Sized once per FFT size; a no-op from then on
+  fftBuffer.resize(fftSize, 0.0f);
+
+  const int64_t totalFrames = getTotalFrames();
+  if (!playing || !audioData.loaded || totalFrames == 0) {
+    // If not playing or no audio loaded, just return with zero data
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    return;
+  }
+
+  // Center the window on the sample being heard right now, so features
+  // line up with what is audible rather than trailing it
+  int64_t audibleFrame = getAudibleFrame();
+  int64_t windowStart = audibleFrame - fftSize / 2;
+
+  // Frames before playback started are silence
+  size_t silentFrames = static_cast<size_t>(
+      std::clamp<int64_t>(-windowStart, 0, fftSize));
+
+  // Decode just this window from the mapped file, running on past its end
+  // the way the feed does: back to the loop start when looping, into
+  // silence when not
+  int64_t loopStart;
+  int64_t endFrame;
+  {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    const bool looping = loopEnabled && loopEndFrame > loopStartFrame;
+    loopStart = looping ? loopStartFrame : -1;
+    endFrame = looping ? loopEndFrame : totalFrames;
+  }
+
+  const bool stereo = wavFile.getChannels() >= STEREO_CHANNELS;
+  if (stereo) stereoBuffer.resize(STEREO_CHANNELS * fftSize);
+  float* left = stereo ? stereoBuffer.data() : fftBuffer.data();
+  float* right = stereo ? stereoBuffer.data() + fftSize : nullptr;
+
+  int64_t frame = std::max<int64_t>(windowStart, 0);
+  size_t i = silentFrames;
+  while (i < static_cast<size_t>(fftSize)) {
+    if (frame >= endFrame) {
+      if (loopStart < 0) break;
+      frame = loopStart;
     }
+    const int64_t count = std::min<int64_t>(fftSize - i, endFrame - frame);
+    const int64_t read =
+        stereo ? wavFile.readStereo(frame, count, left + i, right + i)
+               : wavFile.readMono(frame, count, left + i);
+    if (read <= 0) break;
+    i += static_cast<size_t>(read);
+    frame += read;
   }
 
-  // Update peak detection
-  if (!fftBuffer.empty()) {
-    vizData.currentPeak = *std::max_element(fftBuffer.begin(), fftBuffer.end());
+  // Silence before playback started and after a track that doesn't loop
+  std::fill(left, left + silentFrames, 0.0f);
+  std::fill(left + i, left + fftSize, 0.0f);
+  if (stereo) {
+    std::fill(right, right + silentFrames, 0.0f);
+    std::fill(right + i, right + fftSize, 0.0f);
+    analyzeStereoBuffer();
   } else {
-    vizData.currentPeak = 0.0;
-  }
-  updatePeakHistory(vizData);
-
-  // Detect beats
-  detectBeat(vizData);
-
-  // Debug output (remove this later)
-  static int debugCounter = 0;
-  if (++debugCounter % 60 ==
-      0) {  // Print every 60 frames (about once per second)
-    std::cout << "AudioSystem: Visualization update - "
-              << "Playing: " << playing << ", RMS Energy: " << vizData.rmsEnergy
-              << ", Current Peak: " << vizData.currentPeak
-              << ", Bass Level: " << vizData.bassLevel
-              << ", Sample Position: " << actualSamplePosition
-              << ", FFT Buffer Size: " << fftBuffer.size()
-              << ", Max FFT Magnitude: "
-              << (fft.magnitudes.empty()
-                      ? 0.0
-                      : *std::max_element(fft.magnitudes.begin(),
-                                          fft.magnitudes.end()))
-              << std::endl;
+    analyzeBuffer();
   }
 }
 
-void AudioSystem::calculateFrequencyBands(const FFTResult& fft,
-                                          VisualizationData& data) {
-  // Define frequency bands
-  const double bassFreq = 250.0;
-  const double lowMidFreq = 500.0;
-  const double midFreq = 2000.0;
-  const double highMidFreq = 4000.0;
+void AudioSystem::serveCachedAnalysis() {
+  const AnalysisCache& cache = analysisCache;
+  size_t hop = cache.getHopIndex(getAudibleFrame());
+  const AnalysisCache::Frame& frame = cache.frames[hop];
+
+  analysisState.bassLevel = frame.bandLevels[0];
+  analysisState.lowMidLevel = frame.bandLevels[1];
+  analysisState.midLevel = frame.bandLevels[2];
+  analysisState.highMidLevel = frame.bandLevels[3];
+  analysisState.trebleLevel = frame.bandLevels[4];
+  analysisState.spectralCentroid = frame.centroid;
+  analysisState.spectralRolloff = frame.rolloff;
+  analysisState.spectralFlux = frame.flux;
+  analysisState.spectralFluxEMA = frame.smoothedFlux;
+  analysisState.spectralFluxHistory.push(frame.smoothedFlux);
+
+  // The cache doesn't keep spectra to filter, or the channels apart
+  analysisState.filterbankBandCount = 0;
+  std::copy(std::begin(frame.bandLevels), std::end(frame.bandLevels),
+            analysisState.leftBandLevels.begin());
+  analysisState.rightBandLevels = analysisState.leftBandLevels;
+  analysisState.stereoCorrelation = 1.0;
+  analysisState.stereoWidth = 0.0;
+
+  analysisState.rmsEnergy = frame.rmsEnergy;
+  analysisState.currentPeak = frame.peak;
+  updatePeakHistory(analysisState);
+
+  // Report a beat if one falls in the hops played since the last call.
+  // After a seek, or the first time, only the current hop counts.
+  const int64_t maxStep = static_cast<int64_t>(
+      std::ceil(CACHE_SEEK_SECONDS * cache.sampleRate / cache.hopSize));
+  int64_t step = static_cast<int64_t>(hop) - lastServedHop;
+  size_t firstHop =
+      lastServedHop >= 0 && step > 0 && step <= maxStep ? lastServedHop + 1
+                                                        : hop;
+  const AnalysisCache::Beat* beat =
+      firstHop > 0 ? cache.findNextBeat(firstHop - 1)
+                   : (cache.beats.empty() ? nullptr : &cache.beats.front());
+
+  if (beat && beat->hop <= hop) {
+    analysisState.isBeat = true;
+    analysisState.beatIntensity = beat->intensity;
+
+    // Stamped like a live beat, at the end of its hop, so readers that
+    // missed this snapshot still see lastBeatMs move. A loop or seek can
+    // bring the same beat round again, and that is still a new beat.
+    Uint64 beatMs =
+        static_cast<Uint64>(cache.getHopTime(beat->hop + 1) * 1000.0);
+    analysisState.lastBeatMs =
+        beatMs != analysisState.lastBeatMs ? beatMs : beatMs + 1;
+  } else {
+    analysisState.isBeat = false;
+    analysisState.beatIntensity =
+        std::max(0.0, analysisState.beatIntensity * 0.92);
+  }
 
-  // Find max magnitude for normalization (avoid DC bin)
-  double maxMagnitude = 0.0;
-  for (size_t i = 1; i < fft.magnitudes.size(); ++i) {
-    maxMagnitude = std::max(maxMagnitude, fft.magnitudes[i]);
+  // The cached beats are known, not predicted
+  analysisState.isPredictedBeat = analysisState.isBeat;
+  const AnalysisCache::Beat* next = cache.findNextBeat(hop);
+  if (cache.tempo > 0.0) {
+    double period = 60.0 / cache.tempo;
+    analysisState.tempoEstimate = cache.tempo;
+    analysisState.tempoConfidence = 1.0;
+    analysisState.secondsToNextBeat =
+        next ? cache.getHopTime(next->hop) - cache.getHopTime(hop) : -1.0;
+    analysisState.beatPhase =
+        next ? std::clamp(1.0 - analysisState.secondsToNextBeat / period, 0.0,
+                          1.0)
+             : 0.0;
   }
-  if (maxMagnitude <= 0.0) {
-    data.bassLevel = 0.0;
-    data.lowMidLevel = 0.0;
-    data.midLevel = 0.0;
-    data.highMidLevel = 0.0;
-    data.trebleLevel = 0.0;
-    return;
+  lastServedHop = static_cast<int64_t>(hop);
+}
+
+void AudioSystem::analyzeBuffer() {
+  // Perform FFT on current buffer
+  const FFTResult& fft = performFFT(fftBuffer);
+
+  SpectralFeatures features;
+  analyzeSpectrum(fft, features);
+
+  // A mono source sits dead centre
+  std::copy(std::begin(features.bandLevels), std::end(features.bandLevels),
+            analysisState.leftBandLevels.begin());
+  analysisState.rightBandLevels = analysisState.leftBandLevels;
+  analysisState.stereoCorrelation = 1.0;
+  analysisState.stereoWidth = 0.0;
+}
+
+void AudioSystem::analyzeStereoBuffer() {
+  const float* left = stereoBuffer.data();
+  const float* right = stereoBuffer.data() + fftSize;
+
+  // The mono mix drives everything but the stereo image. Correlation and
+  // width come from the same pass.
+  fftBuffer.resize(fftSize);
+  double leftEnergy = 0.0;
+  double rightEnergy = 0.0;
+  double crossEnergy = 0.0;
+  for (int i = 0; i < fftSize; ++i) {
+    fftBuffer[i] = 0.5f * (left[i] + right[i]);
+    leftEnergy += static_cast<double>(left[i]) * left[i];
+    rightEnergy += static_cast<double>(right[i]) * right[i];
+    crossEnergy += static_cast<double>(left[i]) * right[i];
   }
 
-  double bassSum = 0.0, lowMidSum = 0.0, midSum = 0.0, highMidSum = 0.0,
-         trebleSum = 0.0;
-  int bassCount = 0, lowMidCount = 0, midCount = 0, highMidCount = 0,
-      trebleCount = 0;
-
-  // Skip DC component (i == 0) to avoid biasing bass
-  for (size_t i = 1; i < fft.frequencies.size(); ++i) {
-    double freq = fft.frequencies[i];
-    // Normalize magnitude to [0,1]
-    double magnitude = fft.magnitudes[i] / maxMagnitude;
-
-    if (freq <= bassFreq) {
-      bassSum += magnitude;
-      bassCount++;
-    } else if (freq <= lowMidFreq) {
-      lowMidSum += magnitude;
-      lowMidCount++;
-    } else if (freq <= midFreq) {
-      midSum += magnitude;
-      midCount++;
-    } else if (freq <= highMidFreq) {
-      highMidSum += magnitude;
-      highMidCount++;
-    } else {
-      trebleSum += magnitude;
-      trebleCount++;
-    }
+  const FFTResult& fft = performStereoFFT();
+
+  SpectralFeatures features;
+  analyzeSpectrum(fft, features);
+
+  // Only the band levels are shown per side
+  leftAnalyzer.computeBands(leftMagnitudes.data(),
+                            analysisState.leftBandLevels.data());
+  rightAnalyzer.computeBands(rightMagnitudes.data(),
+                             analysisState.rightBandLevels.data());
+
+  // Silence counts as centred; one silent side shares nothing with the other
+  double norm = std::sqrt(leftEnergy * rightEnergy);
+  if (norm > 0.0) {
+    analysisState.stereoCorrelation = std::clamp(crossEnergy / norm, -1.0, 1.0);
+  } else {
+    analysisState.stereoCorrelation =
+        leftEnergy + rightEnergy > 0.0 ? 0.0 : 1.0;
   }
 
-  auto clamp01 = [](double v) { return std::min(1.0, std::max(0.0, v)); };
+  // Mid is (L + R) / 2 and side (L - R) / 2
+  double mid =
+      std::sqrt(std::max(0.0, leftEnergy + 2.0 * crossEnergy + rightEnergy));
+  double side =
+      std::sqrt(std::max(0.0, leftEnergy - 2.0 * crossEnergy + rightEnergy));
+  analysisState.stereoWidth = mid + side > 0.0 ? side / (mid + side) : 0.0;
+}
+
+void AudioSystem::analyzeSpectrum(const FFTResult& fft,
+                                  SpectralFeatures& features) {
+  // Frequency bands, centroid, rolloff and flux in one pass
+  spectralAnalyzer.compute(fft.magnitudes.data(), features);
+
+  analysisState.bassLevel = features.bandLevels[0];
+  analysisState.lowMidLevel = features.bandLevels[1];
+  analysisState.midLevel = features.bandLevels[2];
+  analysisState.highMidLevel = features.bandLevels[3];
+  analysisState.trebleLevel = features.bandLevels[4];
+  analysisState.spectralCentroid = features.centroid;
+  analysisState.spectralRolloff = features.rolloff;
+
+  filterbank.apply(fft.magnitudes.data(),
+                   analysisState.filterbankLevels.data());
+  analysisState.filterbankBandCount = filterbank.getBandCount();
+
+  // Spectral flux is band-limited and log-compressed; EMA smooth it for
+  // stability
+  analysisState.spectralFlux = features.flux;
+  smoothFlux(analysisState);
 
-  // Average within each band and clamp to [0,1]
-  data.bassLevel = clamp01((bassCount > 0) ? (bassSum / bassCount) : 0.0);
-  data.lowMidLevel =
-      clamp01((lowMidCount > 0) ? (lowMidSum / lowMidCount) : 0.0);
-  data.midLevel = clamp01((midCount > 0) ? (midSum / midCount) : 0.0);
-  data.highMidLevel =
-      clamp01((highMidCount > 0) ? (highMidSum / highMidCount) : 0.0);
-  data.trebleLevel =
-      clamp01((trebleCount > 0) ? (trebleSum / trebleCount) : 0.0);
+  // Calculate RMS energy
+  double sum = 0.0;
+  for (const auto& sample : fftBuffer) {
+    sum += sample * sample;
+  }
+  analysisState.rmsEnergy = std::sqrt(sum / fftBuffer.size());
+
+  // Update peak detection
+  if (!fftBuffer.empty()) {
+    analysisState.currentPeak =
+        *std::max_element(fftBuffer.begin(), fftBuffer.end());
+  } else {
+    analysisState.currentPeak = 0.0;
+  }
+  updatePeakHistory(analysisState);
+
+  // Beats are timed in audio, a hop per analysis, so the refractory period
+  // and the tempo hold however promptly the analyses run
+  analyzedFrames += analysisHopSize;
+  detectBeat(analysisState, static_cast<Uint64>(analyzedFrames * 1000 /
+                                                getAnalysisSampleRate()));
+  trackTempo(analysisState, features.flux);
 }
 
-void AudioSystem::detectBeat(VisualizationData& data) {
-  // Spectral-flux-based beat detection with adaptive threshold and refractory
-  // period
-  if (data.spectralFluxHistory.empty()) {
-    data.isBeat = false;
-    data.beatIntensity = 0.0;
-    return;
+void AudioSystem::trackTempo(VisualizationData& data, double onsetStrength) {
+  // Hop size or sample rate changes start the tracker afresh
+  double hopRate = getAnalysisRate();
+  if (tempoTracker.getHopRate() != hopRate) {
+    tempoTracker.configure(hopRate);
   }
 
-  // Compute mean and stddev of recent smoothed spectral flux (excluding latest
-  // sample)
-  const int window =
-      static_cast<int>(std::min<size_t>(data.spectralFluxHistory.size(), 48));
-  if (window < 8) {
+  data.isPredictedBeat = tempoTracker.push(onsetStrength);
+  if (tempoTracker.getTempo() > 0.0) {
+    data.tempoEstimate = tempoTracker.getTempo();
+  }
+  data.tempoConfidence = tempoTracker.getConfidence();
+  data.beatPhase = tempoTracker.getBeatPhase();
+  data.secondsToNextBeat = tempoTracker.getSecondsToNextBeat();
+}
+
+void AudioSystem::smoothFlux(VisualizationData& data) {
+  if (data.spectralFluxEMA == 0.0) {
+    data.spectralFluxEMA = data.spectralFlux;
+  } else {
+    data.spectralFluxEMA = FLUX_EMA_ALPHA * data.spectralFlux +
+                           (1.0 - FLUX_EMA_ALPHA) * data.spectralFluxEMA;
+  }
+}
+
+void AudioSystem::detectBeat(VisualizationData& data, Uint64 nowMs) {
+  // Spectral-flux-based beat detection with adaptive threshold and refractory
+  // period, on the smoothed flux
+  double currentFlux = data.spectralFluxEMA;
+  auto& history = data.spectralFluxHistory;
+
+  // Needs a few hops of history before the threshold means anything
+  if (history.size() < 7) {
     data.isBeat = false;
     data.beatIntensity = 0.0;
+    history.push(currentFlux);
     return;
   }
 
-  double sum = 0.0;
-  for (int i = 0; i < window - 1; ++i) {
-    sum += data.spectralFluxHistory[data.spectralFluxHistory.size() - 2 - i];
-  }
-  double mean = sum / (window - 1);
-  double var = 0.0;
-  for (int i = 0; i < window - 1; ++i) {
-    double v =
-        data.spectralFluxHistory[data.spectralFluxHistory.size() - 2 - i] -
-        mean;
-    var += v * v;
-  }
-  double stddev = std::sqrt(var / std::max(1, window - 2));
+  // Mean and stddev of the recent smoothed flux (excluding this hop), kept
+  // up to date by the ring buffer as hops come and go
+  double mean = history.getMean();
+  double stddev = std::sqrt(history.getVariance());
 
   // Adaptive threshold with sensitivity and floor
   const double sensitivityK = 1.2;  // lower = more sensitive
   const double floorBoost = 0.0;    // constant offset if needed
   double threshold = mean + sensitivityK * stddev + floorBoost;
 
-  double currentFlux = data.spectralFluxHistory.back();
-  Uint64 nowMs = SDL_GetTicks();
   const Uint64 refractoryMs = 200;  // minimum time between beats
   const double hysteresis = 0.05 * (stddev + 1e-6);
 
@@ -643,33 +1436,44 @@ void AudioSystem::detectBeat(VisualizationData& data) {
     // Decay intensity for smoother UI feedback
     data.beatIntensity = std::max(0.0, data.beatIntensity * 0.92);
   }
+
+  history.push(currentFlux);
 }
 
 void AudioSystem::updatePeakHistory(VisualizationData& data) {
-  data.peakHistory.push_back(data.currentPeak);
-  data.energyHistory.push_back(data.rmsEnergy);
+  // The oldest entries drop off once the histories are full
+  data.peakHistory.push(static_cast<float>(data.currentPeak));
+  data.energyHistory.push(static_cast<float>(data.rmsEnergy));
 
-  // Keep only last 30 samples (about 0.7 seconds at 44.1kHz)
-  if (data.peakHistory.size() > 30) {
-    data.peakHistory.pop_front();
-  }
-  if (data.energyHistory.size() > 30) {
-    data.energyHistory.pop_front();
-  }
+  data.averagePeak = data.peakHistory.getMean();
+}
+
+void AudioSystem::setFilterbank(int bandCount, FilterbankScale scale) {
+  std::lock_guard<std::mutex> lock(analysisMutex);
+  filterbankBands =
+      std::clamp(bandCount, Filterbank::MIN_BANDS, Filterbank::MAX_BANDS);
+  filterbankScale = scale;
 
-  // Calculate average peak
-  if (!data.peakHistory.empty()) {
-    data.averagePeak =
-        std::accumulate(data.peakHistory.begin(), data.peakHistory.end(), 0.0) /
-        data.peakHistory.size();
+  // Without a frequency table yet, performFFT configures it on first use
+  if (!fftResult.frequencies.empty()) {
+    configureFilterbank();
   }
 }
 
+void AudioSystem::configureFilterbank() {
+  double highHz = std::min(20000.0, frequencyTableRate / 2.0);
+  filterbank.configure(fftResult.frequencies.data(),
+                       fftResult.frequencies.size(), filterbankBands,
+                       filterbankScale, 20.0, highHz);
+}
+
 void AudioSystem::setFFTSize(int size) {
+  std::lock_guard<std::mutex> lock(analysisMutex);
   if (size != fftSize && (size & (size - 1)) == 0) {  // Check if power of 2
     cleanupFFT();
     fftSize = size;
     initializeFFT();
     fftBuffer.resize(size);
+    stereoBuffer.resize(STEREO_CHANNELS * size);
   }
 }
@@ -3,17 +3,33 @@
 #include <SDL3/SDL.h>
 #include <fftw3.h>
 
+#include <array>
+#include <atomic>
 #include <complex>
-#include <deque>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "systems/analysis_cache.h"
+#include "systems/audio_input.h"
+#include "systems/filterbank.h"
+#include "systems/spectral_analyzer.h"
+#include "systems/tempo_tracker.h"
+#include "systems/wav_file.h"
+#include "utils/ring_buffer.h"
+#include "utils/triple_buffer.h"
+
+class JobSystem;
+
 class AudioSystem {
  public:
   struct AudioData {
-    std::vector<Sint16>
-        samples;  // Store original Sint16 samples to avoid conversion artifacts
     int sampleRate;
     int channels;
     size_t totalSamples;
@@ -24,7 +40,7 @@ class AudioSystem {
     std::vector<std::complex<double>> spectrum;
     std::vector<double> magnitudes;
     std::vector<double> frequencies;
-    int fftSize;
+    int fftSize = 0;
   };
 
   struct VisualizationData {
@@ -43,29 +59,58 @@ class AudioSystem {
     // Beat detection
     double beatIntensity;
     bool isBeat;
-    double tempoEstimate;
+    double tempoEstimate;  // BPM
+
+    // Beat prediction from the tempo tracker: whether a beat is predicted
+    // on this analysis, how far through the beat it is (0 on a beat, rising
+    // to 1), and the seconds to the next one, negative before a tempo has
+    // been found. Confidence is how periodic the onsets are, 0..1.
+    bool isPredictedBeat = false;
+    double beatPhase = 0.0;
+    double secondsToNextBeat = -1.0;
+    double tempoConfidence = 0.0;
 
     // Energy levels
     double rmsEnergy;
     double spectralCentroid;
     double spectralRolloff;
 
-    // History for smoothing
-    std::deque<double> peakHistory;
-    std::deque<double> energyHistory;
+    // Stereo image. Band levels are bass to treble, as above; mono sources
+    // report the mono levels on both sides.
+    std::array<double, SpectralFeatures::BAND_COUNT> leftBandLevels{};
+    std::array<double, SpectralFeatures::BAND_COUNT> rightBandLevels{};
+    double stereoCorrelation = 1.0;  // -1 out of phase, 0 unrelated, 1 mono
+    double stereoWidth = 0.0;        // Side over mid plus side level, 0..1
 
-    // Spectral flux history for beat detection
-    std::vector<double> lastMagnitudes;  // previous frame magnitudes
-    std::deque<double> spectralFluxHistory;
+    // History for smoothing, oldest first, over the last 30 analyses
+    RingBuffer<float, 30> peakHistory;
+    RingBuffer<float, 30> energyHistory;
+
+    // Smoothed flux of the hops before the current one; beat detection
+    // compares each hop with the BEAT_WINDOW - 1 before it
+    static constexpr size_t BEAT_WINDOW = 48;
+    RingBuffer<double, BEAT_WINDOW - 1> spectralFluxHistory;
     double spectralFlux = 0.0;
     double spectralFluxEMA = 0.0;  // smoothed flux for robust detection
-    Uint64 lastBeatMs = 0;         // refractory timer
+    Uint64 lastBeatMs = 0;         // refractory timer, in audio time
+
+    // Log- or mel-spaced filterbank levels in [0, 1], lowest band first.
+    // Stored inline so snapshots copy without allocating; read them through
+    // getFilterbankLevels(). Empty while analysis comes from the cache.
+    std::array<float, Filterbank::MAX_BANDS> filterbankLevels{};
+    int filterbankBandCount = 0;
+
+    std::span<const float> getFilterbankLevels() const {
+      return {filterbankLevels.data(),
+              static_cast<size_t>(filterbankBandCount)};
+    }
   };
 
   AudioSystem();
   ~AudioSystem();
 
-  // Load audio file (WAV format supported by SDL)
+  // Open a WAV file. It is memory mapped and decoded on demand, so this
+  // returns quickly however large the file is.
   bool loadAudioFile(const std::string& filename);
 
   // Start/stop audio playback
@@ -77,55 +122,322 @@ class AudioSystem {
   double getPlaybackPosition() const;
   double getDuration() const;
 
-  // Perform FFT analysis on current audio buffer
-  FFTResult performFFT(const std::vector<float>& audioBuffer);
+  // Jump to a position in seconds. While stopped, sets where the next
+  // playback starts.
+  void seek(double seconds);
+
+  // Looping between the loop points (the whole file unless a region is
+  // set). Without it, playback stops at the end of the file.
+  void setLooping(bool enabled);
+  bool isLooping() const { return loopEnabled; }
+  void setLoopRegion(double startSeconds, double endSeconds);
+  void clearLoopRegion();
+  double getLoopStart() const;
+  double getLoopEnd() const;
+
+  // Perform FFT analysis on current audio buffer. The result lives in a
+  // workspace that is reused (and overwritten) by the next call.
+  const FFTResult& performFFT(const std::vector<float>& audioBuffer);
+
+  // Run the full analysis on a block of normalized samples, zero padded to
+  // the FFT size, outside of playback. Not for use while playing.
+  const VisualizationData& analyzeSamples(const float* samples, size_t count);
+
+  // As analyzeSamples, for a left and right channel
+  const VisualizationData& analyzeStereoSamples(const float* left,
+                                                const float* right,
+                                                size_t count);
+
+  // As the analysis thread does for live input: queue the frames, then
+  // analyze them a hop at a time. Not for use while an input is live.
+  const VisualizationData& analyzeCapturedFrames(const StereoFrame* frames,
+                                                 size_t count);
+
+  // Switch what the analysis listens to. Live inputs stop file playback and
+  // start capturing at once; for a recording device, `deviceName` picks one
+  // by part of its name, or the default if empty. On failure the input
+  // goes back to File and getInputError() says why.
+  bool setInput(AudioInput input, const std::string& deviceName = "");
+  AudioInput getInput() const { return input; }
+  const std::string& getInputError() const { return inputError; }
 
-  // Update visualization data
+  // Rate of the live input, and the frames it has dropped because analysis
+  // fell a whole ring behind
+  int getCaptureSampleRate() const { return captureSampleRate; }
+  uint64_t getDroppedCaptureFrames() const;
+
+  // Pick up the latest snapshot published by the analysis thread. Call once
+  // per frame from the main thread; never blocks.
   void updateVisualizationData();
 
-  // Get current visualization data
-  const VisualizationData& getVisualizationData() const { return vizData; }
+  // Get current visualization data, as of the last updateVisualizationData.
+  // Main thread only.
+  const VisualizationData& getVisualizationData() const {
+    return vizSnapshots.getReadBuffer();
+  }
+
+  // Samples of playback between analyses. The analysis rate is the sample
+  // rate divided by this, e.g. 512 at 44.1 kHz is about 86 Hz.
+  void setAnalysisHopSize(int samples);
+  int getAnalysisHopSize() const { return analysisHopSize; }
+
+  // Analyses per second at the current hop size and sample rate
+  double getAnalysisRate() const;
+
+  // Time the analysis thread spent on its last analysis
+  float getLastAnalysisMs() const { return lastAnalysisMs; }
+
+  // Thread pool for buildAnalysisCache; without one the build runs on its
+  // own thread alone. Stops a build that is using the old pool.
+  void setJobSystem(JobSystem* jobSystem);
+
+  // Start analyzing the whole loaded track in the background, at the
+  // current FFT and hop sizes, saving the result next to the file. The
+  // result is swapped in by updatePlayback() once done. Returns false if
+  // nothing is loaded or a build is already running. Loading a file picks
+  // its saved analysis back up if the file hasn't changed.
+  bool buildAnalysisCache();
+  bool isBuildingAnalysisCache() const { return cacheBuilding; }
+
+  // Fraction of the running build's hops analyzed, in [0, 1]
+  float getAnalysisCacheProgress() const;
+
+  // While a cached analysis is loaded and in use, playback looks analysis
+  // up by position instead of running FFTs
+  bool hasAnalysisCache() const { return analysisCache.isLoaded(); }
+  void setUseAnalysisCache(bool enabled) { useAnalysisCache = enabled; }
+  bool isUsingAnalysisCache() const { return useAnalysisCache; }
+
+  // The cached analysis, for looking ahead; empty without one. Main thread
+  // only.
+  const AnalysisCache& getAnalysisCache() const { return analysisCache; }
+
+  // Time in seconds of the first cached beat after the playback position,
+  // or negative if there is none
+  double getNextBeatTime() const;
+
+  // Filterbank published in VisualizationData: bandCount bands (16 to 256)
+  // spaced on a log or mel scale from 20 Hz to 20 kHz or Nyquist
+  void setFilterbank(int bandCount, FilterbankScale scale);
+  int getFilterbankBandCount() const { return filterbankBands; }
+  FilterbankScale getFilterbankScale() const { return filterbankScale; }
+
+  // Instruction set used for the spectral features
+  SpectralKernel getSpectralKernel() const {
+    return spectralAnalyzer.getKernel();
+  }
 
   // Get raw audio data
   const AudioData& getAudioData() const { return audioData; }
 
-  // Check if audio is playing
+  // Check if audio is playing; a paused stream still counts as playing
   bool isPlaying() const { return playing; }
+  bool isPaused() const { return paused; }
+
+  // Extra output latency, beyond the device buffer, to hold the playback
+  // clock back by. For hardware or OS buffering SDL can't see.
+  void setOutputLatencyMs(double ms) { outputLatencyMs = ms; }
+  double getOutputLatencyMs() const { return outputLatencyMs; }
 
   // Set FFT size (must be power of 2)
   void setFFTSize(int size);
 
-  // Update playback (call this in your main loop)
+  // Update playback and take in a finished analysis build (call this in
+  // your main loop)
   void updatePlayback();
 
  private:
   AudioData audioData;
-  VisualizationData vizData;
 
-  // FFTW3 plans and buffers
-  fftw_plan fftPlan;
-  fftw_complex* fftIn;
-  fftw_complex* fftOut;
+  // Analysis state, owned by the analysis thread. Each analysis is copied
+  // into the triple buffer for the main thread to read.
+  VisualizationData analysisState;
+  TripleBuffer<VisualizationData> vizSnapshots;
+
+  // Analysis runs on its own thread at a hop-driven rate. analysisMutex
+  // guards the audio data and FFT state it reads; the main thread only
+  // takes it when loading a file or changing the FFT size.
+  std::thread analysisThread;
+  std::mutex analysisMutex;
+  std::condition_variable analysisWake;
+  bool analysisStopping = false;
+  std::atomic<int> analysisHopSize{512};
+  std::atomic<float> lastAnalysisMs{0.0f};
+
+  // FFTW3 plans and buffers (single precision, real-to-complex)
+  fftwf_plan fftPlan;
+  float* fftIn;
+  fftwf_complex* fftOut;
   int fftSize;
 
-  // Audio playback
+  // Left and right go through one batched plan. The transform is linear,
+  // so the mono spectrum is the mean of the two and needs no FFT of its
+  // own. Input is planar, fftSize samples per channel; output has
+  // fftSize / 2 + 1 bins per channel.
+  static constexpr int STEREO_CHANNELS = 2;
+  fftwf_plan stereoPlan = nullptr;
+  float* stereoIn = nullptr;
+  fftwf_complex* stereoOut = nullptr;
+
+  // Hann windows, built once per FFT size and kept across size changes
+  std::unordered_map<int, std::vector<float>> windowTables;
+  const std::vector<float>* window = nullptr;
+
+  // FFTW_MEASURE plans are saved here so later runs skip the measuring
+  static constexpr const char* FFTW_WISDOM_FILE = "fftw_wisdom.dat";
+  bool wisdomImported = false;
+
+  // Audio playback. Samples are read from the mapped file as the feed and
+  // the analysis need them; nothing is decoded up front.
   SDL_AudioStream* audioStream;
-  Uint8* wavData;
-  Uint32 wavDataLen;
+  WavFile wavFile;
   SDL_AudioSpec originalSpec;
-  bool playing;
-  bool paused;
-  size_t currentSample;
-  Uint64 playbackStartTime;
+  std::atomic<bool> playing;
+  std::atomic<bool> paused;
+
+  // Streaming feed. SDL's get-callback tops the stream up to
+  // FEED_AHEAD_MS of audio from wavFile, so the queue stays the same size
+  // however long the file is. The feed fields are shared with the audio
+  // thread and guarded by the stream's own lock (SDL_LockAudioStream).
+  static constexpr int FEED_AHEAD_MS = 100;
+  int64_t feedFrame = 0;  // Next file frame to push
+  bool feedFinished = false;
+  int64_t feedEndStreamFrame = 0;  // Stream frame after the last one pushed
+  int64_t startFrame = 0;          // Where the next playback starts
+  bool loopEnabled = true;
+  int64_t loopStartFrame = 0;
+  int64_t loopEndFrame = 0;
+
+  // Where each contiguous run of file frames starts in the stream. A new
+  // run begins at every seek and loop; the newest FEED_SEGMENT_COUNT are
+  // kept, far more than can be queued at once.
+  struct FeedSegment {
+    int64_t streamFrame;
+    int64_t fileFrame;
+  };
+  static constexpr int FEED_SEGMENT_COUNT = 16;
+  std::array<FeedSegment, FEED_SEGMENT_COUNT> feedSegments{};
+  int feedSegmentCount = 0;
+  int feedSegmentNewest = 0;
+
+  // Frames are converted to the playback format here on their way into the
+  // stream; sized when playback starts
+  static constexpr int64_t FEED_CHUNK_FRAMES = 4096;
+  std::vector<Uint8> feedScratch;
+
+  // Playback clock: the audible frame is what has left the stream, minus
+  // the device buffer it went into, plus how far into that buffer playback
+  // has got. clockMutex guards audioStream's lifetime and the clock
+  // fields, so the analysis thread can read the clock while the main thread
+  // controls playback. Lock order is clockMutex, then the stream lock; the
+  // audio thread only ever takes the stream lock.
+  mutable std::mutex clockMutex;
+  int64_t framesPushed = 0;  // Source frames put into the stream
+  int frameBytes = 0;        // Bytes per source frame
+  int64_t deviceBufferFrames = 0;
+  mutable int64_t lastConsumedFrames = 0;
+  mutable Uint64 lastConsumedTicks = 0;  // Performance counter at last step
+  int64_t pausedFrame = 0;
+  std::atomic<double> outputLatencyMs{0.0};
 
   // FFT buffer for visualization
   std::vector<float> fftBuffer;
 
+  // Planar left and right window for stereo sources, and their spectra
+  std::vector<float> stereoBuffer;
+  std::vector<double> leftMagnitudes;
+  std::vector<double> rightMagnitudes;
+
+  // Reused FFT output; frequencies are rebuilt only when the FFT size or
+  // sample rate changes
+  FFTResult fftResult;
+  int frequencyTableRate = 0;
+
+  // Bands, centroid, rolloff and flux, configured with the frequency table.
+  // The left and right ones only feed the per-side band levels.
+  SpectralAnalyzer spectralAnalyzer;
+  SpectralAnalyzer leftAnalyzer;
+  SpectralAnalyzer rightAnalyzer;
+
+  // Filterbank, also configured with the frequency table. Its settings are
+  // written by the main thread under analysisMutex.
+  Filterbank filterbank;
+  int filterbankBands = 64;
+  FilterbankScale filterbankScale = FilterbankScale::Log;
+
+  // Whole-track analysis for the loaded file, if built or found on disk.
+  // Replaced only under analysisMutex.
+  std::string loadedPath;
+  AnalysisCache analysisCache;
+  std::atomic<bool> useAnalysisCache{true};
+  int64_t lastServedHop = -1;  // -1 forgets beats already reported
+  JobSystem* jobSystem = nullptr;
+
+  // Background whole-track analysis. The build works from a snapshot of
+  // the settings and its own FFT plan, and leaves its result in builtCache
+  // for the main thread to swap in, since the UI reads analysisCache
+  // unlocked. Loading a file or changing the job system cancels it first.
+  struct CacheBuild;
+  std::thread cacheBuildThread;
+  std::atomic<bool> cacheBuilding{false};
+  std::atomic<bool> cacheBuildDone{false};
+  std::atomic<bool> cacheBuildCancelled{false};
+  std::atomic<size_t> cacheHopsDone{0};
+  size_t cacheHopCount = 0;
+  AnalysisCache builtCache;
+
+  // Audio analyzed so far, a hop per analysis; the clock beat detection
+  // runs on. The tempo tracker is fed the flux of every analysis.
+  int64_t analyzedFrames = 0;
+  TempoTracker tempoTracker;
+
+  // Live input. The capture source pushes frames into captureRing from its
+  // own thread, lock-free; the analysis thread drains it a hop at a time,
+  // sliding the stereo window along. The ring holds CAPTURE_RING_FRAMES,
+  // about a third of a second, and analysis skips ahead rather than fall
+  // more than a window behind. Switched only under analysisMutex.
+  static constexpr size_t CAPTURE_RING_FRAMES = 16384;
+  AudioInput input = AudioInput::File;
+  std::unique_ptr<CaptureSource> captureSource;
+  CaptureRing captureRing;
+  std::vector<StereoFrame> captureScratch;
+  int captureSampleRate = 0;
+  std::string inputError;
+
   // Helper functions
+  static void feedCallback(void* userdata, SDL_AudioStream* stream,
+                           int additionalAmount, int totalAmount);
+  void feedStream(SDL_AudioStream* stream, int additionalBytes);
+  void addFeedSegment(int64_t streamFrame, int64_t fileFrame);
+  int64_t toFileFrame(int64_t streamFrame) const;
+  int64_t getTotalFrames() const;
+
+  // File frame being heard right now; negative before the first buffer
+  // reaches the device. The Locked variant expects clockMutex held; the
+  // stream-frame one expects the stream lock held too.
+  int64_t getAudibleFrame() const;
+  int64_t getAudibleFrameLocked() const;
+  int64_t getAudibleStreamFrame() const;
+  void configureFilterbank();
+  void analysisLoop();
+  void analyzeCurrentPosition();
+  bool analyzeCapture();
+  int getAnalysisSampleRate() const;
+  void analyzeBuffer();
+  void analyzeStereoBuffer();
+  void analyzeSpectrum(const FFTResult& fft, SpectralFeatures& features);
+  const FFTResult& performStereoFFT();
+  void updateFrequencyTable();
+  void serveCachedAnalysis();
   void initializeFFT();
+  fftwf_plan createPlan(int channels, float* in, fftwf_complex* out);
+
+  void runAnalysisCacheBuild(CacheBuild& build);
+  void stopAnalysisCacheBuild();
   void cleanupFFT();
-  void calculateFrequencyBands(const FFTResult& fft, VisualizationData& data);
-  void detectBeat(VisualizationData& data);
+  void smoothFlux(VisualizationData& data);
+  void detectBeat(VisualizationData& data, Uint64 nowMs);
+  void trackTempo(VisualizationData& data, double onsetStrength);
   void updatePeakHistory(VisualizationData& data);
 
   // Static audio callback for SDL3
@@ -0,0 +1,119 @@
+#include "filterbank.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double toMel(double hz) { return 2595.0 * std::log10(1.0 + hz / 700.0); }
+
+double fromMel(double mel) {
+  return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+double warp(FilterbankScale scale, double hz) {
+  return scale == FilterbankScale::Mel ? toMel(hz) : std::log(hz);
+}
+
+double unwarp(FilterbankScale scale, double value) {
+  return scale == FilterbankScale::Mel ? fromMel(value) : std::exp(value);
+}
+
+}  // namespace
+
+void Filterbank::configure(const double* frequencies, size_t binCount,
+                           int bandCount, FilterbankScale scale, double lowHz,
+                           double highHz) {
+  this->scale = scale;
+  bandCount = std::clamp(bandCount, MIN_BANDS, MAX_BANDS);
+  bands.clear();
+  weights.clear();
+  centers.clear();
+  if (binCount < 2) return;
+
+  // The Hann window sums to half the FFT size, so a full-scale sine on a
+  // bin's centre reaches half that, and there are half as many bins
+  fullScale = static_cast<float>(binCount) / 2.0f;
+
+  // A log scale can't start at 0 Hz
+  lowHz = std::max(lowHz, 1.0);
+  highHz = std::max(highHz, lowHz * 2.0);
+
+  // bandCount + 2 evenly warped edges; band b rises from edge b to its
+  // centre at b + 1 and falls to b + 2
+  std::vector<double> edges(bandCount + 2);
+  double warpedLow = warp(scale, lowHz);
+  double warpedStep = (warp(scale, highHz) - warpedLow) / (bandCount + 1);
+  for (int i = 0; i < bandCount + 2; ++i) {
+    edges[i] = unwarp(scale, warpedLow + warpedStep * i);
+  }
+
+  bands.reserve(bandCount);
+  centers.reserve(bandCount);
+  for (int b = 0; b < bandCount; ++b) {
+    double lower = edges[b];
+    double center = edges[b + 1];
+    double upper = edges[b + 2];
+
+    Band band{0, static_cast<uint32_t>(weights.size()), 0};
+    double weightSum = 0.0;
+    for (size_t bin = 1; bin < binCount; ++bin) {
+      double hz = frequencies[bin];
+      if (hz <= lower) continue;
+      if (hz >= upper) break;
+
+      double weight = hz <= center ? (hz - lower) / (center - lower)
+                                   : (upper - hz) / (upper - center);
+      if (band.weightCount == 0) band.firstBin = static_cast<uint32_t>(bin);
+      weights.push_back(static_cast<float>(weight));
+      weightSum += weight;
+      ++band.weightCount;
+    }
+
+    // Low bands can be narrower than a bin; take the nearest one whole
+    if (band.weightCount == 0) {
+      size_t nearest = 1;
+      for (size_t bin = 2; bin < binCount; ++bin) {
+        if (std::abs(frequencies[bin] - center) <
+            std::abs(frequencies[nearest] - center)) {
+          nearest = bin;
+        }
+      }
+      band.firstBin = static_cast<uint32_t>(nearest);
+      band.weightCount = 1;
+      weights.push_back(1.0f);
+      weightSum = 1.0;
+    }
+
+    // Each band is a weighted mean, so wide bands don't read louder
+    for (uint32_t i = 0; i < band.weightCount; ++i) {
+      weights[band.weightBegin + i] /= static_cast<float>(weightSum);
+    }
+
+    bands.push_back(band);
+    centers.push_back(static_cast<float>(center));
+  }
+}
+
+void Filterbank::apply(const double* magnitudes, float* levels) const {
+  const float dbScale = 20.0f / DYNAMIC_RANGE_DB;
+  for (size_t b = 0; b < bands.size(); ++b) {
+    const Band& band = bands[b];
+    const double* bins = magnitudes + band.firstBin;
+    const float* bandWeights = weights.data() + band.weightBegin;
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < band.weightCount; ++i) {
+      sum += bandWeights[i] * bins[i];
+    }
+
+    float relative = std::min(static_cast<float>(sum) / fullScale, 1.0f);
+    levels[b] = relative > 0.0f
+                    ? std::max(0.0f, 1.0f + dbScale * std::log10(relative))
+                    : 0.0f;
+  }
+}
+
+const char* Filterbank::getScaleName(FilterbankScale scale) {
+  return scale == FilterbankScale::Mel ? "Mel" : "Log";
+}
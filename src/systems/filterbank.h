@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/** @brief Frequency warping that filterbank bands are evenly spaced on */
+enum class FilterbankScale { Log, Mel };
+
+/**
+ * @brief Sparse triangular filterbank over FFT magnitude bins
+ *
+ * Each band is a triangle spanning its neighbours' centres, spaced evenly
+ * on a log or mel scale. Only the non-zero weights are stored, one run of
+ * consecutive bins per band, so applying it is a sparse mat-vec of roughly
+ * two weights per bin however many bands there are.
+ */
+class Filterbank {
+ public:
+  static constexpr int MIN_BANDS = 16;
+  static constexpr int MAX_BANDS = 256;
+
+  // Levels are in decibels below full scale, mapped from
+  // [-DYNAMIC_RANGE_DB, 0] to [0, 1]. Full scale is the magnitude a
+  // full-scale sine reaches through the Hann window, a quarter of the FFT
+  // size, so quiet passages read quiet
+  static constexpr float DYNAMIC_RANGE_DB = 60.0f;
+
+  /**
+   * @brief Rebuild the filters for `bandCount` bands (clamped to
+   * MIN_BANDS..MAX_BANDS) between `lowHz` and `highHz`; `frequencies` gives
+   * each bin's centre in Hz
+   */
+  void configure(const double* frequencies, size_t binCount, int bandCount,
+                 FilterbankScale scale, double lowHz, double highHz);
+
+  /**
+   * @brief Filter one Hann-windowed spectrum into getBandCount() levels in
+   * [0, 1]
+   */
+  void apply(const double* magnitudes, float* levels) const;
+
+  int getBandCount() const { return static_cast<int>(bands.size()); }
+  FilterbankScale getScale() const { return scale; }
+
+  /** @brief Centre frequency of each band in Hz, lowest first */
+  std::span<const float> getCenterFrequencies() const { return centers; }
+
+  /** @brief Non-zero weights across all bands */
+  size_t getWeightCount() const { return weights.size(); }
+
+  static const char* getScaleName(FilterbankScale scale);
+
+ private:
+  struct Band {
+    uint32_t firstBin;
+    uint32_t weightBegin;  // Index of the band's first weight
+    uint32_t weightCount;
+  };
+
+  FilterbankScale scale = FilterbankScale::Log;
+  std::vector<Band> bands;
+  std::vector<float> weights;
+  std::vector<float> centers;
+  float fullScale = 1.0f;  // Band magnitude that reads 0 dB
+};
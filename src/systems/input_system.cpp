@@ -94,24 +94,33 @@ void InputSystem::handleMouseButton(int button, bool pressed) {
 }
 
 Entity* InputSystem::findEntityUnderMouse() {
-  // Get all entities and check if mouse is over any of them
-  auto entities = appState->entityManager.getAllEntities();
-
-  // Check entities in reverse order (top to bottom) to get the topmost entity
-  for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
-    Entity* entity = *it;
-    if (entity && entity->isActive() && entity->isVisible()) {
-      BoundingBox bbox = entity->getBoundingBox();
-      if (mousePosition.x >= bbox.minX && mousePosition.x <= bbox.maxX &&
-          mousePosition.y >= bbox.minY && mousePosition.y <= bbox.maxY) {
-        // Only return entities that can be dragged
-        if (canEntityBeDragged(entity)) {
-          return entity;
-        }
-      }
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // Only entities whose bounding box contains the mouse are returned
+  pickCandidates.clear();
+  appState->entityManager.queryPoint(mousePosition, pickCandidates);
+
+  // Pick the topmost candidate, i.e. the one rendered last: highest
+  // z-order, and the most recently spawned among equals
+  Entity* topmost = nullptr;
+  for (Entity* entity : pickCandidates) {
+    if (!entity->isActive() || !entity->isVisible() ||
+        !canEntityBeDragged(entity)) {
+      continue;
+    }
+
+    if (!topmost || entity->getZOrder() > topmost->getZOrder() ||
+        (entity->getZOrder() == topmost->getZOrder() &&
+         appState->entityManager.isSpawnedAfter(entity, topmost))) {
+      topmost = entity;
     }
   }
-  return nullptr;
+
+  lastPickMicros = static_cast<float>(
+      (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 /
+      SDL_GetPerformanceFrequency());
+
+  return topmost;
 }
 
 bool InputSystem::canEntityBeDragged(Entity* entity) const {
@@ -130,7 +139,7 @@ void InputSystem::startDrag(Entity* entity) {
   if (!entity || !canEntityBeDragged(entity)) return;
 
   isDragging = true;
-  draggedEntity = entity;
+  draggedEntity = entity->getHandle();
   dragStartPosition = mousePosition;
 
   // Notify the entity that dragging has started
@@ -139,7 +148,7 @@ void InputSystem::startDrag(Entity* entity) {
   }
 
   // Calculate offset from entity center to mouse position
-  BoundingBox bbox = entity->getBoundingBox();
+  BoundingBox bbox = appState->entityManager.getIndexedBounds(entity);
   SDL_FPoint entityCenter = {(bbox.minX + bbox.maxX) / 2.0f,
                              (bbox.minY + bbox.maxY) / 2.0f};
 
@@ -148,10 +157,17 @@ void InputSystem::startDrag(Entity* entity) {
 }
 
 void InputSystem::updateDrag() {
-  if (!isDragging || !draggedEntity) return;
+  if (!isDragging) return;
+
+  // The entity may have been removed since the drag started
+  Entity* entity = getDraggedEntity();
+  if (!entity) {
+    endDrag();
+    return;
+  }
 
   // Only update position if entity is positionable
-  if (auto* positionable = draggedEntity->asPositionable()) {
+  if (auto* positionable = entity->asPositionable()) {
     // Calculate new position for the entity
     SDL_FPoint newPosition = {mousePosition.x - dragOffset.x,
                               mousePosition.y - dragOffset.y};
@@ -162,15 +178,16 @@ void InputSystem::updateDrag() {
 }
 
 void InputSystem::endDrag() {
-  if (isDragging && draggedEntity) {
+  Entity* entity = getDraggedEntity();
+  if (isDragging && entity) {
     // Notify the entity that dragging has ended
-    if (auto* interactive = draggedEntity->asInteractive()) {
+    if (auto* interactive = entity->asInteractive()) {
       interactive->onDragEnd();
     }
   }
 
   isDragging = false;
-  draggedEntity = nullptr;
+  draggedEntity = EntityHandle{};
 }
 
 bool InputSystem::isKeyPressed(SDL_Keycode key) const {
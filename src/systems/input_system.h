@@ -3,6 +3,7 @@
 #include <SDL3/SDL.h>
 
 #include <unordered_map>
+#include <vector>
 
 #include "core/app_state.h"
 
@@ -31,11 +32,15 @@ class InputSystem {
 
   // Drag state tracking
   bool isDragging = false;
-  Entity* draggedEntity = nullptr;
+  EntityHandle draggedEntity;
   SDL_FPoint dragOffset;  // Offset from entity center to mouse position
   SDL_FPoint dragStartPosition;
   bool quitRequested = false;
 
+  // Picking scratch space and timing
+  std::vector<Entity*> pickCandidates;
+  float lastPickMicros = 0.0f;
+
   // Key bindings
   void handleKeyDown(SDL_Keycode key);
   void handleKeyUp(SDL_Keycode key);
@@ -91,8 +96,17 @@ class InputSystem {
 
   /**
    * @brief Get the currently dragged entity (if any)
+   *
+   * Returns nullptr if the entity was removed mid-drag.
+   */
+  Entity* getDraggedEntity() const {
+    return appState->entityManager.get(draggedEntity);
+  }
+
+  /**
+   * @brief Time taken by the last entity pick, in microseconds
    */
-  Entity* getDraggedEntity() const { return draggedEntity; }
+  float getLastPickMicros() const { return lastPickMicros; }
 
   /**
    * @brief Check if the application should quit
@@ -0,0 +1,152 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+namespace {
+// Which pool the current thread works for, and its queue in that pool
+thread_local const JobSystem* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+
+// Chunks per thread; more than one so stealing has something to balance
+const size_t CHUNKS_PER_THREAD = 4;
+}  // namespace
+
+JobSystem::JobSystem(size_t workerCount) {
+  queues.reserve(workerCount + 1);
+  for (size_t i = 0; i < workerCount + 1; i++) {
+    queues.push_back(std::make_unique<WorkQueue>());
+  }
+
+  workers.reserve(workerCount);
+  for (size_t i = 0; i < workerCount; i++) {
+    workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = true;
+  }
+  wakeCondition.notify_all();
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+size_t JobSystem::defaultWorkerCount() {
+  unsigned int hardwareThreads = std::thread::hardware_concurrency();
+  return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+size_t JobSystem::currentQueueIndex() const {
+  return currentPool == this ? currentQueue : 0;
+}
+
+JobSystem::Stats JobSystem::getStats() const {
+  Stats stats;
+  stats.parallelFors = parallelFors.load(std::memory_order_relaxed);
+  stats.chunks = chunks.load(std::memory_order_relaxed);
+  stats.steals = steals.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void JobSystem::parallelFor(size_t count, size_t minChunkSize,
+                            const RangeFunction& fn) {
+  if (count == 0) return;
+
+  const size_t threadCount = getThreadCount();
+  size_t chunkSize = std::max<size_t>(
+      std::max<size_t>(minChunkSize, 1),
+      (count + threadCount * CHUNKS_PER_THREAD - 1) /
+          (threadCount * CHUNKS_PER_THREAD));
+
+  // Not worth waking anyone for a single chunk
+  if (workers.empty() || count <= chunkSize) {
+    fn(0, count);
+    return;
+  }
+
+  parallelFors.fetch_add(1, std::memory_order_relaxed);
+
+  const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+  std::atomic<size_t> remaining{chunkCount};
+
+  // Deal chunks out round-robin so every thread starts with local work
+  for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+    size_t begin = chunk * chunkSize;
+    size_t end = std::min(begin + chunkSize, count);
+
+    WorkQueue& queue = *queues[chunk % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(Job{&fn, begin, end, &remaining});
+  }
+  queuedJobs.fetch_add(chunkCount);
+
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+  }
+  wakeCondition.notify_all();
+
+  // Help out until every chunk of this loop is done. Chunks from other
+  // loops may run here too, which is harmless.
+  const size_t self = currentQueueIndex();
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    if (!runOneJob(self)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool JobSystem::runOneJob(size_t queueIndex) {
+  Job job;
+  bool found = false;
+
+  // Newest local work first, it is most likely still in cache
+  {
+    WorkQueue& own = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = own.jobs.back();
+      own.jobs.pop_back();
+      queuedJobs.fetch_sub(1);
+      found = true;
+    }
+  }
+
+  // Otherwise steal the oldest chunk from someone else
+  for (size_t i = 1; !found && i < queues.size(); i++) {
+    WorkQueue& victim = *queues[(queueIndex + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      job = victim.jobs.front();
+      victim.jobs.pop_front();
+      queuedJobs.fetch_sub(1);
+      found = true;
+      steals.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  if (!found) return false;
+
+  (*job.fn)(job.begin, job.end);
+  chunks.fetch_add(1, std::memory_order_relaxed);
+  job.remaining->fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+void JobSystem::workerLoop(size_t queueIndex) {
+  currentPool = this;
+  currentQueue = queueIndex;
+
+  while (true) {
+    if (runOneJob(queueIndex)) continue;
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wakeCondition.wait(lock, [this] {
+      return stopping || queuedJobs.load() > 0;
+    });
+    if (stopping) return;
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing thread pool for data-parallel loops
+ *
+ * Every thread, including the one calling parallelFor, owns a queue of
+ * chunks. A thread pops work from the back of its own queue and, once that
+ * runs dry, steals from the front of the others, so uneven chunks even out
+ * without a central queue becoming a bottleneck.
+ *
+ * Jobs must not throw.
+ */
+class JobSystem {
+ public:
+  using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+  struct Stats {
+    size_t parallelFors = 0;  // parallelFor calls that were split up
+    size_t chunks = 0;        // Chunks executed
+    size_t steals = 0;        // Chunks taken from another thread's queue
+  };
+
+  /**
+   * @brief Start `workerCount` background threads
+   *
+   * The calling thread also runs chunks, so the pool uses workerCount + 1
+   * threads in total. Zero workers makes every parallelFor run inline.
+   */
+  explicit JobSystem(size_t workerCount = defaultWorkerCount());
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  /**
+   * @brief One fewer than the number of hardware threads
+   */
+  static size_t defaultWorkerCount();
+
+  /**
+   * @brief Run fn over [0, count) in chunks of at least minChunkSize and
+   * block until every chunk has finished
+   */
+  void parallelFor(size_t count, size_t minChunkSize, const RangeFunction& fn);
+
+  size_t getWorkerCount() const { return workers.size(); }
+
+  size_t getThreadCount() const { return workers.size() + 1; }
+
+  /**
+   * @brief Totals since construction
+   */
+  Stats getStats() const;
+
+ private:
+  struct Job {
+    const RangeFunction* fn;
+    size_t begin;
+    size_t end;
+    std::atomic<size_t>* remaining;
+  };
+
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  // Queue 0 belongs to whichever outside thread calls parallelFor; queue
+  // i + 1 belongs to workers[i]
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex wakeMutex;
+  std::condition_variable wakeCondition;
+  std::atomic<size_t> queuedJobs{0};
+  bool stopping = false;
+
+  std::atomic<size_t> parallelFors{0};
+  std::atomic<size_t> chunks{0};
+  std::atomic<size_t> steals{0};
+
+  size_t currentQueueIndex() const;
+  bool runOneJob(size_t queueIndex);
+  void workerLoop(size_t queueIndex);
+};
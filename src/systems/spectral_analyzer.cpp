@@ -0,0 +1,374 @@
+#include "spectral_analyzer.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define SPECTRAL_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SPECTRAL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit AVX2 code in functions that ask for it; MSVC
+// accepts the intrinsics anywhere
+#if defined(SPECTRAL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SPECTRAL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPECTRAL_TARGET_AVX2
+#endif
+
+namespace {
+
+// Upper edges of the bass, low mid, mid and high mid bands; treble is the
+// rest
+const double BAND_UPPER_HZ[SpectralFeatures::BAND_COUNT - 1] = {
+    250.0, 500.0, 2000.0, 4000.0};
+
+const double FLUX_LOW_HZ = 30.0;
+const double FLUX_HIGH_HZ = 4000.0;
+
+const double ROLLOFF_FRACTION = 0.85;
+
+// Bins per chunk: short enough that finding the rolloff inside one is
+// cheap, long enough to amortize the horizontal reductions
+const size_t CHUNK_BINS = 64;
+
+using ChunkStats = SpectralAnalyzer::ChunkStats;
+
+ChunkStats accumulateScalar(const double* magnitudes,
+                            const double* frequencies, size_t count) {
+  ChunkStats stats = {0.0, 0.0, 0.0, 0.0};
+  for (size_t i = 0; i < count; ++i) {
+    double magnitude = magnitudes[i];
+    stats.sum += magnitude;
+    stats.weightedSum += frequencies[i] * magnitude;
+    stats.energy += magnitude * magnitude;
+    stats.peak = std::max(stats.peak, magnitude);
+  }
+  return stats;
+}
+
+#ifdef SPECTRAL_X86
+
+double horizontalSum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double horizontalMax(__m128d v) {
+  return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+ChunkStats accumulateSSE2(const double* magnitudes, const double* frequencies,
+                          size_t count) {
+  __m128d sum = _mm_setzero_pd();
+  __m128d weighted = _mm_setzero_pd();
+  __m128d energy = _mm_setzero_pd();
+  __m128d peak = _mm_setzero_pd();
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d magnitude = _mm_loadu_pd(magnitudes + i);
+    __m128d frequency = _mm_loadu_pd(frequencies + i);
+    sum = _mm_add_pd(sum, magnitude);
+    weighted = _mm_add_pd(weighted, _mm_mul_pd(frequency, magnitude));
+    energy = _mm_add_pd(energy, _mm_mul_pd(magnitude, magnitude));
+    peak = _mm_max_pd(peak, magnitude);
+  }
+
+  ChunkStats tail = accumulateScalar(magnitudes + i, frequencies + i,
+                                     count - i);
+  return {horizontalSum(sum) + tail.sum,
+          horizontalSum(weighted) + tail.weightedSum,
+          horizontalSum(energy) + tail.energy,
+          std::max(horizontalMax(peak), tail.peak)};
+}
+
+SPECTRAL_TARGET_AVX2 double horizontalSum256(__m256d v) {
+  __m128d sum =
+      _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+SPECTRAL_TARGET_AVX2 double horizontalMax256(__m256d v) {
+  __m128d peak =
+      _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_max_sd(peak, _mm_unpackhi_pd(peak, peak)));
+}
+
+SPECTRAL_TARGET_AVX2 ChunkStats accumulateAVX2(const double* magnitudes,
+                                               const double* frequencies,
+                                               size_t count) {
+  __m256d sum = _mm256_setzero_pd();
+  __m256d weighted = _mm256_setzero_pd();
+  __m256d energy = _mm256_setzero_pd();
+  __m256d peak = _mm256_setzero_pd();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d magnitude = _mm256_loadu_pd(magnitudes + i);
+    __m256d frequency = _mm256_loadu_pd(frequencies + i);
+    sum = _mm256_add_pd(sum, magnitude);
+    weighted = _mm256_add_pd(weighted, _mm256_mul_pd(frequency, magnitude));
+    energy = _mm256_add_pd(energy, _mm256_mul_pd(magnitude, magnitude));
+    peak = _mm256_max_pd(peak, magnitude);
+  }
+
+  ChunkStats stats = {horizontalSum256(sum), horizontalSum256(weighted),
+                      horizontalSum256(energy), horizontalMax256(peak)};
+
+  // The tail is written out here rather than calling accumulateScalar:
+  // running non-VEX SSE code with the upper halves of the ymm registers
+  // live costs a state transition on many CPUs
+  for (; i < count; ++i) {
+    double value = magnitudes[i];
+    stats.sum += value;
+    stats.weightedSum += frequencies[i] * value;
+    stats.energy += value * value;
+    stats.peak = std::max(stats.peak, value);
+  }
+  return stats;
+}
+
+#endif  // SPECTRAL_X86
+
+#ifdef SPECTRAL_NEON
+
+ChunkStats accumulateNEON(const double* magnitudes, const double* frequencies,
+                          size_t count) {
+  float64x2_t sum = vdupq_n_f64(0.0);
+  float64x2_t weighted = vdupq_n_f64(0.0);
+  float64x2_t energy = vdupq_n_f64(0.0);
+  float64x2_t peak = vdupq_n_f64(0.0);
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    float64x2_t magnitude = vld1q_f64(magnitudes + i);
+    float64x2_t frequency = vld1q_f64(frequencies + i);
+    sum = vaddq_f64(sum, magnitude);
+    weighted = vaddq_f64(weighted, vmulq_f64(frequency, magnitude));
+    energy = vaddq_f64(energy, vmulq_f64(magnitude, magnitude));
+    peak = vmaxq_f64(peak, magnitude);
+  }
+
+  ChunkStats tail = accumulateScalar(magnitudes + i, frequencies + i,
+                                     count - i);
+  return {vaddvq_f64(sum) + tail.sum, vaddvq_f64(weighted) + tail.weightedSum,
+          vaddvq_f64(energy) + tail.energy,
+          std::max(vmaxvq_f64(peak), tail.peak)};
+}
+
+#endif  // SPECTRAL_NEON
+
+SpectralAnalyzer::ChunkFunction getChunkFunction(SpectralKernel kernel) {
+  switch (kernel) {
+#ifdef SPECTRAL_X86
+    case SpectralKernel::SSE2:
+      return accumulateSSE2;
+    case SpectralKernel::AVX2:
+      return accumulateAVX2;
+#endif
+#ifdef SPECTRAL_NEON
+    case SpectralKernel::NEON:
+      return accumulateNEON;
+#endif
+    default:
+      return accumulateScalar;
+  }
+}
+
+}  // namespace
+
+SpectralAnalyzer::SpectralAnalyzer()
+    : kernel(getBestKernel()), chunkFunction(getChunkFunction(kernel)) {}
+
+bool SpectralAnalyzer::isKernelSupported(SpectralKernel kernel) {
+  switch (kernel) {
+    case SpectralKernel::Scalar:
+      return true;
+#ifdef SPECTRAL_X86
+    case SpectralKernel::SSE2:
+      return SDL_HasSSE2();
+    case SpectralKernel::AVX2:
+      return SDL_HasAVX2();
+#endif
+#ifdef SPECTRAL_NEON
+    case SpectralKernel::NEON:
+      return SDL_HasNEON();
+#endif
+    default:
+      return false;
+  }
+}
+
+SpectralKernel SpectralAnalyzer::getBestKernel() {
+  for (SpectralKernel kernel : {SpectralKernel::AVX2, SpectralKernel::NEON,
+                                SpectralKernel::SSE2}) {
+    if (isKernelSupported(kernel)) return kernel;
+  }
+  return SpectralKernel::Scalar;
+}
+
+const char* SpectralAnalyzer::getKernelName(SpectralKernel kernel) {
+  switch (kernel) {
+    case SpectralKernel::SSE2:
+      return "SSE2";
+    case SpectralKernel::AVX2:
+      return "AVX2";
+    case SpectralKernel::NEON:
+      return "NEON";
+    default:
+      return "Scalar";
+  }
+}
+
+bool SpectralAnalyzer::setKernel(SpectralKernel kernel) {
+  if (!isKernelSupported(kernel)) return false;
+  this->kernel = kernel;
+  chunkFunction = getChunkFunction(kernel);
+  return true;
+}
+
+void SpectralAnalyzer::configure(const double* frequencies, size_t binCount) {
+  this->frequencies.assign(frequencies, frequencies + binCount);
+
+  // Band b covers bins up to and including BAND_UPPER_HZ[b]; the DC bin is
+  // left out so it can't bias the bass
+  size_t bandEnds[SpectralFeatures::BAND_COUNT];
+  size_t bin = std::min<size_t>(1, binCount);
+  for (int band = 0; band < SpectralFeatures::BAND_COUNT - 1; ++band) {
+    while (bin < binCount && frequencies[bin] <= BAND_UPPER_HZ[band]) ++bin;
+    bandEnds[band] = bin;
+  }
+  bandEnds[SpectralFeatures::BAND_COUNT - 1] = binCount;
+
+  chunks.clear();
+  if (binCount > 0) {
+    chunks.push_back({0, 1, -1});
+  }
+  size_t begin = std::min<size_t>(1, binCount);
+  for (int band = 0; band < SpectralFeatures::BAND_COUNT; ++band) {
+    bandBinCounts[band] = bandEnds[band] - begin;
+    for (; begin < bandEnds[band]; begin += CHUNK_BINS) {
+      chunks.push_back(
+          {begin, std::min(begin + CHUNK_BINS, bandEnds[band]), band});
+    }
+    begin = bandEnds[band];
+  }
+  chunkEnergies.assign(chunks.size(), 0.0);
+
+  fluxBegin = 0;
+  while (fluxBegin < binCount && frequencies[fluxBegin] < FLUX_LOW_HZ) {
+    ++fluxBegin;
+  }
+  fluxEnd = fluxBegin;
+  while (fluxEnd < binCount && frequencies[fluxEnd] <= FLUX_HIGH_HZ) {
+    ++fluxEnd;
+  }
+
+  resetFlux();
+}
+
+void SpectralAnalyzer::resetFlux() {
+  lastLogMagnitudes.assign(frequencies.size(), 0.0);
+}
+
+void SpectralAnalyzer::compute(const double* magnitudes,
+                               SpectralFeatures& features) {
+  const double* binFrequencies = frequencies.data();
+
+  double bandSums[SpectralFeatures::BAND_COUNT] = {};
+  double weightedSum = 0.0;
+  double magnitudeSum = 0.0;
+  double totalEnergy = 0.0;
+  double peak = 0.0;
+
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    const Chunk& chunk = chunks[c];
+    ChunkStats stats =
+        chunkFunction(magnitudes + chunk.begin, binFrequencies + chunk.begin,
+                      chunk.end - chunk.begin);
+
+    magnitudeSum += stats.sum;
+    weightedSum += stats.weightedSum;
+    totalEnergy += stats.energy;
+    chunkEnergies[c] = stats.energy;
+    if (chunk.band >= 0) {
+      bandSums[chunk.band] += stats.sum;
+      peak = std::max(peak, stats.peak);
+    }
+  }
+
+  normalizeBands(bandSums, peak, features.bandLevels);
+
+  features.centroid = magnitudeSum > 0.0 ? weightedSum / magnitudeSum : 0.0;
+
+  // Rolloff: skip whole chunks by their energy, then scan the one chunk
+  // where the cumulative energy crosses the target
+  double targetEnergy = ROLLOFF_FRACTION * totalEnergy;
+  double cumulativeEnergy = 0.0;
+  features.rolloff = 0.0;
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    if (cumulativeEnergy + chunkEnergies[c] < targetEnergy) {
+      cumulativeEnergy += chunkEnergies[c];
+      continue;
+    }
+
+    // Falls back to the chunk's last bin if rounding in the vector sum put
+    // the crossing just past it
+    size_t i = chunks[c].begin;
+    for (; i + 1 < chunks[c].end; ++i) {
+      cumulativeEnergy += magnitudes[i] * magnitudes[i];
+      if (cumulativeEnergy >= targetEnergy) break;
+    }
+    features.rolloff = binFrequencies[i];
+    break;
+  }
+
+  // Flux stays scalar: there's no vector log1p, and caching the previous
+  // logs already halves the calls
+  features.flux = 0.0;
+  for (size_t i = fluxBegin; i < fluxEnd; ++i) {
+    double logMagnitude = std::log1p(magnitudes[i]);
+    double diff = logMagnitude - lastLogMagnitudes[i];
+    if (diff > 0.0) features.flux += diff;
+    lastLogMagnitudes[i] = logMagnitude;
+  }
+}
+
+void SpectralAnalyzer::computeBands(const double* magnitudes,
+                                    double* bandLevels) {
+  const double* binFrequencies = frequencies.data();
+
+  double bandSums[SpectralFeatures::BAND_COUNT] = {};
+  double peak = 0.0;
+
+  // The kernels still accumulate every statistic, but in the same pass, so
+  // the unused ones cost next to nothing; the DC chunk is skipped outright
+  for (const Chunk& chunk : chunks) {
+    if (chunk.band < 0) continue;
+    ChunkStats stats =
+        chunkFunction(magnitudes + chunk.begin, binFrequencies + chunk.begin,
+                      chunk.end - chunk.begin);
+    bandSums[chunk.band] += stats.sum;
+    peak = std::max(peak, stats.peak);
+  }
+
+  normalizeBands(bandSums, peak, bandLevels);
+}
+
+void SpectralAnalyzer::normalizeBands(const double* bandSums, double peak,
+                                      double* bandLevels) const {
+  // Mean of the peak-normalized magnitudes
+  for (int band = 0; band < SpectralFeatures::BAND_COUNT; ++band) {
+    double level = 0.0;
+    if (peak > 0.0 && bandBinCounts[band] > 0) {
+      level = bandSums[band] / peak / bandBinCounts[band];
+    }
+    bandLevels[band] = std::clamp(level, 0.0, 1.0);
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Instruction set used by SpectralAnalyzer's inner loop
+ *
+ * Scalar is the reference; the others must match it within floating-point
+ * reassociation error.
+ */
+enum class SpectralKernel { Scalar, SSE2, AVX2, NEON };
+
+/** @brief Per-analysis spectral features computed from FFT magnitudes */
+struct SpectralFeatures {
+  static constexpr int BAND_COUNT = 5;
+
+  // Bass, low mid, mid, high mid and treble: mean magnitude in the band,
+  // normalized by the spectrum's peak (DC excluded), in [0, 1]
+  double bandLevels[BAND_COUNT] = {};
+
+  double centroid = 0.0;  // Hz
+  double rolloff = 0.0;   // Hz below which 85% of the energy lies
+  double flux = 0.0;      // Positive log-magnitude change, 30 Hz to 4 kHz
+};
+
+/**
+ * @brief Fused single-pass spectral feature extraction
+ *
+ * Bin ranges for the frequency bands are computed once per FFT size and
+ * sample rate, so the per-analysis pass has no frequency comparisons. Each
+ * band is walked in short chunks by a SIMD kernel that accumulates sum,
+ * frequency-weighted sum, energy and peak together; the rolloff is then
+ * found from the chunk energies with a scalar scan of a single chunk.
+ *
+ * Flux keeps the log magnitudes of the previous call.
+ */
+class SpectralAnalyzer {
+ public:
+  SpectralAnalyzer();
+
+  /** @brief Rebuild bin ranges; `frequencies` gives each bin's centre in Hz */
+  void configure(const double* frequencies, size_t binCount);
+
+  /** @brief Forget the previous spectrum, so the next flux is measured from
+   * silence */
+  void resetFlux();
+
+  /**
+   * @brief Compute features for `magnitudes`, which must hold as many bins
+   * as the frequencies passed to configure()
+   */
+  void compute(const double* magnitudes, SpectralFeatures& features);
+
+  /**
+   * @brief Compute only the band levels, into BAND_COUNT values at
+   * `bandLevels`
+   *
+   * Skips the centroid, rolloff and flux, and leaves the previous spectrum
+   * kept for flux untouched.
+   */
+  void computeBands(const double* magnitudes, double* bandLevels);
+
+  /** @brief Select the inner loop. Returns false if unsupported here. */
+  bool setKernel(SpectralKernel kernel);
+  SpectralKernel getKernel() const { return kernel; }
+
+  /** @brief Fastest kernel this CPU supports */
+  static SpectralKernel getBestKernel();
+  static bool isKernelSupported(SpectralKernel kernel);
+  static const char* getKernelName(SpectralKernel kernel);
+
+  struct ChunkStats {
+    double sum;
+    double weightedSum;  // Sum of frequency * magnitude
+    double energy;       // Sum of magnitude squared
+    double peak;
+  };
+
+  using ChunkFunction = ChunkStats (*)(const double* magnitudes,
+                                       const double* frequencies,
+                                       size_t count);
+
+ private:
+  struct Chunk {
+    size_t begin;
+    size_t end;
+    int band;  // -1 for the DC bin, which counts toward no band
+  };
+
+  void normalizeBands(const double* bandSums, double peak,
+                      double* bandLevels) const;
+
+  SpectralKernel kernel;
+  ChunkFunction chunkFunction;
+
+  std::vector<double> frequencies;
+  std::vector<Chunk> chunks;
+  std::vector<double> chunkEnergies;
+  size_t bandBinCounts[SpectralFeatures::BAND_COUNT] = {};
+
+  // Flux is measured over [fluxBegin, fluxEnd)
+  size_t fluxBegin = 0;
+  size_t fluxEnd = 0;
+  std::vector<double> lastLogMagnitudes;
+};
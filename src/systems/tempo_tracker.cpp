@@ -0,0 +1,315 @@
+#include "tempo_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Spread of the tempo prior around PREFERRED_BPM, in octaves
+const double PRIOR_OCTAVES = 1.0;
+
+// A lag scores the mean autocorrelation at its first few multiples, so a
+// period that repeats on is preferred over a half or double one
+const int TEMPO_HARMONICS = 4;
+
+// Lags are searched at this resolution, in hops, since periods rarely fall
+// on whole hops
+const double LAG_STEP = 0.25;
+
+// Tempo changes smaller than this fraction are smoothed, larger ones taken
+// at once
+const double TEMPO_SMOOTHING_RANGE = 0.05;
+
+// Beats of the envelope the comb lines up with when finding the phase
+const int COMB_BEATS = 4;
+
+// Fraction of a phase error corrected at once, so one misplaced onset
+// can't throw the beat off
+const double PHASE_GAIN = 0.25;
+
+// Onsets this far either side of a predicted beat, as a fraction of the
+// period, count towards correcting it
+const double PHASE_TOLERANCE = 0.15;
+
+// Onsets weaker than this multiple of the mean envelope don't correct the
+// phase
+const float ONSET_THRESHOLD = 1.5f;
+
+}  // namespace
+
+TempoTracker::~TempoTracker() { cleanup(); }
+
+void TempoTracker::cleanup() {
+  if (forwardPlan) fftwf_destroy_plan(forwardPlan);
+  if (inversePlan) fftwf_destroy_plan(inversePlan);
+  if (fftIn) fftwf_free(fftIn);
+  if (fftOut) fftwf_free(fftOut);
+  if (autocorrelation) fftwf_free(autocorrelation);
+  forwardPlan = nullptr;
+  inversePlan = nullptr;
+  fftIn = nullptr;
+  fftOut = nullptr;
+  autocorrelation = nullptr;
+  fftSize = 0;
+}
+
+void TempoTracker::configure(double hopRate) {
+  cleanup();
+  this->hopRate = hopRate;
+
+  // Long enough to hold two periods at MIN_BPM, for the harmonic
+  size_t windowHops = static_cast<size_t>(std::ceil(WINDOW_SECONDS * hopRate));
+  windowHops = std::max<size_t>(
+      windowHops, static_cast<size_t>(std::ceil(120.0 * hopRate / MIN_BPM)) +
+                      2);
+  envelope.assign(windowHops, 0.0f);
+
+  fftSize = 1;
+  while (fftSize < static_cast<int>(2 * windowHops)) fftSize <<= 1;
+  fftIn = fftwf_alloc_real(fftSize);
+  fftOut = fftwf_alloc_complex(fftSize / 2 + 1);
+  autocorrelation = fftwf_alloc_real(fftSize);
+
+  // Small and planned rarely, so estimating beats measuring
+  forwardPlan =
+      fftwf_plan_dft_r2c_1d(fftSize, fftIn, fftOut, FFTW_ESTIMATE);
+  inversePlan =
+      fftwf_plan_dft_c2r_1d(fftSize, fftOut, autocorrelation, FFTW_ESTIMATE);
+
+  reset();
+}
+
+void TempoTracker::reset() {
+  std::fill(envelope.begin(), envelope.end(), 0.0f);
+  newest = envelope.empty() ? 0 : envelope.size() - 1;
+  filled = 0;
+  hopCount = 0;
+  hopsSinceUpdate = 0;
+  envelopeMean = 0.0f;
+  period = 0.0;
+  challengerPeriod = 0.0;
+  lastBeat = 0.0;
+  nextBeat = 0.0;
+  confidence = 0.0;
+  correctionPending = false;
+}
+
+bool TempoTracker::push(double onsetStrength) {
+  if (envelope.empty()) return false;
+
+  newest = (newest + 1) % envelope.size();
+  envelope[newest] = static_cast<float>(std::max(0.0, onsetStrength));
+  filled = std::min(filled + 1, envelope.size());
+  const int64_t hop = hopCount++;
+
+  // Re-estimate once half a window is in, then every division of it
+  const size_t updateInterval =
+      std::max<size_t>(1, envelope.size() / UPDATE_DIVISIONS);
+  if (++hopsSinceUpdate >= updateInterval && filled >= envelope.size() / 2) {
+    hopsSinceUpdate = 0;
+    updateTempo();
+  }
+
+  if (period <= 0.0) return false;
+
+  // The beat falls on the hop nearest its predicted time
+  bool beat = false;
+  if (hop + 0.5 >= nextBeat) {
+    beat = true;
+    lastBeat = nextBeat;
+    while (nextBeat <= hop + 0.5) nextBeat += period;
+    correctionPending = true;
+  }
+
+  if (correctionPending && hop >= lastBeat + PHASE_TOLERANCE * period) {
+    correctionPending = false;
+    correctPhase();
+  }
+
+  return beat;
+}
+
+void TempoTracker::updateTempo() {
+  const size_t count = filled;
+
+  // The envelope, oldest first, less its mean so the autocorrelation
+  // measures periodicity rather than loudness. A light smoothing spreads
+  // each onset over neighbouring hops, so periods that fall between whole
+  // hops still correlate fully.
+  double sum = 0.0;
+  for (size_t age = 0; age < count; ++age) {
+    sum += envelopeAt(age);
+  }
+  const float mean = static_cast<float>(sum / count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t age = count - 1 - i;
+    float centre = envelopeAt(age);
+    float older = age + 1 < count ? envelopeAt(age + 1) : centre;
+    float newer = age > 0 ? envelopeAt(age - 1) : centre;
+    fftIn[i] = 0.25f * (older + 2.0f * centre + newer) - mean;
+  }
+  std::fill(fftIn + count, fftIn + fftSize, 0.0f);
+  envelopeMean = mean;
+
+  // Autocorrelation is the inverse transform of the power spectrum
+  fftwf_execute(forwardPlan);
+  for (int k = 0; k < fftSize / 2 + 1; ++k) {
+    fftOut[k][0] = fftOut[k][0] * fftOut[k][0] + fftOut[k][1] * fftOut[k][1];
+    fftOut[k][1] = 0.0f;
+  }
+  fftwf_execute(inversePlan);
+
+  // Mean product per overlapping pair, so long lags aren't penalized for
+  // overlapping less
+  auto correlation = [&](size_t lag) {
+    return lag < count ? autocorrelation[lag] / static_cast<double>(count - lag)
+                       : 0.0;
+  };
+  const double energy = correlation(0);
+  if (energy <= 1e-12) {
+    confidence = 0.0;
+    return;
+  }
+
+  // Linear between whole lags
+  auto correlationAt = [&](double lag) {
+    size_t whole = static_cast<size_t>(lag);
+    double fraction = lag - static_cast<double>(whole);
+    return (1.0 - fraction) * correlation(whole) +
+           fraction * correlation(whole + 1);
+  };
+
+  const double minLag = std::max(1.0, 60.0 * hopRate / MAX_BPM);
+  const double maxLag =
+      std::min(60.0 * hopRate / MIN_BPM, static_cast<double>(count) / 2.0);
+  if (minLag + 2.0 * LAG_STEP > maxLag) return;
+
+  auto score = [&](double lag) {
+    double bpm = 60.0 * hopRate / lag;
+    double octaves = std::log2(bpm / PREFERRED_BPM) / PRIOR_OCTAVES;
+    double prior = std::exp(-0.5 * octaves * octaves);
+
+    double sum = 0.0;
+    for (int k = 1; k <= TEMPO_HARMONICS; ++k) {
+      sum += correlationAt(k * lag);
+    }
+    return prior * sum / TEMPO_HARMONICS;
+  };
+
+  double bestLag = minLag;
+  double bestScore = score(minLag);
+  for (double lag = minLag + LAG_STEP; lag <= maxLag; lag += LAG_STEP) {
+    double value = score(lag);
+    if (value > bestScore) {
+      bestScore = value;
+      bestLag = lag;
+    }
+  }
+  if (bestScore <= 0.0) {
+    confidence = 0.0;
+    return;
+  }
+
+  // Parabolic interpolation between neighbouring steps
+  double newPeriod = bestLag;
+  if (bestLag - LAG_STEP >= minLag && bestLag + LAG_STEP <= maxLag) {
+    double before = score(bestLag - LAG_STEP);
+    double after = score(bestLag + LAG_STEP);
+    double curvature = before - 2.0 * bestScore + after;
+    if (curvature < 0.0) {
+      newPeriod += 0.5 * LAG_STEP * (before - after) / curvature;
+    }
+  }
+
+  confidence = std::clamp(correlationAt(newPeriod) / energy, 0.0, 1.0);
+
+  // Small changes are smoothed in. A jump, such as to the half or double
+  // tempo, has to win two updates running before it is believed.
+  auto near = [](double a, double b) {
+    return std::abs(a - b) < TEMPO_SMOOTHING_RANGE * b;
+  };
+  if (period > 0.0 && near(newPeriod, period)) {
+    period += 0.5 * (newPeriod - period);
+    challengerPeriod = 0.0;
+    updatePhase(false);
+  } else if (period > 0.0 && !near(newPeriod, challengerPeriod)) {
+    challengerPeriod = newPeriod;
+    updatePhase(false);
+  } else {
+    period = newPeriod;
+    challengerPeriod = 0.0;
+    updatePhase(true);
+  }
+}
+
+void TempoTracker::updatePhase(bool relock) {
+  // Find how long ago the last beat was from the comb of beats, spaced one
+  // period apart, that collects the most onset strength
+  const int64_t current = hopCount - 1;
+  const int beats = std::max(
+      1, std::min(COMB_BEATS, static_cast<int>((filled - 1) / period) + 1));
+  const int phases = static_cast<int>(std::ceil(period));
+
+  int bestPhase = 0;
+  double bestStrength = -1.0;
+  for (int phase = 0; phase < phases; ++phase) {
+    double strength = 0.0;
+    for (int k = 0; k < beats; ++k) {
+      size_t age = static_cast<size_t>(std::lround(phase + k * period));
+      if (age < filled) strength += envelopeAt(age);
+    }
+    if (strength > bestStrength) {
+      bestStrength = strength;
+      bestPhase = phase;
+    }
+  }
+
+  double measuredNext = static_cast<double>(current - bestPhase) + period;
+  if (relock) {
+    // A new period: take the measured phase as is
+    lastBeat = measuredNext - period;
+    nextBeat = measuredNext;
+    return;
+  }
+
+  // Already running: pull the prediction part way towards the measurement,
+  // the shorter way round the beat. Never more than an eighth of a period,
+  // so a beat can't be skipped or repeated.
+  double error = std::remainder(measuredNext - nextBeat, period);
+  nextBeat += PHASE_GAIN * error;
+}
+
+void TempoTracker::correctPhase() {
+  // The strongest onset within tolerance of the beat just predicted
+  const int64_t current = hopCount - 1;
+  const double tolerance = PHASE_TOLERANCE * period;
+  const int64_t first = static_cast<int64_t>(std::ceil(lastBeat - tolerance));
+  const int64_t last = static_cast<int64_t>(std::floor(lastBeat + tolerance));
+
+  int64_t bestHop = -1;
+  float bestStrength = ONSET_THRESHOLD * envelopeMean;
+  for (int64_t hop = std::max<int64_t>(first, 0); hop <= last; ++hop) {
+    size_t age = static_cast<size_t>(current - hop);
+    if (hop > current || age >= filled) continue;
+    if (envelopeAt(age) > bestStrength) {
+      bestStrength = envelopeAt(age);
+      bestHop = hop;
+    }
+  }
+  if (bestHop < 0) return;
+
+  double error = static_cast<double>(bestHop) - lastBeat;
+  lastBeat += PHASE_GAIN * error;
+  nextBeat += PHASE_GAIN * error;
+}
+
+double TempoTracker::getBeatPhase() const {
+  if (period <= 0.0) return 0.0;
+  double untilNext = nextBeat - static_cast<double>(hopCount - 1);
+  return std::clamp(1.0 - untilNext / period, 0.0, 1.0);
+}
+
+double TempoTracker::getSecondsToNextBeat() const {
+  if (period <= 0.0 || hopRate <= 0.0) return -1.0;
+  return std::max(0.0, nextBeat - static_cast<double>(hopCount - 1)) / hopRate;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <fftw3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Incremental tempo and beat-phase tracker over an onset envelope
+ *
+ * Fed one onset strength per analysis hop. The last WINDOW_SECONDS of the
+ * envelope are autocorrelated through an FFT each time another
+ * 1 / UPDATE_DIVISIONS of the window has come in, so a hop costs
+ * O(log n) amortized. The lag in MIN_BPM..MAX_BPM whose multiples
+ * correlate best, weighted towards PREFERRED_BPM to settle octave
+ * ambiguity, gives the beat period.
+ *
+ * The phase comes from the comb of beats at that period that best lines
+ * up with the recent envelope. Between updates it runs on by itself,
+ * nudged towards the strongest onset near each predicted beat, so beats
+ * can be predicted ahead instead of being found a hop after the fact.
+ *
+ * Time is counted in hops, i.e. audio time, never wall-clock time.
+ */
+class TempoTracker {
+ public:
+  static constexpr double MIN_BPM = 60.0;
+  static constexpr double MAX_BPM = 180.0;
+  static constexpr double PREFERRED_BPM = 120.0;
+  static constexpr double WINDOW_SECONDS = 6.0;
+  static constexpr int UPDATE_DIVISIONS = 8;
+
+  TempoTracker() = default;
+  ~TempoTracker();
+
+  TempoTracker(const TempoTracker&) = delete;
+  TempoTracker& operator=(const TempoTracker&) = delete;
+
+  /**
+   * @brief Size the window for `hopRate` hops per second and forget all
+   * history. Allocates and plans the FFTs, so call it from one thread at a
+   * time with any other FFTW planning.
+   */
+  void configure(double hopRate);
+
+  /** @brief Forget the envelope and the beat, keeping the configuration */
+  void reset();
+
+  /**
+   * @brief Add the next hop's onset strength. Returns true if a beat is
+   * predicted to fall on this hop.
+   */
+  bool push(double onsetStrength);
+
+  double getHopRate() const { return hopRate; }
+
+  /** @brief Beats per minute, or 0 until a tempo has been found */
+  double getTempo() const {
+    return period > 0.0 ? 60.0 * hopRate / period : 0.0;
+  }
+
+  /** @brief How periodic the envelope is at the tempo, in [0, 1] */
+  double getConfidence() const { return confidence; }
+
+  /** @brief Progress through the current beat: 0 on a beat, rising to 1 */
+  double getBeatPhase() const;
+
+  /** @brief Seconds from the last pushed hop to the next predicted beat,
+   * or negative without a tempo */
+  double getSecondsToNextBeat() const;
+
+ private:
+  void updateTempo();
+  void updatePhase(bool relock);
+  void correctPhase();
+  void cleanup();
+
+  // Envelope value `age` hops before the newest
+  float envelopeAt(size_t age) const {
+    return envelope[(newest + envelope.size() - age) % envelope.size()];
+  }
+
+  double hopRate = 0.0;
+
+  // The last window of onset strengths, circular; `newest` indexes the
+  // last one pushed
+  std::vector<float> envelope;
+  size_t newest = 0;
+  size_t filled = 0;
+  int64_t hopCount = 0;  // Hops pushed since the last reset
+  size_t hopsSinceUpdate = 0;
+  float envelopeMean = 0.0f;  // As of the last update
+
+  // Zero-padded to twice the window, so the circular autocorrelation the
+  // FFT gives is the linear one for every lag in the window
+  int fftSize = 0;
+  float* fftIn = nullptr;
+  fftwf_complex* fftOut = nullptr;
+  float* autocorrelation = nullptr;
+  fftwf_plan forwardPlan = nullptr;
+  fftwf_plan inversePlan = nullptr;
+
+  // Beat period in hops, 0 until found, and the hops the last and next
+  // beats are predicted on, counted from the last reset
+  double period = 0.0;
+  double challengerPeriod = 0.0;  // A different period awaiting confirmation
+  double lastBeat = 0.0;
+  double nextBeat = 0.0;
+  double confidence = 0.0;
+
+  // Set on each predicted beat; once the hops around it have all come in,
+  // the prediction is nudged towards the strongest onset among them
+  bool correctionPending = false;
+};
@@ -0,0 +1,326 @@
+#include "tween_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const float PI = 3.14159265358979f;
+
+// How far BackOut overshoots
+const float BACK_OVERSHOOT = 1.70158f;
+
+float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+SDL_FPoint lerp(const SDL_FPoint& a, const SDL_FPoint& b, float t) {
+  return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+}
+
+SDL_FColor lerp(const SDL_FColor& a, const SDL_FColor& b, float t) {
+  return {a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t,
+          a.b + (b.b - a.b) * t, a.a + (b.a - a.a) * t};
+}
+
+}  // namespace
+
+float applyEasing(Easing easing, float t) {
+  switch (easing) {
+    case Easing::Linear:
+      return t;
+    case Easing::QuadIn:
+      return t * t;
+    case Easing::QuadOut:
+      return t * (2.0f - t);
+    case Easing::QuadInOut:
+      return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
+    case Easing::CubicIn:
+      return t * t * t;
+    case Easing::CubicOut: {
+      float u = 1.0f - t;
+      return 1.0f - u * u * u;
+    }
+    case Easing::CubicInOut: {
+      float u = 1.0f - t;
+      return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * u * u * u;
+    }
+    case Easing::SineInOut:
+      return 0.5f - 0.5f * std::cos(PI * t);
+    case Easing::ExpoOut:
+      return t >= 1.0f ? 1.0f : 1.0f - std::exp2(-10.0f * t);
+    case Easing::BackOut: {
+      float u = t - 1.0f;
+      return 1.0f + u * u * ((BACK_OVERSHOOT + 1.0f) * u + BACK_OVERSHOOT);
+    }
+    case Easing::Step:
+      return t >= 1.0f ? 1.0f : 0.0f;
+  }
+  return t;
+}
+
+const char* getEasingName(Easing easing) {
+  switch (easing) {
+    case Easing::Linear:
+      return "Linear";
+    case Easing::QuadIn:
+      return "Quad In";
+    case Easing::QuadOut:
+      return "Quad Out";
+    case Easing::QuadInOut:
+      return "Quad In Out";
+    case Easing::CubicIn:
+      return "Cubic In";
+    case Easing::CubicOut:
+      return "Cubic Out";
+    case Easing::CubicInOut:
+      return "Cubic In Out";
+    case Easing::SineInOut:
+      return "Sine In Out";
+    case Easing::ExpoOut:
+      return "Expo Out";
+    case Easing::BackOut:
+      return "Back Out";
+    case Easing::Step:
+      return "Step";
+  }
+  return "Unknown";
+}
+
+float TweenGroup::place(float length) {
+  float start = mode == Mode::Sequence ? duration : 0.0f;
+  duration = std::max(duration, start + length);
+  return start;
+}
+
+template <typename T>
+void TweenGroup::addTracks(const std::vector<Track<T>>& tracks,
+                           float offset) {
+  for (const Track<T>& track : tracks) {
+    tracksOf<T>().push_back({track.target, offset + track.start, track.keys});
+  }
+}
+
+TweenGroup& TweenGroup::add(const TweenGroup& group) {
+  float offset = place(group.duration);
+  addTracks(group.floatTracks, offset);
+  addTracks(group.pointTracks, offset);
+  addTracks(group.colorTracks, offset);
+  return *this;
+}
+
+TweenGroup& TweenGroup::delay(float seconds) {
+  place(seconds);
+  return *this;
+}
+
+template <typename T>
+void TweenSystem::Tracks<T>::add(const TweenGroup::Track<T>& track,
+                                 uint32_t group) {
+  if (track.keys.empty()) return;
+
+  const uint32_t first = static_cast<uint32_t>(keyTime.size());
+  for (const Keyframe<T>& key : track.keys) {
+    keyTime.push_back(key.time);
+    keyValue.push_back(key.value);
+    keyEasing.push_back(key.easing);
+  }
+
+  target.push_back(track.target);
+  this->group.push_back(group);
+  start.push_back(track.start);
+  firstKey.push_back(first);
+  lastKey.push_back(static_cast<uint32_t>(keyTime.size() - 1));
+  cursor.push_back(first);
+}
+
+template <typename T>
+void TweenSystem::Tracks<T>::advance(const std::vector<float>& groupTime) {
+  const size_t count = size();
+  for (size_t i = 0; i < count; ++i) {
+    const float local = groupTime[group[i]] - start[i];
+    const uint32_t last = lastKey[i];
+    uint32_t key = cursor[i];
+
+    if (local >= keyTime[last]) {
+      // Past the end: write the final value once, parking the cursor one
+      // past the last key to mark it written. A track of a single key
+      // starts on its last key, so it can't be parked there.
+      if (key <= last) {
+        cursor[i] = last + 1;
+        *target[i] = keyValue[last];
+      }
+      continue;
+    }
+
+    // Written out, or before the current segment: the group looped, so
+    // start over
+    if (key > last || local < keyTime[key]) {
+      key = firstKey[i];
+      if (local < keyTime[key]) {
+        cursor[i] = key;
+        continue;
+      }
+    }
+
+    while (local >= keyTime[key + 1]) ++key;
+    if (key != cursor[i]) cursor[i] = key;
+
+    const float from = keyTime[key];
+    const float span = keyTime[key + 1] - from;
+    const float eased = applyEasing(keyEasing[key + 1], (local - from) / span);
+    *target[i] = lerp(keyValue[key], keyValue[key + 1], eased);
+  }
+}
+
+template <typename T>
+void TweenSystem::Tracks<T>::removeEnded(
+    const std::vector<GroupState>& groupState) {
+  // Keys are stored in track order, so surviving tracks and their keys
+  // both only ever move down
+  size_t outTrack = 0;
+  uint32_t outKey = 0;
+  for (size_t i = 0; i < size(); ++i) {
+    if (groupState[group[i]] != GroupState::Playing) continue;
+
+    const uint32_t first = firstKey[i];
+    const uint32_t newFirst = outKey;
+    for (uint32_t key = first; key <= lastKey[i]; ++key, ++outKey) {
+      keyTime[outKey] = keyTime[key];
+      keyValue[outKey] = keyValue[key];
+      keyEasing[outKey] = keyEasing[key];
+    }
+
+    target[outTrack] = target[i];
+    group[outTrack] = group[i];
+    start[outTrack] = start[i];
+    firstKey[outTrack] = newFirst;
+    lastKey[outTrack] = outKey - 1;
+    cursor[outTrack] = cursor[i] - first + newFirst;
+    outTrack++;
+  }
+
+  target.resize(outTrack);
+  group.resize(outTrack);
+  start.resize(outTrack);
+  firstKey.resize(outTrack);
+  lastKey.resize(outTrack);
+  cursor.resize(outTrack);
+  keyTime.resize(outKey);
+  keyValue.resize(outKey);
+  keyEasing.resize(outKey);
+}
+
+template <typename T>
+void TweenSystem::Tracks<T>::clear() {
+  target.clear();
+  group.clear();
+  start.clear();
+  firstKey.clear();
+  lastKey.clear();
+  cursor.clear();
+  keyTime.clear();
+  keyValue.clear();
+  keyEasing.clear();
+}
+
+TweenSystem::TweenId TweenSystem::play(const TweenGroup& group,
+                                       bool looping) {
+  uint32_t slot;
+  if (!freeGroups.empty()) {
+    slot = freeGroups.back();
+    freeGroups.pop_back();
+  } else {
+    slot = static_cast<uint32_t>(groupTime.size());
+    groupTime.push_back(0.0f);
+    groupDuration.push_back(0.0f);
+    groupLooping.push_back(0);
+    groupState.push_back(GroupState::Free);
+    groupGenerations.push_back(0);
+
+    // Ended groups are freed during update(), which mustn't allocate
+    freeGroups.reserve(groupTime.capacity());
+  }
+
+  groupTime[slot] = 0.0f;
+  groupDuration[slot] = group.duration;
+  groupLooping[slot] = looping && group.duration > 0.0f;
+  groupState[slot] = GroupState::Playing;
+  liveGroups++;
+
+  for (const auto& track : group.floatTracks) floats.add(track, slot);
+  for (const auto& track : group.pointTracks) points.add(track, slot);
+  for (const auto& track : group.colorTracks) colors.add(track, slot);
+
+  return {slot, groupGenerations[slot]};
+}
+
+void TweenSystem::stop(TweenId id) {
+  if (!isPlaying(id)) return;
+
+  // Its tracks stop writing at once and are dropped on the next update
+  groupState[id.index] = GroupState::Ended;
+  groupTime[id.index] = -std::numeric_limits<float>::infinity();
+  anyEnded = true;
+}
+
+bool TweenSystem::isPlaying(TweenId id) const {
+  return id.index < groupTime.size() &&
+         groupGenerations[id.index] == id.generation &&
+         groupState[id.index] == GroupState::Playing;
+}
+
+void TweenSystem::clear() {
+  floats.clear();
+  points.clear();
+  colors.clear();
+
+  for (uint32_t slot = 0; slot < groupTime.size(); ++slot) {
+    if (groupState[slot] != GroupState::Free) {
+      groupState[slot] = GroupState::Ended;
+    }
+  }
+  freeEndedGroups();
+}
+
+void TweenSystem::update(float deltaTime) {
+  // Group clocks first; tracks read them
+  for (size_t slot = 0; slot < groupTime.size(); ++slot) {
+    if (groupState[slot] != GroupState::Playing) continue;
+
+    float time = groupTime[slot] + deltaTime;
+    const float duration = groupDuration[slot];
+    if (groupLooping[slot]) {
+      time = std::fmod(time, duration);
+    } else if (time >= duration) {
+      // Its tracks still write their final values below
+      groupState[slot] = GroupState::Ended;
+      anyEnded = true;
+    }
+    groupTime[slot] = time;
+  }
+
+  floats.advance(groupTime);
+  points.advance(groupTime);
+  colors.advance(groupTime);
+
+  if (anyEnded) {
+    floats.removeEnded(groupState);
+    points.removeEnded(groupState);
+    colors.removeEnded(groupState);
+    freeEndedGroups();
+  }
+}
+
+void TweenSystem::freeEndedGroups() {
+  for (uint32_t slot = 0; slot < groupTime.size(); ++slot) {
+    if (groupState[slot] != GroupState::Ended) continue;
+
+    // Stale ids stop resolving, and the slot's clock can't reach a track
+    groupState[slot] = GroupState::Free;
+    groupGenerations[slot]++;
+    groupTime[slot] = -std::numeric_limits<float>::infinity();
+    freeGroups.push_back(slot);
+    liveGroups--;
+  }
+  anyEnded = false;
+}
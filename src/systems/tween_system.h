@@ -0,0 +1,211 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+/** @brief Easing curves, mapping progress through a segment 0..1 to 0..1 */
+enum class Easing : uint8_t {
+  Linear,
+  QuadIn,
+  QuadOut,
+  QuadInOut,
+  CubicIn,
+  CubicOut,
+  CubicInOut,
+  SineInOut,
+  ExpoOut,
+  BackOut,  // Overshoots, then settles
+  Step,     // Holds the previous value until the keyframe
+};
+
+float applyEasing(Easing easing, float t);
+
+const char* getEasingName(Easing easing);
+
+/**
+ * @brief A value a track passes through at `time` seconds after it starts.
+ * `easing` shapes the segment arriving at this keyframe.
+ */
+template <typename T>
+struct Keyframe {
+  float time;
+  T value;
+  Easing easing = Easing::Linear;
+};
+
+// The value types tracks can animate: scalars, points and colors
+template <typename T>
+inline constexpr bool IS_TWEENABLE = std::is_same_v<T, float> ||
+                                     std::is_same_v<T, SDL_FPoint> ||
+                                     std::is_same_v<T, SDL_FColor>;
+
+/**
+ * @brief A set of keyframe tracks to be played together
+ *
+ * A sequence plays each thing added after the one before; a parallel group
+ * plays them all at once. Groups nest, but only while they are being
+ * built: adding a group flattens its tracks into this one with their start
+ * times offset, so a playing tween is just tracks and start times, with no
+ * tree to walk.
+ */
+class TweenGroup {
+ public:
+  enum class Mode { Sequence, Parallel };
+
+  static TweenGroup sequence() { return TweenGroup(Mode::Sequence); }
+  static TweenGroup parallel() { return TweenGroup(Mode::Parallel); }
+
+  /**
+   * @brief Add a track writing to `*target`, which must stay valid while
+   * the tween plays. Keyframe times are from the track's start, ascending.
+   */
+  template <typename T>
+  TweenGroup& add(T* target, std::initializer_list<Keyframe<T>> keys) {
+    static_assert(IS_TWEENABLE<T>, "Tracks animate float, SDL_FPoint or "
+                                   "SDL_FColor");
+    float length = keys.size() > 0 ? (keys.end() - 1)->time : 0.0f;
+    tracksOf<T>().push_back({target, place(length), {keys}});
+    return *this;
+  }
+
+  /** @brief Add a group, in sequence or alongside as this group's mode says */
+  TweenGroup& add(const TweenGroup& group);
+
+  /** @brief Wait before the next addition of a sequence, or last at least
+   * this long in parallel */
+  TweenGroup& delay(float seconds);
+
+  float getDuration() const { return duration; }
+
+ private:
+  friend class TweenSystem;
+
+  template <typename T>
+  struct Track {
+    T* target;
+    float start;
+    std::vector<Keyframe<T>> keys;
+  };
+
+  explicit TweenGroup(Mode mode) : mode(mode) {}
+
+  // Where something `length` long starts, stretching the group to fit it
+  float place(float length);
+
+  template <typename T>
+  std::vector<Track<T>>& tracksOf() {
+    if constexpr (std::is_same_v<T, float>) {
+      return floatTracks;
+    } else if constexpr (std::is_same_v<T, SDL_FPoint>) {
+      return pointTracks;
+    } else {
+      return colorTracks;
+    }
+  }
+
+  template <typename T>
+  void addTracks(const std::vector<Track<T>>& tracks, float offset);
+
+  Mode mode;
+  float duration = 0.0f;
+  std::vector<Track<float>> floatTracks;
+  std::vector<Track<SDL_FPoint>> pointTracks;
+  std::vector<Track<SDL_FColor>> colorTracks;
+};
+
+/**
+ * @brief Plays keyframe tweens from flat, per-type storage
+ *
+ * Every playing track of one value type lives at the same index across a
+ * handful of columns, its keyframes in shared contiguous arrays, so an
+ * update is one straight loop per type with no virtual calls or pointer
+ * chasing beyond the group clock and the target. Groups only keep a clock;
+ * their tracks read it and work out where they are themselves.
+ *
+ * A track writes to its target while it runs, and once more with its final
+ * value when it ends, so tracks in a sequence can share a target without
+ * fighting over it. Finished groups are dropped at the end of the update
+ * that finishes them, compacting the storage in place.
+ */
+class TweenSystem {
+ public:
+  /** @brief A playing group; goes stale once the group finishes or stops */
+  struct TweenId {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+  };
+
+  /** @brief Start playing `group`; looping groups repeat until stopped */
+  TweenId play(const TweenGroup& group, bool looping = false);
+
+  /** @brief Stop a group where it is. Its targets keep their values. */
+  void stop(TweenId id);
+
+  bool isPlaying(TweenId id) const;
+
+  /** @brief Stop everything */
+  void clear();
+
+  /** @brief Advance every group by `deltaTime` and write the tracks */
+  void update(float deltaTime);
+
+  size_t getGroupCount() const { return liveGroups; }
+
+  size_t getTrackCount() const {
+    return floats.size() + points.size() + colors.size();
+  }
+
+ private:
+  enum class GroupState : Uint8 {
+    Playing,
+    Ended,  // Finished or stopped; its tracks go at the end of the update
+    Free,
+  };
+
+  template <typename T>
+  struct Tracks {
+    // Per track
+    std::vector<T*> target;
+    std::vector<uint32_t> group;  // Slot of the group it plays in
+    std::vector<float> start;     // Seconds into the group
+    std::vector<uint32_t> firstKey;
+    std::vector<uint32_t> lastKey;
+    // Key starting the current segment, or one past the last key once the
+    // final value has been written
+    std::vector<uint32_t> cursor;
+
+    // Keyframes of every track, in track order
+    std::vector<float> keyTime;
+    std::vector<T> keyValue;
+    std::vector<Easing> keyEasing;
+
+    size_t size() const { return target.size(); }
+
+    void add(const TweenGroup::Track<T>& track, uint32_t group);
+    void advance(const std::vector<float>& groupTime);
+    void removeEnded(const std::vector<GroupState>& groupState);
+    void clear();
+  };
+
+  void freeEndedGroups();
+
+  // Group slots. A stopped group's clock is set to -infinity, so its
+  // tracks stop writing before they are compacted away.
+  std::vector<float> groupTime;
+  std::vector<float> groupDuration;
+  std::vector<Uint8> groupLooping;
+  std::vector<GroupState> groupState;
+  std::vector<uint32_t> groupGenerations;
+  std::vector<uint32_t> freeGroups;
+  size_t liveGroups = 0;
+  bool anyEnded = false;
+
+  Tracks<float> floats;
+  Tracks<SDL_FPoint> points;
+  Tracks<SDL_FColor> colors;
+};
@@ -0,0 +1,478 @@
+#include "wav_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const Uint16 FORMAT_PCM = 0x0001;
+const Uint16 FORMAT_MS_ADPCM = 0x0002;
+const Uint16 FORMAT_IEEE_FLOAT = 0x0003;
+const Uint16 FORMAT_ALAW = 0x0006;
+const Uint16 FORMAT_MULAW = 0x0007;
+const Uint16 FORMAT_IMA_ADPCM = 0x0011;
+const Uint16 FORMAT_EXTENSIBLE = 0xFFFE;
+
+// RF64 stores sizes over 4 GB in its ds64 chunk and marks the 32-bit fields
+// with this
+const Uint32 SIZE_IN_DS64 = 0xFFFFFFFF;
+
+// WAV is little-endian throughout
+Uint16 readU16(const Uint8* p) { return static_cast<Uint16>(p[0] | p[1] << 8); }
+
+Uint32 readU32(const Uint8* p) {
+  return static_cast<Uint32>(p[0]) | static_cast<Uint32>(p[1]) << 8 |
+         static_cast<Uint32>(p[2]) << 16 | static_cast<Uint32>(p[3]) << 24;
+}
+
+uint64_t readU64(const Uint8* p) {
+  return readU32(p) | static_cast<uint64_t>(readU32(p + 4)) << 32;
+}
+
+// 24-bit sample as the top three bytes of a 32-bit one
+Sint32 readS24(const Uint8* p) {
+  return static_cast<Sint32>(static_cast<Uint32>(p[0]) << 8 |
+                             static_cast<Uint32>(p[1]) << 16 |
+                             static_cast<Uint32>(p[2]) << 24);
+}
+
+// G.711 companded samples expand to 16-bit linear; see ITU-T G.711
+Sint16 decodeALaw(Uint8 value) {
+  value ^= 0x55;
+  int magnitude = (value & 0x0F) << 4;
+  const int segment = (value & 0x70) >> 4;
+  if (segment == 0) {
+    magnitude += 8;
+  } else {
+    magnitude = (magnitude + 0x108) << (segment - 1);
+  }
+  return static_cast<Sint16>((value & 0x80) ? magnitude : -magnitude);
+}
+
+Sint16 decodeMuLaw(Uint8 value) {
+  value = static_cast<Uint8>(~value);
+  const int magnitude = (((value & 0x0F) << 3) + 0x84) << ((value & 0x70) >> 4);
+  return static_cast<Sint16>((value & 0x80) ? 0x84 - magnitude
+                                            : magnitude - 0x84);
+}
+
+template <typename T>
+T readSample(const Uint8* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+// Average the channels of each frame; `decode` turns one sample into a
+// normalized float
+template <typename Decode>
+void downmix(const Uint8* src, int64_t count, int channels, int frameBytes,
+             int sampleBytes, float* out, Decode decode) {
+  const float scale = 1.0f / channels;
+  for (int64_t i = 0; i < count; ++i) {
+    const Uint8* frame = src + i * frameBytes;
+    float sum = 0.0f;
+    for (int c = 0; c < channels; ++c) {
+      sum += decode(frame + c * sampleBytes);
+    }
+    out[i] = sum * scale;
+  }
+}
+
+// Split each frame into left and right; see WavFile::readStereo
+template <typename Decode>
+void splitStereo(const Uint8* src, int64_t count, int channels,
+                 int frameBytes, int sampleBytes, float* left, float* right,
+                 Decode decode) {
+  if (channels == 1) {
+    for (int64_t i = 0; i < count; ++i) {
+      left[i] = right[i] = decode(src + i * frameBytes);
+    }
+    return;
+  }
+
+  const float sideScale = 2.0f / channels;
+  const float sharedScale = 1.0f / channels;
+  for (int64_t i = 0; i < count; ++i) {
+    const Uint8* frame = src + i * frameBytes;
+    float shared = 0.0f;
+    for (int c = 2; c < channels; ++c) {
+      shared += decode(frame + c * sampleBytes);
+    }
+    shared *= sharedScale;
+    left[i] = decode(frame) * sideScale + shared;
+    right[i] = decode(frame + sampleBytes) * sideScale + shared;
+  }
+}
+
+}  // namespace
+
+WavFile::~WavFile() { close(); }
+
+bool WavFile::open(const std::string& path) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    error = "Couldn't open " + path;
+    return false;
+  }
+  fileHandle = file;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    error = "Couldn't read the size of " + path;
+    close();
+    return false;
+  }
+  size = static_cast<size_t>(fileSize.QuadPart);
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    error = "Couldn't map " + path;
+    close();
+    return false;
+  }
+  mappingHandle = mapping;
+
+  data = static_cast<const Uint8*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!data) {
+    error = "Couldn't map " + path;
+    close();
+    return false;
+  }
+#else
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "Couldn't open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    error = "Couldn't read the size of " + path;
+    close();
+    return false;
+  }
+  size = static_cast<size_t>(info.st_size);
+
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapped == MAP_FAILED) {
+    error = "Couldn't map " + path + ": " + std::strerror(errno);
+    close();
+    return false;
+  }
+  data = static_cast<const Uint8*>(mapped);
+#endif
+
+  if (!parse()) {
+    close();
+    return false;
+  }
+  error.clear();
+  return true;
+}
+
+void WavFile::close() {
+#ifdef _WIN32
+  if (data) UnmapViewOfFile(data);
+  if (mappingHandle) CloseHandle(mappingHandle);
+  if (fileHandle) CloseHandle(fileHandle);
+  mappingHandle = nullptr;
+  fileHandle = nullptr;
+#else
+  if (data) munmap(const_cast<Uint8*>(data), size);
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+#endif
+  SDL_free(decoded);
+  decoded = nullptr;
+  data = nullptr;
+  size = 0;
+  samples = nullptr;
+  sampleRate = 0;
+  channels = 0;
+  bitsPerSample = 0;
+  frameBytes = 0;
+  frameCount = 0;
+}
+
+bool WavFile::parse() {
+  if (size < 12 || std::memcmp(data + 8, "WAVE", 4) != 0 ||
+      (std::memcmp(data, "RIFF", 4) != 0 &&
+       std::memcmp(data, "RF64", 4) != 0)) {
+    error = "Not a WAV file";
+    return false;
+  }
+
+  Uint16 format = 0;
+  uint64_t ds64DataSize = 0;
+  uint64_t dataSize = 0;
+  bool haveFormat = false;
+
+  // Walk the chunks; anything but ds64, fmt and data (bext, LIST, cue...)
+  // is skipped
+  size_t offset = 12;
+  while (offset + 8 <= size && !(haveFormat && samples)) {
+    const Uint8* chunk = data + offset;
+    Uint32 chunkSize = readU32(chunk + 4);
+    const Uint8* body = chunk + 8;
+    size_t available = size - offset - 8;
+
+    if (std::memcmp(chunk, "ds64", 4) == 0 && available >= 16) {
+      ds64DataSize = readU64(body + 8);
+    } else if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 &&
+               available >= 16) {
+      format = readU16(body);
+      channels = readU16(body + 2);
+      sampleRate = static_cast<int>(readU32(body + 4));
+      frameBytes = readU16(body + 12);
+      bitsPerSample = readU16(body + 14);
+
+      // The real format code leads the extensible header's subformat GUID
+      if (format == FORMAT_EXTENSIBLE && chunkSize >= 40 && available >= 40) {
+        format = readU16(body + 24);
+      }
+      haveFormat = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      samples = body;
+      dataSize = chunkSize == SIZE_IN_DS64 && ds64DataSize ? ds64DataSize
+                                                           : chunkSize;
+      // Recorders that were cut off leave the header claiming more than
+      // was written
+      dataSize = std::min<uint64_t>(dataSize, available);
+    }
+
+    // Chunks are padded to an even length
+    uint64_t next = offset + 8 + static_cast<uint64_t>(chunkSize) +
+                    (chunkSize & 1);
+    if (chunkSize == SIZE_IN_DS64 || next > size) break;
+    offset = static_cast<size_t>(next);
+  }
+
+  if (!haveFormat || !samples) {
+    error = "WAV file has no fmt or data chunk";
+    return false;
+  }
+
+  if (format == FORMAT_MS_ADPCM || format == FORMAT_IMA_ADPCM) {
+    return decodeAll();
+  }
+
+  if (format == FORMAT_PCM && bitsPerSample == 8) {
+    encoding = Encoding::U8;
+  } else if (format == FORMAT_PCM && bitsPerSample == 16) {
+    encoding = Encoding::S16;
+  } else if (format == FORMAT_PCM && bitsPerSample == 24) {
+    encoding = Encoding::S24;
+  } else if (format == FORMAT_PCM && bitsPerSample == 32) {
+    encoding = Encoding::S32;
+  } else if (format == FORMAT_IEEE_FLOAT && bitsPerSample == 32) {
+    encoding = Encoding::F32;
+  } else if (format == FORMAT_IEEE_FLOAT && bitsPerSample == 64) {
+    encoding = Encoding::F64;
+  } else if (format == FORMAT_ALAW && bitsPerSample == 8) {
+    encoding = Encoding::ALaw;
+  } else if (format == FORMAT_MULAW && bitsPerSample == 8) {
+    encoding = Encoding::MuLaw;
+  } else {
+    error = "Unsupported WAV encoding: format " + std::to_string(format) +
+            ", " + std::to_string(bitsPerSample) + " bits";
+    return false;
+  }
+
+  if (channels <= 0 || sampleRate <= 0 ||
+      frameBytes != channels * (bitsPerSample / 8)) {
+    error = "Invalid WAV format chunk";
+    return false;
+  }
+
+  frameCount = static_cast<int64_t>(dataSize / frameBytes);
+  if (frameCount == 0) {
+    error = "WAV file has no audio frames";
+    return false;
+  }
+  return true;
+}
+
+bool WavFile::decodeAll() {
+  // ADPCM blocks can't be decoded from an arbitrary frame, so SDL expands
+  // the whole file to 16-bit PCM up front and reads come from that instead
+  // of the mapping
+  SDL_IOStream* io = SDL_IOFromConstMem(data, size);
+  SDL_AudioSpec spec;
+  Uint32 length = 0;
+  if (!io || !SDL_LoadWAV_IO(io, true, &spec, &decoded, &length)) {
+    error = std::string("Couldn't decode ADPCM WAV: ") + SDL_GetError();
+    return false;
+  }
+  if (spec.format != SDL_AUDIO_S16 || spec.channels <= 0) {
+    error = "Unexpected format from the ADPCM decoder";
+    return false;
+  }
+
+  encoding = Encoding::S16;
+  samples = decoded;
+  sampleRate = spec.freq;
+  channels = spec.channels;
+  bitsPerSample = 16;
+  frameBytes = channels * 2;
+  frameCount = length / frameBytes;
+  if (frameCount == 0) {
+    error = "WAV file has no audio frames";
+    return false;
+  }
+  return true;
+}
+
+SDL_AudioSpec WavFile::getPlaybackSpec() const {
+  SDL_AudioSpec spec;
+  spec.freq = sampleRate;
+  spec.channels = channels;
+  switch (encoding) {
+    case Encoding::U8:
+      spec.format = SDL_AUDIO_U8;
+      break;
+    case Encoding::S16:
+    case Encoding::ALaw:
+    case Encoding::MuLaw:
+      spec.format = SDL_AUDIO_S16LE;
+      break;
+    case Encoding::S24:
+    case Encoding::S32:
+      spec.format = SDL_AUDIO_S32LE;
+      break;
+    case Encoding::F32:
+    case Encoding::F64:
+      spec.format = SDL_AUDIO_F32LE;
+      break;
+  }
+  return spec;
+}
+
+int64_t WavFile::readPlayback(int64_t frame, int64_t count, void* out) const {
+  if (!data || frame < 0 || frame >= frameCount) return 0;
+  count = std::min(count, frameCount - frame);
+
+  const Uint8* src = frameAt(frame);
+  const int64_t sampleCount = count * channels;
+  switch (encoding) {
+    case Encoding::S24: {
+      Sint32* dst = static_cast<Sint32*>(out);
+      for (int64_t i = 0; i < sampleCount; ++i) {
+        dst[i] = readS24(src + i * 3);
+      }
+      break;
+    }
+    case Encoding::F64: {
+      float* dst = static_cast<float*>(out);
+      for (int64_t i = 0; i < sampleCount; ++i) {
+        dst[i] = static_cast<float>(readSample<double>(src + i * 8));
+      }
+      break;
+    }
+    case Encoding::ALaw: {
+      Sint16* dst = static_cast<Sint16*>(out);
+      for (int64_t i = 0; i < sampleCount; ++i) dst[i] = decodeALaw(src[i]);
+      break;
+    }
+    case Encoding::MuLaw: {
+      Sint16* dst = static_cast<Sint16*>(out);
+      for (int64_t i = 0; i < sampleCount; ++i) dst[i] = decodeMuLaw(src[i]);
+      break;
+    }
+    default:
+      std::memcpy(out, src, static_cast<size_t>(count * frameBytes));
+      break;
+  }
+  return count;
+}
+
+template <typename Fn>
+void WavFile::withDecoder(Fn&& fn) const {
+  switch (encoding) {
+    case Encoding::U8:
+      fn([](const Uint8* p) { return (*p - 128) / 128.0f; });
+      break;
+    case Encoding::S16:
+      fn([](const Uint8* p) { return readSample<Sint16>(p) / 32768.0f; });
+      break;
+    case Encoding::S24:
+      fn([](const Uint8* p) { return readS24(p) / 2147483648.0f; });
+      break;
+    case Encoding::S32:
+      fn([](const Uint8* p) { return readSample<Sint32>(p) / 2147483648.0f; });
+      break;
+    case Encoding::F32:
+      fn([](const Uint8* p) { return readSample<float>(p); });
+      break;
+    case Encoding::F64:
+      fn([](const Uint8* p) {
+        return static_cast<float>(readSample<double>(p));
+      });
+      break;
+    case Encoding::ALaw:
+      fn([](const Uint8* p) { return decodeALaw(*p) / 32768.0f; });
+      break;
+    case Encoding::MuLaw:
+      fn([](const Uint8* p) { return decodeMuLaw(*p) / 32768.0f; });
+      break;
+  }
+}
+
+int64_t WavFile::readMono(int64_t frame, int64_t count, float* out) const {
+  if (!data || frame < 0 || frame >= frameCount) return 0;
+  count = std::min(count, frameCount - frame);
+
+  const Uint8* src = frameAt(frame);
+  const int sampleBytes = bitsPerSample / 8;
+  withDecoder([&](auto decode) {
+    downmix(src, count, channels, frameBytes, sampleBytes, out, decode);
+  });
+  return count;
+}
+
+int64_t WavFile::readStereo(int64_t frame, int64_t count, float* left,
+                            float* right) const {
+  if (!data || frame < 0 || frame >= frameCount) return 0;
+  count = std::min(count, frameCount - frame);
+
+  const Uint8* src = frameAt(frame);
+  const int sampleBytes = bitsPerSample / 8;
+  withDecoder([&](auto decode) {
+    splitStereo(src, count, channels, frameBytes, sampleBytes, left, right,
+                decode);
+  });
+  return count;
+}
+
+void WavFile::prefetch(int64_t frame, int64_t count) const {
+  // Decoded files are already in memory
+  if (!data || decoded || frame < 0 || frame >= frameCount) return;
+  count = std::min(count, frameCount - frame);
+
+#ifndef _WIN32
+  // madvise wants a page-aligned start
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(frameAt(frame));
+  uintptr_t end = begin + static_cast<uintptr_t>(count * frameBytes);
+  begin &= ~(pageSize - 1);
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
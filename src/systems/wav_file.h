@@ -0,0 +1,123 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Memory-mapped WAV file, decoded on demand
+ *
+ * Opening maps the file and parses the RIFF chunks; no sample data is read.
+ * Readers then decode just the frames they need straight from the mapping,
+ * so a file of any size opens in constant time and only the pages around
+ * the playback and analysis positions become resident.
+ *
+ * Handles PCM at 8, 16, 24 and 32 bits, 32- and 64-bit float and 8-bit
+ * A-law and mu-law, including WAVE_FORMAT_EXTENSIBLE headers and the extra
+ * chunks of broadcast WAVs. MS and IMA ADPCM can't be decoded from an
+ * arbitrary frame, so those files are expanded to 16-bit PCM in memory when
+ * opened. Anything else fails to open with the format in getError().
+ * Reads are safe from several threads at once; open() and close() are not.
+ */
+class WavFile {
+ public:
+  WavFile() = default;
+  ~WavFile();
+
+  WavFile(const WavFile&) = delete;
+  WavFile& operator=(const WavFile&) = delete;
+
+  /** @brief Map and parse `path`, replacing any open file. On failure the
+   * error is in getError() and the file is left closed. */
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return data != nullptr; }
+  const std::string& getError() const { return error; }
+
+  int getSampleRate() const { return sampleRate; }
+  int getChannels() const { return channels; }
+  int getBitsPerSample() const { return bitsPerSample; }
+  int64_t getFrameCount() const { return frameCount; }
+
+  /**
+   * @brief Format to play the frames back in
+   *
+   * The file's own format, except for the ones SDL can't take directly:
+   * 24-bit PCM plays as 32-bit, 64-bit float as 32-bit float, and A-law,
+   * mu-law and ADPCM as 16-bit.
+   */
+  SDL_AudioSpec getPlaybackSpec() const;
+
+  /**
+   * @brief Copy up to `count` frames from `frame` on in the playback format
+   *
+   * `out` needs room for `count` frames of getPlaybackSpec(). Returns the
+   * number of frames written, fewer at the end of the file.
+   */
+  int64_t readPlayback(int64_t frame, int64_t count, void* out) const;
+
+  /**
+   * @brief Decode up to `count` frames from `frame` on, downmixed to mono
+   * with full scale at +/-1. Float files pass through unclamped, so they
+   * can go past it. Returns the number of frames written.
+   */
+  int64_t readMono(int64_t frame, int64_t count, float* out) const;
+
+  /**
+   * @brief Decode up to `count` frames from `frame` on into separate left
+   * and right channels, scaled as in readMono()
+   *
+   * Mono files give the same samples on both sides. Channels after the
+   * first two are mixed equally into both sides, weighted so that the mean
+   * of left and right matches readMono(). Returns the frames written.
+   */
+  int64_t readStereo(int64_t frame, int64_t count, float* left,
+                     float* right) const;
+
+  /** @brief Ask the OS to start paging in a range ahead of its use */
+  void prefetch(int64_t frame, int64_t count) const;
+
+ private:
+  enum class Encoding { U8, S16, S24, S32, F32, F64, ALaw, MuLaw };
+
+  bool parse();
+
+  // Expand the whole file to 16-bit PCM through SDL, for encodings that
+  // can't be read frame by frame
+  bool decodeAll();
+
+  // Call fn with a functor that decodes one sample of the file's encoding
+  // to a normalized float
+  template <typename Fn>
+  void withDecoder(Fn&& fn) const;
+
+  const Uint8* frameAt(int64_t frame) const {
+    return samples + frame * frameBytes;
+  }
+
+  // The whole file, mapped read-only
+  const Uint8* data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#else
+  int fd = -1;
+#endif
+
+  // Start of the data chunk, or of `decoded` when the file was expanded
+  const Uint8* samples = nullptr;
+  Uint8* decoded = nullptr;
+
+  Encoding encoding = Encoding::S16;
+  int sampleRate = 0;
+  int channels = 0;
+  int bitsPerSample = 0;
+  int frameBytes = 0;
+  int64_t frameCount = 0;
+
+  std::string error;
+};
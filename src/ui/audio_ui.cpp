@@ -14,6 +14,7 @@ AudioUI::AudioUI()
       showVisualization(true),
       showFrequencyBands(true),
       showBeatDetection(true),
+      selectedRecordingDevice(-1),
       selectedFFTSize(2048),
       visualizationScale(1.0f),
       autoScale(true) {
@@ -27,6 +28,8 @@ void AudioUI::render() {
 
   ImGui::Begin("Audio System", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
 
+  renderInputControls();
+  ImGui::Separator();
   renderFileControls();
   ImGui::Separator();
   renderPlaybackControls();
@@ -55,6 +58,69 @@ void AudioUI::render() {
   }
 }
 
+void AudioUI::renderInputControls() {
+  ImGui::Text("Input");
+
+  const AudioInput inputs[] = {AudioInput::File, AudioInput::Recording,
+                               AudioInput::Generator};
+  AudioInput current = audioSystem->getInput();
+  if (ImGui::BeginCombo("Source", getAudioInputName(current))) {
+    for (AudioInput input : inputs) {
+      if (ImGui::Selectable(getAudioInputName(input), input == current)) {
+        const std::string& device =
+            selectedRecordingDevice < 0
+                ? std::string()
+                : recordingDevices[selectedRecordingDevice];
+        audioSystem->setInput(input, device);
+      }
+    }
+    ImGui::EndCombo();
+  }
+
+  // Devices are listed afresh each time the list is opened
+  const char* deviceLabel =
+      selectedRecordingDevice < 0
+          ? "Default"
+          : recordingDevices[selectedRecordingDevice].c_str();
+  if (ImGui::BeginCombo("Recording Device", deviceLabel)) {
+    recordingDevices = RecordingSource::getDeviceNames();
+    if (selectedRecordingDevice >= static_cast<int>(recordingDevices.size())) {
+      selectedRecordingDevice = -1;
+    }
+
+    int choice = -2;
+    if (ImGui::Selectable("Default", selectedRecordingDevice < 0)) {
+      choice = -1;
+    }
+    for (int i = 0; i < static_cast<int>(recordingDevices.size()); ++i) {
+      if (ImGui::Selectable(recordingDevices[i].c_str(),
+                            i == selectedRecordingDevice)) {
+        choice = i;
+      }
+    }
+    ImGui::EndCombo();
+
+    if (choice != -2) {
+      selectedRecordingDevice = choice;
+      if (current == AudioInput::Recording) {
+        audioSystem->setInput(AudioInput::Recording,
+                              choice < 0 ? std::string()
+                                         : recordingDevices[choice]);
+      }
+    }
+  }
+
+  if (!audioSystem->getInputError().empty()) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s",
+                       audioSystem->getInputError().c_str());
+  } else if (audioSystem->getInput() != AudioInput::File) {
+    ImGui::Text("Capturing at %d Hz, %llu frames dropped",
+                audioSystem->getCaptureSampleRate(),
+                static_cast<unsigned long long>(
+                    audioSystem->getDroppedCaptureFrames()));
+  }
+}
+
 void AudioUI::renderFileControls() {
   ImGui::Text("File Controls");
 
@@ -79,6 +145,11 @@ void AudioUI::renderFileControls() {
 void AudioUI::renderPlaybackControls() {
   ImGui::Text("Playback Controls");
 
+  if (audioSystem->getInput() != AudioInput::File) {
+    ImGui::Text("Listening to live input");
+    return;
+  }
+
   const auto& audioData = audioSystem->getAudioData();
   if (!audioData.loaded) {
     ImGui::Text("No audio loaded");
@@ -87,7 +158,7 @@ void AudioUI::renderPlaybackControls() {
 
   // Play/Pause button
   if (audioSystem->isPlaying()) {
-    if (ImGui::Button("Pause")) {
+    if (ImGui::Button(audioSystem->isPaused() ? "Resume" : "Pause")) {
       audioSystem->pausePlayback();
     }
   } else {
@@ -113,10 +184,36 @@ void AudioUI::renderPlaybackControls() {
       (duration > 0) ? static_cast<float>(position / duration) : 0.0f;
   ImGui::ProgressBar(progress, ImVec2(-1, 0));
 
-  // Time slider
-  static float sliderPos = 0.0f;
-  if (ImGui::SliderFloat("Seek", &sliderPos, 0.0f, 1.0f, "%.3f")) {
-    // Note: We'd need to add a seek method to AudioSystem
+  // Shifts the playback clock the visualization follows
+  float latencyMs = static_cast<float>(audioSystem->getOutputLatencyMs());
+  if (ImGui::SliderFloat("Output Latency", &latencyMs, 0.0f, 200.0f,
+                         "%.0f ms")) {
+    audioSystem->setOutputLatencyMs(latencyMs);
+  }
+
+  // Time slider; dragging it seeks
+  float seekPos = progress;
+  if (ImGui::SliderFloat("Seek", &seekPos, 0.0f, 1.0f, "%.3f")) {
+    audioSystem->seek(seekPos * duration);
+  }
+
+  bool looping = audioSystem->isLooping();
+  if (ImGui::Checkbox("Loop", &looping)) {
+    audioSystem->setLooping(looping);
+  }
+
+  if (looping) {
+    float loopStart = static_cast<float>(audioSystem->getLoopStart());
+    float loopEnd = static_cast<float>(audioSystem->getLoopEnd());
+    if (ImGui::DragFloatRange2("Loop Region", &loopStart, &loopEnd, 0.1f,
+                               0.0f, static_cast<float>(duration),
+                               "%.2f s")) {
+      audioSystem->setLoopRegion(loopStart, loopEnd);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Whole File")) {
+      audioSystem->clearLoopRegion();
+    }
   }
 }
 
@@ -187,6 +284,48 @@ void AudioUI::renderVisualizationSettings() {
     audioSystem->setFFTSize(selectedFFTSize);
   }
 
+  // Analysis hop selection; sets the analysis rate independently of the FPS
+  const int hopSizes[] = {256, 512, 1024, 2048};
+  const char* hopLabels[] = {"256", "512", "1024", "2048"};
+  int currentHopIndex = 1;
+  for (int i = 0; i < IM_ARRAYSIZE(hopSizes); ++i) {
+    if (hopSizes[i] == audioSystem->getAnalysisHopSize()) {
+      currentHopIndex = i;
+    }
+  }
+
+  if (ImGui::Combo("Analysis Hop", &currentHopIndex, hopLabels,
+                   IM_ARRAYSIZE(hopLabels))) {
+    audioSystem->setAnalysisHopSize(hopSizes[currentHopIndex]);
+  }
+  ImGui::Text("Analysis: %.1f Hz, %.3f ms", audioSystem->getAnalysisRate(),
+              audioSystem->getLastAnalysisMs());
+  ImGui::Text("Spectral Kernel: %s", SpectralAnalyzer::getKernelName(
+                                         audioSystem->getSpectralKernel()));
+
+  // Filterbank shape, for the spectrum bars and audio-driven animation
+  const int bandCounts[] = {16, 32, 64, 128, 256};
+  const char* bandLabels[] = {"16", "32", "64", "128", "256"};
+  int currentBandIndex = 2;
+  for (int i = 0; i < IM_ARRAYSIZE(bandCounts); ++i) {
+    if (bandCounts[i] == audioSystem->getFilterbankBandCount()) {
+      currentBandIndex = i;
+    }
+  }
+  int currentScaleIndex =
+      audioSystem->getFilterbankScale() == FilterbankScale::Mel ? 1 : 0;
+  const char* scaleLabels[] = {"Log", "Mel"};
+
+  bool bandsChanged = ImGui::Combo("Filterbank Bands", &currentBandIndex,
+                                   bandLabels, IM_ARRAYSIZE(bandLabels));
+  bool scaleChanged = ImGui::Combo("Filterbank Scale", &currentScaleIndex,
+                                   scaleLabels, IM_ARRAYSIZE(scaleLabels));
+  if (bandsChanged || scaleChanged) {
+    audioSystem->setFilterbank(
+        bandCounts[currentBandIndex],
+        currentScaleIndex == 1 ? FilterbankScale::Mel : FilterbankScale::Log);
+  }
+
   ImGui::SliderFloat("Visualization Scale", &visualizationScale, 0.1f, 5.0f,
                      "%.2f");
   ImGui::Checkbox("Auto Scale", &autoScale);
@@ -223,6 +362,19 @@ void AudioUI::renderFrequencyBands() {
   ImGui::Text("High Mid: %.3f", vizData.highMidLevel);
   ImGui::SameLine();
   ImGui::Text("Treble: %.3f", vizData.trebleLevel);
+
+  // Stereo image
+  ImGui::Text("Left / Right Bands:");
+  for (size_t i = 0; i < vizData.leftBandLevels.size(); ++i) {
+    ImGui::Text("%.2f / %.2f", vizData.leftBandLevels[i],
+                vizData.rightBandLevels[i]);
+    if (i + 1 < vizData.leftBandLevels.size()) ImGui::SameLine();
+  }
+  ImGui::Text("Correlation: %.2f", vizData.stereoCorrelation);
+  ImGui::SameLine();
+  ImGui::Text("Width: %.2f", vizData.stereoWidth);
+
+  drawSpectrum(vizData.getFilterbankLevels());
 }
 
 void AudioUI::renderBeatDetection() {
@@ -230,6 +382,30 @@ void AudioUI::renderBeatDetection() {
 
   const auto& vizData = audioSystem->getVisualizationData();
 
+  // Whole-track analysis, built once in the background and then read back
+  // by position
+  if (audioSystem->isBuildingAnalysisCache()) {
+    ImGui::ProgressBar(audioSystem->getAnalysisCacheProgress(),
+                       ImVec2(0.0f, 0.0f), "Analyzing...");
+  } else if (ImGui::Button("Analyze Track")) {
+    audioSystem->buildAnalysisCache();
+  }
+  if (audioSystem->hasAnalysisCache()) {
+    ImGui::SameLine();
+    bool useCache = audioSystem->isUsingAnalysisCache();
+    if (ImGui::Checkbox("Use Cached Analysis", &useCache)) {
+      audioSystem->setUseAnalysisCache(useCache);
+    }
+
+    const AnalysisCache& cache = audioSystem->getAnalysisCache();
+    ImGui::Text("Cached: %zu beats, %.1f BPM", cache.beats.size(),
+                cache.tempo);
+    double nextBeat = audioSystem->getNextBeatTime();
+    if (nextBeat >= 0.0) {
+      ImGui::Text("Next Beat: %s", formatTime(nextBeat).c_str());
+    }
+  }
+
   // Beat indicator
   ImGui::Text("Beat Detected: %s", vizData.isBeat ? "YES" : "NO");
 
@@ -237,6 +413,15 @@ void AudioUI::renderBeatDetection() {
   ImGui::Text("Beat Intensity:");
   ImGui::ProgressBar(static_cast<float>(vizData.beatIntensity), ImVec2(-1, 0));
 
+  // Tempo tracking; the phase bar fills up to each predicted beat
+  ImGui::Text("Tempo: %.1f BPM (confidence %.2f)", vizData.tempoEstimate,
+              vizData.tempoConfidence);
+  if (vizData.secondsToNextBeat >= 0.0) {
+    ImGui::Text("Next Predicted Beat: %.2f s", vizData.secondsToNextBeat);
+  }
+  ImGui::ProgressBar(static_cast<float>(vizData.beatPhase), ImVec2(-1, 0),
+                     "Beat Phase");
+
   // Energy levels
   ImGui::Text("RMS Energy: %.3f", vizData.rmsEnergy);
   ImGui::Text("Current Peak: %.3f", vizData.currentPeak);
@@ -246,38 +431,22 @@ void AudioUI::renderBeatDetection() {
   ImGui::Text("Spectral Centroid: %.1f Hz", vizData.spectralCentroid);
   ImGui::Text("Spectral Rolloff: %.1f Hz", vizData.spectralRolloff);
 
-  // Peak history visualization
+  // Peak history visualization, plotted straight from the ring buffer
   if (!vizData.peakHistory.empty()) {
     ImGui::Text("Peak History:");
-    ImGui::PlotLines(
-        "##PeakHistory",
-        [](void* data, int idx) -> float {
-          auto* history = static_cast<std::deque<double>*>(data);
-          if (idx < static_cast<int>(history->size())) {
-            return static_cast<float>((*history)[idx]);
-          }
-          return 0.0f;
-        },
-        const_cast<std::deque<double>*>(&vizData.peakHistory),
-        static_cast<int>(vizData.peakHistory.size()), 0, nullptr, 0.0f, 1.0f,
-        ImVec2(200, 50));
+    ImGui::PlotLines("##PeakHistory", vizData.peakHistory.data(),
+                     static_cast<int>(vizData.peakHistory.size()),
+                     static_cast<int>(vizData.peakHistory.getOffset()),
+                     nullptr, 0.0f, 1.0f, ImVec2(200, 50));
   }
 
   // Energy history visualization
   if (!vizData.energyHistory.empty()) {
     ImGui::Text("Energy History:");
-    ImGui::PlotLines(
-        "##EnergyHistory",
-        [](void* data, int idx) -> float {
-          auto* history = static_cast<std::deque<double>*>(data);
-          if (idx < static_cast<int>(history->size())) {
-            return static_cast<float>((*history)[idx]);
-          }
-          return 0.0f;
-        },
-        const_cast<std::deque<double>*>(&vizData.energyHistory),
-        static_cast<int>(vizData.energyHistory.size()), 0, nullptr, 0.0f, 1.0f,
-        ImVec2(200, 50));
+    ImGui::PlotLines("##EnergyHistory", vizData.energyHistory.data(),
+                     static_cast<int>(vizData.energyHistory.size()),
+                     static_cast<int>(vizData.energyHistory.getOffset()),
+                     nullptr, 0.0f, 1.0f, ImVec2(200, 50));
   }
 }
 
@@ -323,47 +492,35 @@ std::string AudioUI::formatTime(double seconds) const {
   return oss.str();
 }
 
-void AudioUI::drawSpectrum(const std::vector<double>& magnitudes,
-                           const std::vector<double>& frequencies) {
-  if (magnitudes.empty()) return;
+void AudioUI::drawSpectrum(std::span<const float> levels) {
+  if (levels.empty()) return;
 
   ImGui::Text("Frequency Spectrum");
 
-  // Find max magnitude for scaling
-  double maxMagnitude = 0.0;
-  for (const auto& mag : magnitudes) {
-    maxMagnitude = std::max(maxMagnitude, mag);
-  }
-
-  if (maxMagnitude <= 0.0) return;
-
-  // Draw spectrum as bars
+  // Draw spectrum as bars, one per filterbank band
   ImGui::BeginChild("##Spectrum", ImVec2(400, 100), true);
 
   ImDrawList* drawList = ImGui::GetWindowDrawList();
   ImVec2 canvasPos = ImGui::GetCursorScreenPos();
   ImVec2 canvasSize = ImGui::GetContentRegionAvail();
 
-  float barWidth = canvasSize.x / magnitudes.size();
+  float barWidth = canvasSize.x / levels.size();
   float scale = autoScale ? 1.0f : visualizationScale;
 
-  for (size_t i = 0; i < magnitudes.size(); ++i) {
-    float height =
-        static_cast<float>(magnitudes[i] / maxMagnitude) * canvasSize.y * scale;
-    height = std::min(height, canvasSize.y);
+  for (size_t i = 0; i < levels.size(); ++i) {
+    float height = std::min(levels[i] * canvasSize.y * scale, canvasSize.y);
 
     ImVec2 barMin(canvasPos.x + i * barWidth,
                   canvasPos.y + canvasSize.y - height);
     ImVec2 barMax(canvasPos.x + (i + 1) * barWidth, canvasPos.y + canvasSize.y);
 
-    // Color based on frequency
-    ImU32 color = IM_COL32(255, 255, 255, 255);
-    if (frequencies[i] < 250) {
+    // Color by position; bands are log or mel spaced, so thirds are
+    // roughly bass, mids and treble
+    ImU32 color = IM_COL32(0, 0, 255, 255);  // Blue for treble
+    if (i * 3 < levels.size()) {
       color = IM_COL32(255, 0, 0, 255);  // Red for bass
-    } else if (frequencies[i] < 2000) {
+    } else if (i * 3 < levels.size() * 2) {
       color = IM_COL32(0, 255, 0, 255);  // Green for mid
-    } else {
-      color = IM_COL32(0, 0, 255, 255);  // Blue for treble
     }
 
     drawList->AddRectFilled(barMin, barMax, color);
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "../systems/audio_system.h"
 
@@ -31,12 +33,18 @@ class AudioUI {
   bool showFrequencyBands;
   bool showBeatDetection;
 
+  // Recording devices as of the last time the list was opened; -1 selects
+  // the default device
+  std::vector<std::string> recordingDevices;
+  int selectedRecordingDevice;
+
   // Visualization settings
   int selectedFFTSize;
   float visualizationScale;
   bool autoScale;
 
   // Helper functions
+  void renderInputControls();
   void renderFileControls();
   void renderPlaybackControls();
   void renderVisualizationSettings();
@@ -48,9 +56,8 @@ class AudioUI {
   // Format time for display
   std::string formatTime(double seconds) const;
 
-  // Draw frequency spectrum
-  void drawSpectrum(const std::vector<double>& magnitudes,
-                    const std::vector<double>& frequencies);
+  // Draw filterbank levels as bars, lowest band on the left
+  void drawSpectrum(std::span<const float> levels);
 
   // Draw waveform
   void drawWaveform(const std::vector<float>& samples, size_t startSample,
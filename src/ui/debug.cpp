@@ -1,13 +1,17 @@
 #include "debug.h"
 
+#include <algorithm>
+
 #include "SDL3/SDL_rect.h"
 #include "entities/circle.h"
 #include "entities/isometric_cube/isometric_cube.h"
 #include "entities/line.h"
 #include "entities/waypoint.h"
+#include "event_loop.h"
 #include "imgui.h"
 #include "systems/animation_system.h"
 #include "systems/input_system.h"
+#include "systems/job_system.h"
 
 void DebugUI::renderDebugFrameControls() {
   ImGui::Checkbox("Debug Frames", &this->debugFrames);
@@ -27,6 +31,50 @@ void DebugUI::renderDebugFramerateInformation() {
   ImGui::SeparatorText("Entity System");
   ImGui::Text("Entity Count: %zu",
               getAppState()->entityManager.getEntityCount());
+  ImGui::Text("Archetype Entity Count: %zu",
+              getAppState()->entityManager.getArchetypeEntityCount());
+  ImGui::Text("Entity Update: %.3f ms",
+              getUI()->getEventLoop()->getEntityUpdateMs());
+  ImGui::Text("Entity Render: %.3f ms",
+              getUI()->getEventLoop()->getEntityRenderMs());
+
+  const auto& orderStats = getAppState()->entityManager.getRenderOrderStats();
+  ImGui::Text("Z-Order Re-sorts: %zu (%zu incremental, %zu full)",
+              orderStats.resorts, orderStats.incrementalSorts,
+              orderStats.fullSorts);
+  ImGui::Text("Z-Order Changes/Spawns: %zu", orderStats.zOrderChanges);
+
+  const TweenSystem& tweens = getAppState()->animationSystem->getTweens();
+  ImGui::Text("Tweens: %zu groups, %zu tracks", tweens.getGroupCount(),
+              tweens.getTrackCount());
+
+  EntityManager& entityManager = getAppState()->entityManager;
+  if (JobSystem* jobSystem = entityManager.getJobSystem()) {
+    bool parallel = entityManager.isParallelUpdateEnabled();
+    if (ImGui::Checkbox("Parallel Update", &parallel)) {
+      entityManager.setParallelUpdateEnabled(parallel);
+    }
+    JobSystem::Stats jobStats = jobSystem->getStats();
+    ImGui::Text("Job Threads: %zu, Chunks: %zu, Steals: %zu",
+                jobSystem->getThreadCount(), jobStats.chunks,
+                jobStats.steals);
+  }
+
+  bool culling = entityManager.isCullingEnabled();
+  if (ImGui::Checkbox("View Culling", &culling)) {
+    entityManager.setCullingEnabled(culling);
+  }
+  ImGui::Text("Drawn: %zu, Culled: %zu", entityManager.getCullStats().drawn,
+              entityManager.getCullStats().culled);
+
+  const auto& batchStats = entityManager.getBatchStats();
+  ImGui::Text("Draw Calls: %zu (%zu vertices)", batchStats.drawCalls,
+              batchStats.vertices);
+
+  if (debugFrames && debugFramesText) {
+    ImGui::Text("Text Draw Calls: %zu",
+                getAppState()->renderer.getTextStats().drawCalls);
+  }
 }
 
 void DebugUI::renderInputStates() {
@@ -36,11 +84,13 @@ void DebugUI::renderInputStates() {
                                         : ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
   ImGui::TextColored(
       draggingColor, "Dragged Entity: %s",
-      draggingEntity ? draggedEntity->getUUID().c_str() : "None");
+      draggedEntity ? draggedEntity->getUUID().c_str() : "None");
 
   ImGui::Text("Mouse Position: (%.1f, %.1f)",
               getAppState()->inputSystem->getMousePosition().x,
               getAppState()->inputSystem->getMousePosition().y);
+  ImGui::Text("Last Pick: %.2f us",
+              getAppState()->inputSystem->getLastPickMicros());
 
   // Show key states
   ImGui::Spacing();
@@ -54,14 +104,16 @@ void DebugUI::renderEntityCreation() {
   ImGui::Spacing();
   ImGui::SeparatorText("Entity Creation");
 
+  EntityManager& entityManager = getAppState()->entityManager;
+
   if (ImGui::Button("Add Random Line")) {
     int windowWidth, windowHeight;
     SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
                       &windowHeight);
 
-    auto* line = getAppState()->entityManager.createEntity<LineEntity>(
+    auto* line = entityManager.get(entityManager.createEntity<LineEntity>(
         SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight},
-        SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight});
+        SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight}));
 
     LineEntity::GradientProperties gradientProps;
     gradientProps.enabled = true;
@@ -79,9 +131,9 @@ void DebugUI::renderEntityCreation() {
     SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
                       &windowHeight);
 
-    auto* circle = getAppState()->entityManager.createEntity<CircleEntity>(
+    auto* circle = entityManager.get(entityManager.createEntity<CircleEntity>(
         SDL_FPoint{SDL_randf() * windowWidth, SDL_randf() * windowHeight},
-        SDL_randf() * 50.0f + 10.0f);
+        SDL_randf() * 50.0f + 10.0f));
     circle->setColor({static_cast<Uint8>(SDL_randf() * 255),
                       static_cast<Uint8>(SDL_randf() * 255),
                       static_cast<Uint8>(SDL_randf() * 255), 128});
@@ -99,8 +151,8 @@ void DebugUI::renderEntityCreation() {
     SDL_FPoint start = {center.x - 80.0f, center.y};
     SDL_FPoint end = {center.x + 80.0f, center.y};
 
-    auto* line =
-        getAppState()->entityManager.createEntity<LineEntity>(start, end);
+    auto lineHandle = entityManager.createEntity<LineEntity>(start, end);
+    auto* line = entityManager.get(lineHandle);
     line->setThickness(5.0f);
     line->setColor({255, 255, 255, 255});  // Start with white
 
@@ -116,14 +168,15 @@ void DebugUI::renderEntityCreation() {
     };
 
     auto gradientAnim =
-        std::make_shared<GradientAnimation>(10.0f,  // 10 second duration
-                                            line,   // Target entity
+        std::make_shared<GradientAnimation>(10.0f,       // 10 second duration
+                                            lineHandle,  // Target entity
                                             gradientColors);
     gradientAnim->setLooping(true);                  // Loop forever
     gradientAnim->setColorTransitionDuration(1.5f);  // 1.5 seconds per color
 
-    // Add animation to the line
-    line->addAnimation(gradientAnim);
+    // Run it in the animation system, writing the line's animated color
+    getAppState()->animationSystem->addAnimation(
+        gradientAnim, bindProperty<&LineEntity::setAnimatedColor>(lineHandle));
   }
 
   if (ImGui::Button("Create Non-Draggable Circle")) {
@@ -131,8 +184,8 @@ void DebugUI::renderEntityCreation() {
     SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
                       &windowHeight);
 
-    auto* circle = getAppState()->entityManager.createEntity<CircleEntity>(
-        SDL_FPoint{windowWidth / 2.0f + 100.0f, windowHeight / 2.0f}, 25.0f);
+    auto* circle = entityManager.get(entityManager.createEntity<CircleEntity>(
+        SDL_FPoint{windowWidth / 2.0f + 100.0f, windowHeight / 2.0f}, 25.0f));
     circle->setColor({128, 128, 128, 255});  // Gray
     circle->setFilled(true);
     circle->setDraggable(false);
@@ -143,8 +196,8 @@ void DebugUI::renderEntityCreation() {
     SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
                       &windowHeight);
 
-    auto* waypoint = getAppState()->entityManager.createEntity<WaypointEntity>(
-        getAppState());
+    auto* waypoint = entityManager.get(
+        entityManager.createEntity<WaypointEntity>(getAppState()));
     waypoint->setInitialPosition(windowWidth / 2.0f, windowHeight / 2.0f);
   }
 
@@ -154,9 +207,8 @@ void DebugUI::renderEntityCreation() {
                       &windowHeight);
 
     for (int i = 0; i < 100; i++) {
-      auto* waypoint =
-          getAppState()->entityManager.createEntity<WaypointEntity>(
-              getAppState());
+      auto* waypoint = entityManager.get(
+          entityManager.createEntity<WaypointEntity>(getAppState()));
       waypoint->setInitialPosition(windowWidth / 2.0f, windowHeight / 2.0f);
     }
   }
@@ -166,8 +218,8 @@ void DebugUI::renderEntityCreation() {
     SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
                       &windowHeight);
 
-    auto cube = getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-        getAppState());
+    auto* cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     cube->setPosition(SDL_FPoint{windowWidth / 2.0f, windowHeight / 2.0f});
   }
 
@@ -185,17 +237,15 @@ void DebugUI::renderEntityCreation() {
     // int side = 64;
 
     for (int r = 0; r < side; r++) {
-      auto* first =
-          getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-              getAppState());
+      auto* first = entityManager.get(
+          entityManager.createEntity<IsometricCubeEntity>(getAppState()));
       first->setTime(r * 75.0f);
       first->setPosition(rowStart);
 
       SDL_FPoint colPos = first->getBehindLeft();
       for (int c = 1; c < side; c++) {
-        auto* cube =
-            getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-                getAppState());
+        auto* cube = entityManager.get(
+            entityManager.createEntity<IsometricCubeEntity>(getAppState()));
         cube->setTime((r + c) * 75.0f);
         cube->setPosition(colPos);
         colPos = cube->getBehindLeft();
@@ -213,30 +263,134 @@ void DebugUI::renderEntityCreation() {
     SDL_FPoint center = {windowWidth / 2.0f, windowHeight / 2.0f};
 
     // Center
-    auto center_cube =
-        getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-            getAppState());
+    auto* center_cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     center_cube->setPosition(center);
 
     // Left behind
-    auto cube = getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-        getAppState());
+    auto* cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     cube->setPosition(center_cube->getBehindLeft());
     // Right behind
-    cube = getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-        getAppState());
+    cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     cube->setPosition(center_cube->getBehindRight());
     // Left Front
-    cube = getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-        getAppState());
+    cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     cube->setPosition(center_cube->getFrontLeft());
     // Right Front
-    cube = getAppState()->entityManager.createEntity<IsometricCubeEntity>(
-        getAppState());
+    cube = entityManager.get(
+        entityManager.createEntity<IsometricCubeEntity>(getAppState()));
     cube->setPosition(center_cube->getFrontRight());
   }
 }
 
+void DebugUI::renderStorageComparison() {
+  ImGui::Spacing();
+  ImGui::SeparatorText("Storage Comparison");
+
+  ImGui::InputInt("Waypoint Count", &this->storageSpawnCount, 1000, 10000);
+  this->storageSpawnCount = std::max(this->storageSpawnCount, 0);
+
+  int windowWidth, windowHeight;
+  SDL_GetWindowSize(getAppState()->context->window, &windowWidth,
+                    &windowHeight);
+  SDL_FPoint center = {windowWidth / 2.0f, windowHeight / 2.0f};
+
+  EntityManager& entityManager = getAppState()->entityManager;
+
+  if (ImGui::Button("Spawn Waypoints (Entities)")) {
+    for (int i = 0; i < this->storageSpawnCount; i++) {
+      auto* waypoint = entityManager.get(
+          entityManager.createEntity<WaypointEntity>(getAppState()));
+      waypoint->setInitialPosition(center.x, center.y);
+    }
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Spawn Waypoints (Archetype)")) {
+    auto& waypoints = entityManager.getWaypoints();
+    waypoints.reserve(waypoints.size() + this->storageSpawnCount);
+    for (int i = 0; i < this->storageSpawnCount; i++) {
+      waypoints.spawn(center.x, center.y);
+    }
+  }
+
+  ImGui::InputInt("Grid Side", &this->storageGridSide, 8, 64);
+  this->storageGridSide = std::max(this->storageGridSide, 1);
+
+  if (ImGui::Button("Spawn Grid Wave (Archetype)")) {
+    entityManager.getCubes().spawnGrid(center, this->storageGridSide);
+  }
+}
+
+void DebugUI::renderAudioBindings() {
+  ImGui::Spacing();
+  ImGui::SeparatorText("Visualize on Rhythm");
+
+  AudioBindingSystem& bindings = *getAppState()->audioBindingSystem;
+
+  // Each checkbox adds its binding when ticked and removes it when cleared
+  auto toggle = [&](const char* label, AudioBindingSystem::BindingId& id,
+                    auto makeBinding) {
+    bool enabled = id != 0;
+    if (!ImGui::Checkbox(label, &enabled)) return;
+    if (enabled) {
+      id = bindings.addBinding(makeBinding());
+    } else {
+      bindings.removeBinding(id);
+      id = 0;
+    }
+  };
+
+  toggle("Cube wave follows bass", this->cubeWaveBinding, [] {
+    AudioBinding binding;
+    binding.feature = AudioFeature::Bass;
+    binding.target = BindingTarget::CubeWaveAmplitude;
+    binding.envelope = {0.05f, 0.02f, 0.3f};
+    binding.low = 5.0f;
+    binding.high = 60.0f;
+    return binding;
+  });
+
+  toggle("Cube color follows filterbank", this->cubeColorBinding, [] {
+    AudioBinding binding;
+    binding.feature = AudioFeature::Filterbank;
+    binding.target = BindingTarget::CubeColor;
+    binding.envelope = {0.0f, 0.01f, 0.2f};
+    binding.lowColor = {0.15f, 0.2f, 0.4f, 1.0f};
+    binding.highColor = {1.0f, 0.6f, 0.2f, 1.0f};
+    return binding;
+  });
+
+  toggle("Waypoints flash on beats", this->waypointColorBinding, [] {
+    AudioBinding binding;
+    binding.feature = AudioFeature::Beat;
+    binding.target = BindingTarget::WaypointColor;
+    binding.envelope = {0.0f, 0.0f, 0.25f};
+    binding.lowColor = {0.4f, 0.4f, 0.4f, 1.0f};
+    binding.highColor = {1.0f, 1.0f, 1.0f, 1.0f};
+    return binding;
+  });
+
+  // Binds the lines that exist when ticked
+  toggle("Line color follows beat intensity", this->lineColorBinding, [&] {
+    AudioBinding binding;
+    binding.feature = AudioFeature::BeatIntensity;
+    binding.target = BindingTarget::LineColor;
+    binding.envelope = {0.0f, 0.01f, 0.2f};
+    binding.lowColor = {0.2f, 0.2f, 1.0f, 1.0f};
+    binding.highColor = {1.0f, 0.2f, 0.4f, 1.0f};
+    for (LineEntity* line :
+         getAppState()->entityManager.getEntitiesOfType<LineEntity>()) {
+      binding.lines.emplace_back(line->getHandle());
+    }
+    return binding;
+  });
+
+  ImGui::Text("Bound Parameters: %zu", bindings.getLastBoundCount());
+}
+
 void DebugUI::renderEntityManagement() {
   if (ImGui::Button("Clear All Entities")) {
     getAppState()->entityManager.clear();
@@ -253,6 +407,8 @@ void DebugUI::render() {
   this->renderDebugFramerateInformation();
   this->renderInputStates();
   this->renderEntityCreation();
+  this->renderStorageComparison();
+  this->renderAudioBindings();
   this->renderEntityManagement();
 
   ImGui::End();
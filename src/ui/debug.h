@@ -6,6 +6,7 @@
 #include <spdlog/spdlog.h>
 
 #include "core/app_state.h"
+#include "systems/audio_binding_system.h"
 #include "ui/ui_component.h"
 
 class DebugUI : public UIComponent {
@@ -15,10 +16,22 @@ class DebugUI : public UIComponent {
   bool debugFrames = false;
   bool debugFramesText = false;
 
+  // Storage comparison controls
+  int storageSpawnCount = 100000;
+  int storageGridSide = 64;
+
+  // Audio bindings switched on from the panel, 0 while off
+  AudioBindingSystem::BindingId cubeWaveBinding = 0;
+  AudioBindingSystem::BindingId cubeColorBinding = 0;
+  AudioBindingSystem::BindingId waypointColorBinding = 0;
+  AudioBindingSystem::BindingId lineColorBinding = 0;
+
   void renderDebugFrameControls();
   void renderDebugFramerateInformation();
   void renderInputStates();
   void renderEntityCreation();
+  void renderStorageComparison();
+  void renderAudioBindings();
   void renderEntityManagement();
 
  public:
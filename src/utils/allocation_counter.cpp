@@ -0,0 +1,64 @@
+#include "allocation_counter.h"
+
+#include <SDL3/SDL.h>
+
+#include <cstdlib>
+#include <new>
+
+#ifndef SDL_ANIMATIONS_BENCH
+#error "allocation_counter.cpp is only built with SDL_ANIMATIONS_BENCH"
+#endif
+
+// Replacing the scalar forms is enough: the default array and nothrow forms
+// forward to them.
+
+namespace {
+
+thread_local uint64_t threadAllocations = 0;
+
+[[noreturn]] void failAllocation() { throw std::bad_alloc(); }
+
+}  // namespace
+
+uint64_t getThreadAllocationCount() { return threadAllocations; }
+
+void* operator new(std::size_t size) {
+  ++threadAllocations;
+  if (size == 0) size = 1;
+
+  while (true) {
+    if (void* memory = std::malloc(size)) return memory;
+
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) failAllocation();
+    handler();
+  }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  ++threadAllocations;
+  if (size == 0) size = 1;
+
+  while (true) {
+    if (void* memory =
+            SDL_aligned_alloc(static_cast<size_t>(alignment), size)) {
+      return memory;
+    }
+
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) failAllocation();
+    handler();
+  }
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  SDL_aligned_free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+  SDL_aligned_free(memory);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// allocation_counter.cpp replaces the global operator new to count calls, so
+// it is only built with the SDL_ANIMATIONS_BENCH CMake option. Without it
+// nothing is counted and the count stays 0.
+#ifdef SDL_ANIMATIONS_BENCH
+inline constexpr bool ALLOCATION_COUNTING = true;
+
+// Number of heap allocations (global operator new calls) made so far on the
+// calling thread. Take the difference around a block of code to check that
+// it doesn't allocate.
+uint64_t getThreadAllocationCount();
+#else
+inline constexpr bool ALLOCATION_COUNTING = false;
+
+inline uint64_t getThreadAllocationCount() { return 0; }
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Fixed-capacity ring buffer of the most recent values, with their mean and
+// variance kept up to date as values come and go.
+//
+// Storage is inline and contiguous, so copying one never allocates, and it
+// can be handed to APIs that take a pointer and a starting offset, such as
+// ImGui::PlotLines. The statistics use Welford's update, extended to
+// replace the oldest value once full; they are recomputed from scratch once
+// per trip around the buffer so rounding error can't build up.
+template <typename T, size_t Capacity>
+class RingBuffer {
+  static_assert(Capacity > 0);
+
+ public:
+  void push(T value) {
+    const double x = static_cast<double>(value);
+    if (count < Capacity) {
+      storage[count++] = value;
+      double delta = x - mean;
+      mean += delta / count;
+      m2 += delta * (x - mean);
+      return;
+    }
+
+    const double old = static_cast<double>(storage[oldest]);
+    storage[oldest] = value;
+    oldest = (oldest + 1) % Capacity;
+
+    if (oldest == 0) {
+      recompute();
+      return;
+    }
+    double newMean = mean + (x - old) / Capacity;
+    m2 += (x - old) * (x - newMean + old - mean);
+    mean = newMean;
+  }
+
+  void clear() {
+    count = 0;
+    oldest = 0;
+    mean = 0.0;
+    m2 = 0.0;
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == Capacity; }
+  static constexpr size_t capacity() { return Capacity; }
+
+  // Oldest first
+  T operator[](size_t i) const { return storage[(oldest + i) % Capacity]; }
+  T back() const { return (*this)[count - 1]; }
+
+  // The raw storage, with the oldest value at getOffset() and the rest
+  // following it, wrapping around at size()
+  const T* data() const { return storage.data(); }
+  size_t getOffset() const { return oldest; }
+
+  double getSum() const { return mean * count; }
+  double getMean() const { return mean; }
+
+  // Sample variance (divided by size() - 1); 0 for fewer than two values
+  double getVariance() const {
+    return count > 1 ? std::max(0.0, m2) / (count - 1) : 0.0;
+  }
+
+ private:
+  void recompute() {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      sum += static_cast<double>(storage[i]);
+    }
+    mean = sum / count;
+
+    m2 = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      double delta = static_cast<double>(storage[i]) - mean;
+      m2 += delta * delta;
+    }
+  }
+
+  std::array<T, Capacity> storage{};
+  size_t count = 0;
+  size_t oldest = 0;  // Index of the oldest value once full
+  double mean = 0.0;
+  double m2 = 0.0;  // Sum of squared differences from the mean
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free queue from one producer thread to one consumer thread.
+//
+// The capacity is fixed by reset() and rounded up to a power of two, so
+// neither side ever allocates or blocks: a producer that finds the queue
+// full writes what fits and drops the rest. The two indices count values
+// ever written and read, and only their owners store to them; the
+// acquire/release pairs make the values between them visible to the other
+// side. Each index sits on its own cache line so the threads don't contend.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  SpscRingBuffer() = default;
+  explicit SpscRingBuffer(size_t capacity) { reset(capacity); }
+
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  // Empty the queue and resize it. Neither side may be in use.
+  void reset(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    storage.assign(rounded, T{});
+    mask = rounded - 1;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  // Producer: append up to `count` values, returning how many fit
+  size_t write(const T* values, size_t count) {
+    const size_t writeIndex = head.load(std::memory_order_relaxed);
+    const size_t readIndex = tail.load(std::memory_order_acquire);
+    count = std::min(count, storage.size() - (writeIndex - readIndex));
+
+    for (size_t i = 0; i < count; ++i) {
+      storage[(writeIndex + i) & mask] = values[i];
+    }
+    head.store(writeIndex + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer: take up to `count` of the oldest values, returning how many
+  // were read
+  size_t read(T* out, size_t count) {
+    const size_t readIndex = tail.load(std::memory_order_relaxed);
+    const size_t writeIndex = head.load(std::memory_order_acquire);
+    count = std::min(count, writeIndex - readIndex);
+
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = storage[(readIndex + i) & mask];
+    }
+    tail.store(readIndex + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer: drop up to `count` of the oldest values unread
+  size_t discard(size_t count) {
+    const size_t readIndex = tail.load(std::memory_order_relaxed);
+    const size_t writeIndex = head.load(std::memory_order_acquire);
+    count = std::min(count, writeIndex - readIndex);
+    tail.store(readIndex + count, std::memory_order_release);
+    return count;
+  }
+
+  // Values queued, as of the call; the producer may have added more since
+  size_t size() const {
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return storage.size(); }
+
+ private:
+  std::vector<T> storage;
+  size_t mask = 0;
+  alignas(64) std::atomic<size_t> head{0};  // Values written; producer's
+  alignas(64) std::atomic<size_t> tail{0};  // Values read; consumer's
+};
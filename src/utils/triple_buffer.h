@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer triple buffer.
+//
+// The writer fills the back slot and publishes it; the reader picks up the
+// most recently published slot. Neither side ever waits on the other: both
+// operations are a single atomic exchange. Intermediate snapshots may be
+// skipped if the writer publishes faster than the reader acquires.
+template <typename T>
+class TripleBuffer {
+ public:
+  // Writer side: the slot to fill before publish(). It holds stale data
+  // from an earlier publish and must be fully overwritten.
+  T& getWriteBuffer() { return slots[backIndex]; }
+
+  // Writer side: make the write buffer the latest snapshot
+  void publish() {
+    uint8_t previous =
+        middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+    backIndex = previous & INDEX_MASK;
+  }
+
+  // Reader side: switch to the latest snapshot, if a new one was published
+  // since the last call. Returns true if the read buffer changed.
+  bool acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+
+    uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+    frontIndex = previous & INDEX_MASK;
+    return true;
+  }
+
+  // Reader side: the snapshot picked up by the last acquire()
+  const T& getReadBuffer() const { return slots[frontIndex]; }
+
+ private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH_BIT = 0x4;
+
+  std::array<T, 3> slots{};
+
+  // Index of the slot between writer and reader, plus FRESH_BIT if it holds
+  // a snapshot the reader has not seen yet
+  alignas(64) std::atomic<uint8_t> middle{1};
+
+  // Owned by the writer and reader respectively
+  alignas(64) uint8_t backIndex = 0;
+  alignas(64) uint8_t frontIndex = 2;
+};